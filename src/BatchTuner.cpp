@@ -0,0 +1,99 @@
+#include "BatchTuner.h"
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+#define PRINT_INDENT 19
+
+BatchTuner::BatchTuner(unique_ptr<Optimizer> optimizer, Evaluator evaluator, unsigned int threads)
+    : optimizer(move(optimizer)), evaluator(evaluator), pool(threads) {
+  this->evaluations = 0;
+  this->batches = 0;
+  this->max_batch_size = 0;
+}
+
+BatchTuner::~BatchTuner() {}
+
+vector<double> BatchTuner::BestParams() { return optimizer->BestParams(); }
+
+double BatchTuner::BestError() { return optimizer->BestError(); }
+
+bool BatchTuner::IsTuned() { return optimizer->Converged(); }
+
+unsigned int BatchTuner::Evaluations() { return evaluations; }
+
+unsigned int BatchTuner::Batches() { return batches; }
+
+unsigned int BatchTuner::MaxBatchSize() { return max_batch_size; }
+
+vector<double> BatchTuner::Tune(unsigned int max_batches) {
+  while (!IsTuned() && batches < max_batches) {
+    if (!Batch()) {
+      break;
+    }
+  }
+
+  if (IsTuned()) {
+    cout << "Tuning finished, best error: " << optimizer->BestError() << endl;
+  } else if (batches >= max_batches) {
+    cout << "Tuning stopped after " << batches << " batches (not converged), best error: " << optimizer->BestError()
+         << endl;
+  } else {
+    cout << "Tuning stopped, no candidates left (not converged), best error: " << optimizer->BestError() << endl;
+  }
+
+  return optimizer->BestParams();
+}
+
+bool BatchTuner::Batch() {
+  vector<Candidate> candidates;
+  Candidate candidate;
+
+  while (optimizer->Propose(candidate)) {
+    candidates.push_back(candidate);
+  }
+
+  if (candidates.empty()) {
+    return false;
+  }
+
+  auto start = chrono::steady_clock::now();
+
+  vector<future<double>> results;
+
+  for (const Candidate &proposed : candidates) {
+    Evaluator &evaluate = evaluator;
+    vector<double> params = proposed.params;
+    double fidelity = proposed.fidelity;
+    results.push_back(pool.Submit([&evaluate, params, fidelity]() { return evaluate(params, fidelity); }));
+  }
+
+  for (unsigned int c = 0; c < candidates.size(); ++c) {
+    optimizer->Report(candidates[c], results[c].get());
+  }
+
+  double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  evaluations += candidates.size();
+  max_batch_size = max(max_batch_size, static_cast<unsigned int>(candidates.size()));
+  ++batches;
+
+  vector<double> best_params = optimizer->BestParams();
+
+  cout << "Batch " << batches << " (" << candidates.size() << " candidates, " << elapsed << " s)" << endl;
+  cout << setw(PRINT_INDENT) << "Best error: " << optimizer->BestError() << endl;
+  cout << setw(PRINT_INDENT) << "Best params: ";
+  for (double param : best_params) {
+    cout << param << " ";
+  }
+  cout << endl;
+  vector<OptimizerValue> state;
+  optimizer->GetState(state);
+  cout << FormatOptimizerState(state);
+
+  return true;
+}
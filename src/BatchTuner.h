@@ -0,0 +1,63 @@
+#ifndef BATCH_TUNER_H
+#define BATCH_TUNER_H
+
+#include <memory>
+#include <vector>
+#include "Optimizer.h"
+#include "ThreadPool.h"
+
+/*
+ * Offline tuner that drives an optimizer evaluating its candidates concurrently. At each batch all the candidates
+ * that the optimizer can propose (a whole generation with CMA-ES, a single one with the sequential optimizers) are
+ * dispatched to the thread pool, and their errors are reported back in the order of the proposals, so that the
+ * results do not depend on the number of threads.
+ */
+class BatchTuner {
+ public:
+  /*
+   * @param optimizer The optimizer proposing the candidates
+   * @param evaluator The function used to evaluate the candidates
+   * @param threads The number of threads used for the evaluations
+   */
+  BatchTuner(std::unique_ptr<Optimizer> optimizer, Evaluator evaluator, unsigned int threads);
+
+  virtual ~BatchTuner();
+
+  /*
+   * Runs the tuning until convergence or until the given number of batches is reached (see IsTuned).
+   *
+   * @return The best parameters
+   */
+  std::vector<double> Tune(unsigned int max_batches);
+
+  std::vector<double> BestParams();
+
+  double BestError();
+
+  bool IsTuned();
+
+  unsigned int Evaluations();
+
+  unsigned int Batches();
+
+  /*
+   * Largest number of candidates evaluated in a batch.
+   */
+  unsigned int MaxBatchSize();
+
+ private:
+  std::unique_ptr<Optimizer> optimizer;
+  Evaluator evaluator;
+  ThreadPool pool;
+
+  unsigned int evaluations;
+  unsigned int batches;
+  unsigned int max_batch_size;
+
+  /*
+   * @return False if the optimizer proposed no candidate
+   */
+  bool Batch();
+};
+
+#endif /* BATCH_TUNER_H */
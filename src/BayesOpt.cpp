@@ -0,0 +1,351 @@
+#include "BayesOpt.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+// Half width of the initial search box and its growth, log2 of the factors applied to the initial parameters
+#define SEARCH_RANGE 3.0
+#define BOX_GROWTH 1.0
+// Length scale of the kernel (log2 units)
+#define LENGTH_SCALE 1.2
+// Candidates of the acquisition maximization: uniform on the box and local around the incumbent
+#define ACQUISITION_SAMPLES 1000
+#define LOCAL_SAMPLES 200
+#define LOCAL_STEP 0.2
+
+BayesOpt::BayesOpt(const vector<double> &params, double noise, double tolerance, unsigned int budget,
+                   unsigned int seed)
+    : random(seed) {
+  this->origin = params;
+  for (unsigned int i = 0; i < params.size(); ++i) {
+    if (params[i] != 0) {
+      dims.push_back(i);
+    }
+  }
+
+  lower.assign(dims.size(), -SEARCH_RANGE);
+  upper.assign(dims.size(), SEARCH_RANGE);
+
+  this->prior_mean = 0.0;
+  this->signal_variance = 1.0;
+  this->pending = false;
+  this->next_id = 0;
+  this->proposal_time = 0.0;
+  this->best_params = params;
+  this->best_err = numeric_limits<double>::max();
+  this->noise = noise;
+  this->tolerance = tolerance;
+  this->budget = budget;
+
+  NextPoint();
+}
+
+BayesOpt::~BayesOpt() {}
+
+bool BayesOpt::Propose(Candidate &candidate) {
+  if (pending) {
+    return false;
+  }
+  pending = true;
+  candidate.id = next_id++;
+  candidate.params = ToParams(point);
+  candidate.fidelity = 1.0;
+  return true;
+}
+
+void BayesOpt::Report(const Candidate &candidate, double error) {
+  if (!pending || candidate.id + 1 != next_id) {
+    return;
+  }
+
+  pending = false;
+
+  if (error < best_err) {
+    best_err = error;
+    best_params = candidate.params;
+  }
+
+  auto start = chrono::steady_clock::now();
+
+  AddPoint(point, log(fmax(error, 1e-12)));
+  Fit();
+  NextPoint();
+
+  proposal_time = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+void BayesOpt::AddPoint(const vector<double> &x, double value) {
+  // Appends a row to the Cholesky factor: L * l = k, d = sqrt(k(x, x) + noise - l * l)
+  vector<double> row(points.size());
+  for (unsigned int i = 0; i < points.size(); ++i) {
+    row[i] = Kernel(points[i], x);
+  }
+  SolveLower(row);
+
+  double diagonal = 1.0 + noise;
+  for (double l : row) {
+    diagonal -= l * l;
+  }
+  row.push_back(sqrt(fmax(diagonal, 1e-12)));
+
+  cholesky.push_back(row);
+  points.push_back(x);
+  values.push_back(value);
+}
+
+void BayesOpt::Fit() {
+  size_t n = values.size();
+
+  prior_mean = 0.0;
+  for (double value : values) {
+    prior_mean += value / n;
+  }
+
+  vector<double> residuals(n);
+  for (unsigned int i = 0; i < n; ++i) {
+    residuals[i] = values[i] - prior_mean;
+  }
+  SolveLower(residuals);
+
+  // Maximum likelihood signal variance given the kernel
+  double sum = 0.0;
+  for (double r : residuals) {
+    sum += r * r;
+  }
+  signal_variance = fmax(sum / n, 1e-6);
+
+  // L^T * alpha = L^-1 * residuals
+  alpha = residuals;
+  for (int i = n - 1; i >= 0; --i) {
+    for (unsigned int j = i + 1; j < n; ++j) {
+      alpha[i] -= cholesky[j][i] * alpha[j];
+    }
+    alpha[i] /= cholesky[i][i];
+  }
+}
+
+unsigned int BayesOpt::InitialPoints() { return 1 + 2 * dims.size(); }
+
+void BayesOpt::NextPoint() {
+  static const unsigned int PRIMES[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29};
+
+  size_t m = dims.size();
+  size_t n = points.size();
+
+  expected_improvement = numeric_limits<double>::max();
+
+  if (n == 0) {
+    point.assign(m, 0.0);
+    return;
+  }
+
+  if (n < InitialPoints()) {
+    // Halton sequence
+    point.resize(m);
+    for (unsigned int d = 0; d < m; ++d) {
+      unsigned int base = PRIMES[d % 10];
+      double f = 1.0;
+      double h = 0.0;
+      for (unsigned int i = n; i > 0; i /= base) {
+        f /= base;
+        h += f * (i % base);
+      }
+      point[d] = lower[d] + h * (upper[d] - lower[d]);
+    }
+    return;
+  }
+
+  // The incumbent is the best posterior mean of the evaluated points, robust to the noise of the errors
+  unsigned int incumbent = 0;
+  double incumbent_mean = numeric_limits<double>::max();
+  for (unsigned int i = 0; i < n; ++i) {
+    double mean = values[i] - noise * alpha[i];
+    if (mean < incumbent_mean) {
+      incumbent_mean = mean;
+      incumbent = i;
+    }
+  }
+
+  // Grows the box when the incumbent gets close to its boundary
+  for (unsigned int d = 0; d < m; ++d) {
+    if (points[incumbent][d] > upper[d] - LENGTH_SCALE) {
+      upper[d] += BOX_GROWTH;
+    }
+    if (points[incumbent][d] < lower[d] + LENGTH_SCALE) {
+      lower[d] -= BOX_GROWTH;
+    }
+  }
+
+  uniform_real_distribution<double> uniform(0.0, 1.0);
+  normal_distribution<double> local(0.0, LOCAL_STEP);
+  vector<double> x(m);
+
+  expected_improvement = -1.0;
+
+  for (unsigned int s = 0; s < ACQUISITION_SAMPLES + LOCAL_SAMPLES; ++s) {
+    for (unsigned int d = 0; d < m; ++d) {
+      if (s < ACQUISITION_SAMPLES) {
+        x[d] = lower[d] + uniform(random) * (upper[d] - lower[d]);
+      } else {
+        x[d] = fmin(upper[d], fmax(lower[d], points[incumbent][d] + local(random)));
+      }
+    }
+    double ei = ExpectedImprovement(x, incumbent_mean);
+    if (ei > expected_improvement) {
+      expected_improvement = ei;
+      point = x;
+    }
+  }
+}
+
+double BayesOpt::Kernel(const vector<double> &a, const vector<double> &b) {
+  // Matern 5/2
+  double distance = 0.0;
+  for (unsigned int d = 0; d < a.size(); ++d) {
+    distance += (a[d] - b[d]) * (a[d] - b[d]);
+  }
+  double r = sqrt(5.0 * distance) / LENGTH_SCALE;
+  return (1 + r + r * r / 3) * exp(-r);
+}
+
+void BayesOpt::Predict(const vector<double> &x, double &mean, double &variance) {
+  vector<double> k(points.size());
+  for (unsigned int i = 0; i < points.size(); ++i) {
+    k[i] = Kernel(points[i], x);
+  }
+
+  mean = prior_mean;
+  for (unsigned int i = 0; i < k.size(); ++i) {
+    mean += k[i] * alpha[i];
+  }
+
+  SolveLower(k);
+  double explained = 0.0;
+  for (double v : k) {
+    explained += v * v;
+  }
+  variance = signal_variance * fmax(1.0 - explained, 0.0);
+}
+
+double BayesOpt::ExpectedImprovement(const vector<double> &x, double incumbent) {
+  double mean;
+  double variance;
+  Predict(x, mean, variance);
+
+  double sd = sqrt(variance);
+  double improvement = incumbent - mean;
+  if (sd < 1e-12) {
+    return fmax(improvement, 0.0);
+  }
+  double z = improvement / sd;
+  double cdf = 0.5 * erfc(-z / sqrt(2.0));
+  double pdf = exp(-0.5 * z * z) / sqrt(2 * M_PI);
+  return improvement * cdf + sd * pdf;
+}
+
+void BayesOpt::SolveLower(vector<double> &x) {
+  for (unsigned int i = 0; i < x.size(); ++i) {
+    for (unsigned int j = 0; j < i; ++j) {
+      x[i] -= cholesky[i][j] * x[j];
+    }
+    x[i] /= cholesky[i][i];
+  }
+}
+
+vector<double> BayesOpt::ToParams(const vector<double> &x) {
+  vector<double> params = origin;
+  for (unsigned int d = 0; d < dims.size(); ++d) {
+    params[dims[d]] = origin[dims[d]] * exp2(x[d]);
+  }
+  return params;
+}
+
+bool BayesOpt::Converged() {
+  return dims.empty() || expected_improvement <= tolerance || (budget > 0 && points.size() >= budget);
+}
+
+vector<double> BayesOpt::BestParams() { return best_params; }
+
+double BayesOpt::BestError() { return best_err; }
+
+void BayesOpt::Save(vector<double> &state) {
+  state.clear();
+  state.push_back(best_err);
+  state.insert(state.end(), best_params.begin(), best_params.end());
+  state.insert(state.end(), lower.begin(), lower.end());
+  state.insert(state.end(), upper.begin(), upper.end());
+  state.push_back(points.size());
+  for (const vector<double> &x : points) {
+    state.insert(state.end(), x.begin(), x.end());
+  }
+  state.insert(state.end(), values.begin(), values.end());
+}
+
+bool BayesOpt::Restore(const vector<double> &state) {
+  size_t n = origin.size();
+  size_t m = dims.size();
+
+  if (state.size() < 2 + n + 2 * m) {
+    return false;
+  }
+
+  double saved_count = state[1 + n + 2 * m];
+  size_t count = static_cast<size_t>(saved_count);
+
+  if (saved_count < 0 || state.size() != 2 + n + 2 * m + count * (m + 1)) {
+    return false;
+  }
+
+  const double *p = state.data();
+
+  best_err = *p++;
+  for (unsigned int i = 0; i < n; ++i) {
+    best_params[i] = *p++;
+  }
+  for (unsigned int d = 0; d < m; ++d) {
+    lower[d] = *p++;
+  }
+  for (unsigned int d = 0; d < m; ++d) {
+    upper[d] = *p++;
+  }
+  ++p;
+
+  vector<vector<double>> saved_points(count, vector<double>(m));
+  for (vector<double> &x : saved_points) {
+    for (unsigned int d = 0; d < m; ++d) {
+      x[d] = *p++;
+    }
+  }
+
+  points.clear();
+  values.clear();
+  cholesky.clear();
+  for (unsigned int i = 0; i < count; ++i) {
+    AddPoint(saved_points[i], *p++);
+  }
+  if (count > 0) {
+    Fit();
+  }
+  pending = false;
+  NextPoint();
+
+  return true;
+}
+
+void BayesOpt::GetState(vector<OptimizerValue> &state) {
+  state.resize(points.size() >= InitialPoints() ? 3 : 2);
+  state[0].name = "Surrogate points";
+  state[0].values.assign(1, points.size());
+  state[1].name = "Proposal (ms)";
+  state[1].values.assign(1, proposal_time);
+  if (state.size() > 2) {
+    state[2].name = "Expected improv.";
+    state[2].values.assign(1, expected_improvement);
+  }
+  for (OptimizerValue &value : state) {
+    value.text.clear();
+  }
+}
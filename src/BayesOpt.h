@@ -0,0 +1,100 @@
+#ifndef BAYES_OPT_H
+#define BAYES_OPT_H
+
+#include <random>
+#include <vector>
+#include "Optimizer.h"
+
+/*
+ * Bayesian optimization: a Gaussian process surrogate of the log of the cycle error is fitted to all the evaluated
+ * candidates, and the next candidate is the one maximizing the expected improvement over the surrogate. Meant for
+ * the evaluations that cost minutes (cycles on the Udacity simulator), it needs far fewer of them than twiddle.
+ *
+ * The search space is a box of the parameters relative to the initial ones on a log scale, initially from 1/8 to 8
+ * times each initial parameter and extended whenever the best candidate gets close to its boundary. The first
+ * candidates are the initial parameters and a low discrepancy design. The kernel is a
+ * Matern 5/2 with a fixed length scale and a noise term, so that repeated or noisy evaluations of close coefficients
+ * are averaged rather than interpolated, and the improvement is measured from the best posterior mean rather than
+ * from the best (possibly lucky) error. Since the kernel does not depend on the errors, the Cholesky factor of the
+ * covariance is extended by one row at each evaluation (O(n^2)) instead of being refactored, and only the signal
+ * variance is refitted. Converges when the expected improvement falls below the tolerance (in log error), or when
+ * the budget of evaluations is exhausted. A single candidate is evaluated at a time.
+ */
+class BayesOpt : public Optimizer {
+ public:
+  /*
+   * @param params The initial parameters
+   * @param noise Variance of the evaluation noise relative to the signal variance
+   * @param tolerance Expected improvement (of the log of the error) at convergence
+   * @param budget Max number of evaluations, 0 for no limit
+   * @param seed Seed of the search of the acquisition maximum
+   */
+  BayesOpt(const std::vector<double> &params, double noise, double tolerance, unsigned int budget,
+           unsigned int seed);
+
+  virtual ~BayesOpt();
+
+  bool Propose(Candidate &candidate);
+
+  void Report(const Candidate &candidate, double error);
+
+  bool Converged();
+
+  std::vector<double> BestParams();
+
+  double BestError();
+
+  void Save(std::vector<double> &state);
+
+  bool Restore(const std::vector<double> &state);
+
+  void GetState(std::vector<OptimizerValue> &state);
+
+ private:
+  // Initial parameters, the center of the search box
+  std::vector<double> origin;
+  // Indexes of the parameters that are tuned
+  std::vector<unsigned int> dims;
+
+  // Search box, log2 of the factors applied to the initial parameters
+  std::vector<double> lower;
+  std::vector<double> upper;
+
+  // Evaluated points (log2 of the factors) and the log of their errors
+  std::vector<std::vector<double>> points;
+  std::vector<double> values;
+  // Lower triangular Cholesky factor of the kernel matrix, row i has i + 1 elements
+  std::vector<std::vector<double>> cholesky;
+  // K^-1 * (values - mean) and the fitted prior
+  std::vector<double> alpha;
+  double prior_mean;
+  double signal_variance;
+
+  // Point being evaluated and its expected improvement
+  std::vector<double> point;
+  double expected_improvement;
+  bool pending;
+  unsigned int next_id;
+  // Time taken by the last proposal (ms)
+  double proposal_time;
+
+  std::mt19937 random;
+
+  std::vector<double> best_params;
+  double best_err;
+  double noise;
+  double tolerance;
+  unsigned int budget;
+
+  void AddPoint(const std::vector<double> &point, double value);
+  void Fit();
+  void NextPoint();
+  double Kernel(const std::vector<double> &a, const std::vector<double> &b);
+  void Predict(const std::vector<double> &x, double &mean, double &variance);
+  double ExpectedImprovement(const std::vector<double> &x, double incumbent);
+  void SolveLower(std::vector<double> &x);
+  unsigned int InitialPoints();
+  std::vector<double> ToParams(const std::vector<double> &point);
+};
+
+#endif /* BAYES_OPT_H */
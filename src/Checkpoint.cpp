@@ -0,0 +1,255 @@
+#include "Checkpoint.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include "Hash.h"
+
+using namespace std;
+
+template <typename T>
+static void append(vector<char> &out, const T *data, size_t count) {
+  const char *bytes = reinterpret_cast<const char *>(data);
+  out.insert(out.end(), bytes, bytes + count * sizeof(T));
+}
+
+template <typename T>
+static void read_values(const char *&p, T *data, size_t count) {
+  memcpy(data, p, count * sizeof(T));
+  p += count * sizeof(T);
+}
+
+void EncodeCheckpoint(const TunerCheckpoint &checkpoint, vector<char> &out) {
+  CheckpointHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+  header.version = CHECKPOINT_VERSION;
+  header.count = checkpoint.best_params.size();
+  header.state_size = checkpoint.state.size();
+  header.optimizer = static_cast<uint32_t>(checkpoint.optimizer);
+  header.cycle = checkpoint.cycle;
+  header.max_steps = checkpoint.max_steps;
+  header.best_err = checkpoint.best_err;
+  header.steps_saved = checkpoint.steps_saved;
+  header.total_warmup = checkpoint.total_warmup;
+  header.aborted_cycles = checkpoint.aborted_cycles;
+  header.warmup_cycles = checkpoint.warmup_cycles;
+
+  out.clear();
+  append(out, &header, 1);
+  append(out, checkpoint.best_params.data(), header.count);
+  append(out, checkpoint.state.data(), header.state_size);
+
+  uint64_t hash = Fnv1a(out.data(), out.size());
+  append(out, &hash, 1);
+}
+
+bool DecodeCheckpoint(const char *data, size_t length, TunerCheckpoint &checkpoint) {
+  CheckpointHeader header;
+
+  if (length < sizeof(header) + sizeof(uint64_t)) {
+    return false;
+  }
+
+  memcpy(&header, data, sizeof(header));
+
+  if (memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 || header.version != CHECKPOINT_VERSION) {
+    return false;
+  }
+
+  size_t content_length = sizeof(header) + (static_cast<size_t>(header.count) + header.state_size) * sizeof(double);
+
+  if (header.count == 0 || length != content_length + sizeof(uint64_t)) {
+    return false;
+  }
+
+  uint64_t hash;
+  memcpy(&hash, data + content_length, sizeof(hash));
+
+  if (hash != Fnv1a(data, content_length)) {
+    return false;
+  }
+
+  const char *p = data + sizeof(header);
+
+  checkpoint.best_params.resize(header.count);
+  checkpoint.state.resize(header.state_size);
+  read_values(p, checkpoint.best_params.data(), header.count);
+  read_values(p, checkpoint.state.data(), header.state_size);
+
+  checkpoint.optimizer = static_cast<OptimizerType>(header.optimizer);
+  checkpoint.cycle = header.cycle;
+  checkpoint.max_steps = header.max_steps;
+  checkpoint.best_err = header.best_err;
+  checkpoint.steps_saved = header.steps_saved;
+  checkpoint.total_warmup = header.total_warmup;
+  checkpoint.aborted_cycles = header.aborted_cycles;
+  checkpoint.warmup_cycles = header.warmup_cycles;
+
+  return true;
+}
+
+bool ReadCheckpoint(const string &file_name, TunerCheckpoint &checkpoint) {
+  FILE *file = fopen(file_name.c_str(), "rb");
+
+  if (file == nullptr) {
+    return false;
+  }
+
+  vector<char> data;
+  char buffer[4096];
+  size_t read;
+
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    data.insert(data.end(), buffer, buffer + read);
+  }
+
+  bool failed = ferror(file) != 0;
+  fclose(file);
+
+  return !failed && DecodeCheckpoint(data.data(), data.size(), checkpoint);
+}
+
+CheckpointWriter::CheckpointWriter() {
+  this->has_pending = false;
+  this->has_latest = false;
+  this->stop = false;
+  this->running = false;
+  this->written = 0;
+}
+
+CheckpointWriter::~CheckpointWriter() { Close(); }
+
+void CheckpointWriter::Open(const string &file_name) {
+  if (IsOpen()) {
+    return;
+  }
+
+  this->file_name = file_name;
+  this->temp_name = file_name + ".tmp";
+
+  has_pending = false;
+  has_latest = false;
+  stop = false;
+  written = 0;
+  running = true;
+  writer = thread(&CheckpointWriter::Run, this);
+}
+
+void CheckpointWriter::Close() {
+  if (!IsOpen()) {
+    return;
+  }
+
+  {
+    lock_guard<mutex> lock(pending_mutex);
+    stop = true;
+  }
+
+  pending_signal.notify_one();
+  writer.join();
+  running = false;
+}
+
+bool CheckpointWriter::IsOpen() { return running; }
+
+void CheckpointWriter::Write(const TunerCheckpoint &checkpoint) {
+  {
+    lock_guard<mutex> lock(pending_mutex);
+    pending = checkpoint;
+    has_pending = true;
+    latest = checkpoint;
+    has_latest = true;
+  }
+  pending_signal.notify_one();
+}
+
+bool CheckpointWriter::Latest(TunerCheckpoint &checkpoint) {
+  lock_guard<mutex> lock(pending_mutex);
+  if (!has_latest) {
+    return false;
+  }
+  checkpoint = latest;
+  return true;
+}
+
+uint64_t CheckpointWriter::Written() {
+  lock_guard<mutex> lock(pending_mutex);
+  return written;
+}
+
+void CheckpointWriter::Run() {
+  TunerCheckpoint checkpoint;
+  vector<char> data;
+
+  while (true) {
+    {
+      unique_lock<mutex> lock(pending_mutex);
+      pending_signal.wait(lock, [this] { return has_pending || stop; });
+      if (!has_pending) {
+        break;
+      }
+      // Swaps the storage so that the event loop keeps reusing the buffers of the previous checkpoint
+      swap(checkpoint, pending);
+      has_pending = false;
+    }
+
+    EncodeCheckpoint(checkpoint, data);
+
+    if (WriteFile(data)) {
+      lock_guard<mutex> lock(pending_mutex);
+      ++written;
+    }
+  }
+}
+
+bool CheckpointWriter::WriteFile(const vector<char> &data) {
+  int fd = open(temp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+  if (fd < 0) {
+    cerr << "[Error]: Could not write checkpoint " << temp_name << ": " << strerror(errno) << endl;
+    return false;
+  }
+
+  const char *p = data.data();
+  size_t length = data.size();
+
+  while (length > 0) {
+    ssize_t result = ::write(fd, p, length);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    p += result;
+    length -= result;
+  }
+
+  // The content must be on disk before the rename, otherwise a crash could leave an empty checkpoint
+  bool synced = length == 0 && fsync(fd) == 0;
+
+  close(fd);
+
+  if (!synced || rename(temp_name.c_str(), file_name.c_str()) != 0) {
+    cerr << "[Error]: Could not write checkpoint " << file_name << ": " << strerror(errno) << endl;
+    unlink(temp_name.c_str());
+    return false;
+  }
+
+  // Makes the rename itself durable
+  size_t separator = file_name.rfind('/');
+  string directory = separator == string::npos ? "." : file_name.substr(0, max<size_t>(1, separator));
+  int dir_fd = open(directory.c_str(), O_RDONLY);
+
+  if (dir_fd >= 0) {
+    fsync(dir_fd);
+    close(dir_fd);
+  }
+
+  return true;
+}
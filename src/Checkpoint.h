@@ -0,0 +1,137 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Tuner.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "The checkpoint format is only supported on little-endian platforms"
+#endif
+
+const char CHECKPOINT_MAGIC[8] = {'P', 'I', 'D', 'C', 'K', 'P', 'T', '\0'};
+const uint32_t CHECKPOINT_VERSION = 2;
+
+/*
+ * Header of the checkpoint file. The header is followed by the best params (count doubles), by the state of the
+ * optimizer (state_size doubles) and by the FNV-1a hash (uint64) of all the preceding bytes.
+ */
+struct CheckpointHeader {
+  char magic[8];
+  uint32_t version;
+  // Number of parameters
+  uint32_t count;
+  uint32_t state_size;
+  // OptimizerType
+  uint32_t optimizer;
+  uint32_t cycle;
+  uint32_t max_steps;
+  double best_err;
+  uint64_t steps_saved;
+  uint64_t total_warmup;
+  uint32_t aborted_cycles;
+  uint32_t warmup_cycles;
+};
+
+/*
+ * Encodes the checkpoint in the binary format.
+ *
+ * @param checkpoint The tuner state
+ * @param out The buffer the checkpoint is written to, cleared first
+ */
+void EncodeCheckpoint(const TunerCheckpoint &checkpoint, std::vector<char> &out);
+
+/*
+ * Decodes a checkpoint in the binary format.
+ *
+ * @param data The encoded checkpoint
+ * @param length The length of the encoded checkpoint
+ * @param checkpoint Output tuner state, set only if the function returns true
+ *
+ * @return False if the data is not a valid checkpoint (e.g. truncated or corrupted)
+ */
+bool DecodeCheckpoint(const char *data, size_t length, TunerCheckpoint &checkpoint);
+
+/*
+ * Reads the checkpoint stored in the given file.
+ *
+ * @return False if the file could not be read or is not a valid checkpoint
+ */
+bool ReadCheckpoint(const std::string &file_name, TunerCheckpoint &checkpoint);
+
+/*
+ * Writes the tuner checkpoints from a background thread, so that the event loop never waits for the disk. Each
+ * checkpoint is written atomically: the content is written to a temporary file and synced to disk before replacing
+ * the previous checkpoint (rename), a crash at any time leaves either the previous or the new checkpoint. Only the
+ * latest checkpoint is kept when the writer falls behind.
+ */
+class CheckpointWriter {
+ public:
+  CheckpointWriter();
+
+  /*
+   * Destructor, closes the writer if still open.
+   */
+  virtual ~CheckpointWriter();
+
+  /*
+   * Starts the writer thread.
+   *
+   * @param file_name The name of the checkpoint file
+   */
+  void Open(const std::string &file_name);
+
+  /*
+   * Stops the writer thread, writing the pending checkpoint if any.
+   */
+  void Close();
+
+  bool IsOpen();
+
+  /*
+   * Queues the checkpoint for writing, replacing the one still pending if any. The caller only waits for the copy
+   * of the checkpoint (the storage is reused, no allocation after the first checkpoint).
+   */
+  void Write(const TunerCheckpoint &checkpoint);
+
+  /*
+   * The latest checkpoint queued since the writer was opened (written or still pending), can be called from any
+   * thread.
+   *
+   * @param checkpoint Output tuner state, set only if the function returns true
+   *
+   * @return False if no checkpoint was queued
+   */
+  bool Latest(TunerCheckpoint &checkpoint);
+
+  /*
+   * Number of checkpoints written since the writer was opened.
+   */
+  uint64_t Written();
+
+ private:
+  std::string file_name;
+  std::string temp_name;
+
+  std::thread writer;
+  std::mutex pending_mutex;
+  std::condition_variable pending_signal;
+  TunerCheckpoint pending;
+  bool has_pending;
+  // Copy of the last queued checkpoint, the pending one is moved to the writer thread
+  TunerCheckpoint latest;
+  bool has_latest;
+  bool stop;
+  bool running;
+
+  uint64_t written;
+
+  void Run();
+  bool WriteFile(const std::vector<char> &data);
+};
+
+#endif /* CHECKPOINT_H */
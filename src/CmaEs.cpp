@@ -0,0 +1,350 @@
+#include "CmaEs.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+using namespace std;
+
+// Initial standard deviation (relative to the initial parameters)
+#define INITIAL_SIGMA 0.2
+// Smallest default population, so that a generation keeps the cores of a machine busy
+#define MIN_POPULATION 8
+// Sweeps of the Jacobi eigenvalue iteration
+#define MAX_SWEEPS 50
+
+CmaEs::CmaEs(const vector<double> &params, unsigned int population, double tolerance, unsigned int seed)
+    : random(seed) {
+  this->origin = params;
+  for (unsigned int i = 0; i < params.size(); ++i) {
+    if (params[i] != 0) {
+      dims.push_back(i);
+    }
+  }
+
+  size_t m = dims.size();
+
+  if (population == 0) {
+    population = m > 0 ? 4 + static_cast<unsigned int>(3 * log(static_cast<double>(m))) : 1;
+    population = max<unsigned int>(population, MIN_POPULATION);
+  }
+  population = max(population, 2u);
+
+  // Log-linear weights of the best half
+  size_t mu = population / 2;
+  weights.resize(mu);
+  for (unsigned int i = 0; i < mu; ++i) {
+    weights[i] = log(mu + 0.5) - log(i + 1.0);
+  }
+  double sum = accumulate(weights.begin(), weights.end(), 0.0);
+  double sum_sq = 0.0;
+  for (double &weight : weights) {
+    weight /= sum;
+    sum_sq += weight * weight;
+  }
+  mu_eff = 1.0 / sum_sq;
+
+  double n = fmax(1.0, static_cast<double>(m));
+  c_c = (4 + mu_eff / n) / (n + 4 + 2 * mu_eff / n);
+  c_sigma = (mu_eff + 2) / (n + mu_eff + 5);
+  c_1 = 2 / ((n + 1.3) * (n + 1.3) + mu_eff);
+  c_mu = fmin(1 - c_1, 2 * (mu_eff - 2 + 1 / mu_eff) / ((n + 2) * (n + 2) + mu_eff));
+  damping = 1 + 2 * fmax(0.0, sqrt((mu_eff - 1) / (n + 1)) - 1) + c_sigma;
+  chi_n = sqrt(n) * (1 - 1 / (4 * n) + 1 / (21 * n * n));
+
+  mean.assign(m, 1.0);
+  sigma = INITIAL_SIGMA;
+  covariance.assign(m, vector<double>(m, 0.0));
+  for (unsigned int d = 0; d < m; ++d) {
+    covariance[d][d] = 1.0;
+  }
+  path_c.assign(m, 0.0);
+  path_sigma.assign(m, 0.0);
+
+  points.assign(population, vector<double>(m, 1.0));
+  errors.assign(population, numeric_limits<double>::max());
+  reported.assign(population, false);
+  first_id = 0;
+  generation = 0;
+
+  this->best_params = params;
+  this->best_err = numeric_limits<double>::max();
+  this->tolerance = tolerance;
+
+  Decompose();
+  Sample();
+}
+
+CmaEs::~CmaEs() {}
+
+unsigned int CmaEs::Population() { return points.size(); }
+
+bool CmaEs::Propose(Candidate &candidate) {
+  if (proposed == points.size()) {
+    // Waits for the rest of the generation
+    return false;
+  }
+  candidate.id = first_id + proposed;
+  candidate.params = ToParams(points[proposed]);
+  candidate.fidelity = 1.0;
+  ++proposed;
+  return true;
+}
+
+void CmaEs::Report(const Candidate &candidate, double error) {
+  if (candidate.id < first_id || candidate.id >= first_id + proposed || reported[candidate.id - first_id]) {
+    return;
+  }
+
+  unsigned int k = candidate.id - first_id;
+  reported[k] = true;
+  errors[k] = error;
+  ++reported_count;
+
+  if (error < best_err) {
+    best_err = error;
+    best_params = candidate.params;
+  }
+
+  if (reported_count == points.size()) {
+    Update();
+    first_id += points.size();
+    ++generation;
+    Sample();
+  }
+}
+
+void CmaEs::Sample() {
+  size_t m = dims.size();
+  vector<double> z(m);
+
+  for (vector<double> &point : points) {
+    for (double &value : z) {
+      value = normal(random);
+    }
+    // mean + sigma * B * D * z
+    for (unsigned int d = 0; d < m; ++d) {
+      double y = 0.0;
+      for (unsigned int k = 0; k < m; ++k) {
+        y += axes[d][k] * scales[k] * z[k];
+      }
+      point[d] = mean[d] + sigma * y;
+    }
+  }
+
+  fill(errors.begin(), errors.end(), numeric_limits<double>::max());
+  fill(reported.begin(), reported.end(), false);
+  proposed = 0;
+  reported_count = 0;
+}
+
+void CmaEs::Update() {
+  size_t m = dims.size();
+  size_t mu = weights.size();
+
+  vector<unsigned int> order(points.size());
+  iota(order.begin(), order.end(), 0);
+  stable_sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) { return errors[a] < errors[b]; });
+
+  // Steps of the best half from the old mean, in units of sigma
+  vector<vector<double>> steps(mu, vector<double>(m));
+  vector<double> mean_step(m, 0.0);
+  for (unsigned int i = 0; i < mu; ++i) {
+    for (unsigned int d = 0; d < m; ++d) {
+      steps[i][d] = (points[order[i]][d] - mean[d]) / sigma;
+      mean_step[d] += weights[i] * steps[i][d];
+    }
+  }
+  for (unsigned int d = 0; d < m; ++d) {
+    mean[d] += sigma * mean_step[d];
+  }
+
+  // C^-1/2 * mean_step = B * D^-1 * B^T * mean_step
+  vector<double> projected(m, 0.0);
+  for (unsigned int k = 0; k < m; ++k) {
+    double dot = 0.0;
+    for (unsigned int d = 0; d < m; ++d) {
+      dot += axes[d][k] * mean_step[d];
+    }
+    dot /= scales[k];
+    for (unsigned int d = 0; d < m; ++d) {
+      projected[d] += axes[d][k] * dot;
+    }
+  }
+
+  double norm_sigma = 0.0;
+  for (unsigned int d = 0; d < m; ++d) {
+    path_sigma[d] = (1 - c_sigma) * path_sigma[d] + sqrt(c_sigma * (2 - c_sigma) * mu_eff) * projected[d];
+    norm_sigma += path_sigma[d] * path_sigma[d];
+  }
+  norm_sigma = sqrt(norm_sigma);
+
+  // Stalls the covariance path when the step size path is long (the step size is increasing fast)
+  double n = fmax(1.0, static_cast<double>(m));
+  bool h_sigma =
+      norm_sigma / sqrt(1 - pow(1 - c_sigma, 2.0 * (generation + 1))) / chi_n < 1.4 + 2 / (n + 1);
+
+  for (unsigned int d = 0; d < m; ++d) {
+    path_c[d] = (1 - c_c) * path_c[d] + (h_sigma ? sqrt(c_c * (2 - c_c) * mu_eff) * mean_step[d] : 0.0);
+  }
+
+  double correction = h_sigma ? 0.0 : c_c * (2 - c_c);
+  for (unsigned int r = 0; r < m; ++r) {
+    for (unsigned int c = 0; c < m; ++c) {
+      double rank_mu = 0.0;
+      for (unsigned int i = 0; i < mu; ++i) {
+        rank_mu += weights[i] * steps[i][r] * steps[i][c];
+      }
+      covariance[r][c] = (1 - c_1 - c_mu) * covariance[r][c] +
+                         c_1 * (path_c[r] * path_c[c] + correction * covariance[r][c]) + c_mu * rank_mu;
+    }
+  }
+
+  sigma *= exp((c_sigma / damping) * (norm_sigma / chi_n - 1));
+
+  Decompose();
+}
+
+void CmaEs::Decompose() {
+  // Jacobi eigenvalue iteration, the matrices are at most 3x3
+  size_t m = dims.size();
+  vector<vector<double>> a = covariance;
+
+  axes.assign(m, vector<double>(m, 0.0));
+  for (unsigned int d = 0; d < m; ++d) {
+    axes[d][d] = 1.0;
+  }
+
+  for (unsigned int sweep = 0; sweep < MAX_SWEEPS; ++sweep) {
+    double off = 0.0;
+    for (unsigned int p = 0; p < m; ++p) {
+      for (unsigned int q = p + 1; q < m; ++q) {
+        off += a[p][q] * a[p][q];
+      }
+    }
+    if (off < 1e-30) {
+      break;
+    }
+    for (unsigned int p = 0; p < m; ++p) {
+      for (unsigned int q = p + 1; q < m; ++q) {
+        if (a[p][q] == 0.0) {
+          continue;
+        }
+        double theta = 0.5 * atan2(2 * a[p][q], a[q][q] - a[p][p]);
+        double c = cos(theta);
+        double s = sin(theta);
+        for (unsigned int k = 0; k < m; ++k) {
+          double akp = a[k][p];
+          double akq = a[k][q];
+          a[k][p] = c * akp - s * akq;
+          a[k][q] = s * akp + c * akq;
+        }
+        for (unsigned int k = 0; k < m; ++k) {
+          double apk = a[p][k];
+          double aqk = a[q][k];
+          a[p][k] = c * apk - s * aqk;
+          a[q][k] = s * apk + c * aqk;
+        }
+        for (unsigned int k = 0; k < m; ++k) {
+          double vkp = axes[k][p];
+          double vkq = axes[k][q];
+          axes[k][p] = c * vkp - s * vkq;
+          axes[k][q] = s * vkp + c * vkq;
+        }
+      }
+    }
+  }
+
+  scales.resize(m);
+  for (unsigned int d = 0; d < m; ++d) {
+    // Guards against a covariance that lost its positive definiteness to rounding errors
+    scales[d] = sqrt(fmax(a[d][d], 1e-20));
+  }
+}
+
+vector<double> CmaEs::ToParams(const vector<double> &point) {
+  vector<double> params = origin;
+  for (unsigned int d = 0; d < dims.size(); ++d) {
+    params[dims[d]] = origin[dims[d]] * point[d];
+  }
+  return params;
+}
+
+bool CmaEs::Converged() {
+  if (dims.empty()) {
+    return true;
+  }
+  return generation > 0 && sigma * *max_element(scales.begin(), scales.end()) <= tolerance;
+}
+
+vector<double> CmaEs::BestParams() { return best_params; }
+
+double CmaEs::BestError() { return best_err; }
+
+void CmaEs::Save(vector<double> &state) {
+  state.clear();
+  state.push_back(generation);
+  state.push_back(sigma);
+  state.push_back(best_err);
+  state.insert(state.end(), best_params.begin(), best_params.end());
+  state.insert(state.end(), mean.begin(), mean.end());
+  state.insert(state.end(), path_c.begin(), path_c.end());
+  state.insert(state.end(), path_sigma.begin(), path_sigma.end());
+  for (const vector<double> &row : covariance) {
+    state.insert(state.end(), row.begin(), row.end());
+  }
+}
+
+bool CmaEs::Restore(const vector<double> &state) {
+  size_t n = origin.size();
+  size_t m = dims.size();
+
+  if (state.size() != 3 + n + 3 * m + m * m || state[0] < 0 || !(state[1] > 0)) {
+    return false;
+  }
+
+  const double *p = state.data();
+
+  generation = static_cast<unsigned int>(*p++);
+  sigma = *p++;
+  best_err = *p++;
+  for (unsigned int i = 0; i < n; ++i) {
+    best_params[i] = *p++;
+  }
+  for (unsigned int d = 0; d < m; ++d) {
+    mean[d] = *p++;
+  }
+  for (unsigned int d = 0; d < m; ++d) {
+    path_c[d] = *p++;
+  }
+  for (unsigned int d = 0; d < m; ++d) {
+    path_sigma[d] = *p++;
+  }
+  for (vector<double> &row : covariance) {
+    for (unsigned int d = 0; d < m; ++d) {
+      row[d] = *p++;
+    }
+  }
+
+  // The ids of the candidates proposed before the restore are not reused
+  first_id += points.size();
+  Decompose();
+  Sample();
+
+  return true;
+}
+
+void CmaEs::GetState(vector<OptimizerValue> &state) {
+  const char *NAMES[] = {"Generation", "Evaluated", "Population", "Step size"};
+  double values[] = {static_cast<double>(generation), static_cast<double>(reported_count),
+                     static_cast<double>(points.size()), sigma};
+  state.resize(5);
+  for (unsigned int i = 0; i < 4; ++i) {
+    state[i].name = NAMES[i];
+    state[i].values.assign(1, values[i]);
+    state[i].text.clear();
+  }
+  state[4].name = "Mean params";
+  state[4].values = ToParams(mean);
+  state[4].text.clear();
+}
@@ -0,0 +1,101 @@
+#ifndef CMA_ES_H
+#define CMA_ES_H
+
+#include <random>
+#include <vector>
+#include "Optimizer.h"
+
+/*
+ * Covariance Matrix Adaptation Evolution Strategy: each generation samples a population of candidates from a
+ * multivariate normal distribution, and the mean, the step size and the covariance of the distribution are moved
+ * towards the best half of the population (weighted recombination, rank-one and rank-mu updates with the default
+ * parameters of Hansen's tutorial). The covariance learns the orientation of narrow valleys of the error surface,
+ * which a coordinate descent can only follow with small steps. As Nelder-Mead, the search runs on the parameters
+ * relative to the initial ones. Converges when the standard deviation along the main axis of the distribution is
+ * below the relative tolerance.
+ *
+ * The whole generation can be proposed at once and evaluated concurrently, the distribution is updated when all of
+ * its candidates are reported. The state is saved at the start of the generation, a restore samples a new population.
+ */
+class CmaEs : public Optimizer {
+ public:
+  /*
+   * @param params The initial parameters, the mean of the first generation
+   * @param population Number of candidates of a generation, 0 uses the default size
+   * @param tolerance Relative standard deviation at convergence
+   * @param seed Seed of the sampling
+   */
+  CmaEs(const std::vector<double> &params, unsigned int population, double tolerance, unsigned int seed);
+
+  virtual ~CmaEs();
+
+  bool Propose(Candidate &candidate);
+
+  void Report(const Candidate &candidate, double error);
+
+  bool Converged();
+
+  std::vector<double> BestParams();
+
+  double BestError();
+
+  void Save(std::vector<double> &state);
+
+  bool Restore(const std::vector<double> &state);
+
+  void GetState(std::vector<OptimizerValue> &state);
+
+  unsigned int Population();
+
+ private:
+  // Initial parameters, the scale of the search
+  std::vector<double> origin;
+  // Indexes of the parameters that are tuned
+  std::vector<unsigned int> dims;
+
+  // Distribution (relative coordinates)
+  std::vector<double> mean;
+  double sigma;
+  std::vector<std::vector<double>> covariance;
+  // Eigen decomposition of the covariance: axes (columns) and standard deviations along them
+  std::vector<std::vector<double>> axes;
+  std::vector<double> scales;
+  // Evolution paths of the covariance and of the step size
+  std::vector<double> path_c;
+  std::vector<double> path_sigma;
+
+  // Recombination weights of the best half of the population
+  std::vector<double> weights;
+  double mu_eff;
+  // Learning rates
+  double c_c;
+  double c_sigma;
+  double c_1;
+  double c_mu;
+  double damping;
+  // Expected norm of a standard normal vector
+  double chi_n;
+
+  // Current generation: the sampled points, their errors and which ones were proposed and reported
+  std::vector<std::vector<double>> points;
+  std::vector<double> errors;
+  std::vector<bool> reported;
+  unsigned int proposed;
+  unsigned int reported_count;
+  unsigned int first_id;
+  unsigned int generation;
+
+  std::mt19937 random;
+  std::normal_distribution<double> normal;
+
+  std::vector<double> best_params;
+  double best_err;
+  double tolerance;
+
+  void Sample();
+  void Update();
+  void Decompose();
+  std::vector<double> ToParams(const std::vector<double> &point);
+};
+
+#endif /* CMA_ES_H */
@@ -0,0 +1,128 @@
+#include "ControlPipeline.h"
+
+using namespace std;
+
+// Time the control thread spins on an empty queue before sleeping, it covers the frames of the sessions arriving
+// in a burst without paying for a wake up each (only with more than one CPU, the spinning would otherwise delay the
+// I/O thread)
+#define SPIN_NS 50000
+
+ControlPipeline::ControlPipeline(size_t capacity)
+    : requests(capacity), replies(capacity), running(false), submitted(0), processed(0), wakeups(0), idle(false),
+      stop(false) {}
+
+ControlPipeline::~ControlPipeline() { Stop(); }
+
+void ControlPipeline::Start(const function<void()> &notify) {
+  if (running) {
+    return;
+  }
+
+  this->notify = notify;
+  stop = false;
+  running = true;
+  control = thread(&ControlPipeline::Run, this);
+}
+
+void ControlPipeline::Stop() {
+  if (!running) {
+    return;
+  }
+
+  stop = true;
+  Wake();
+  control.join();
+  running = false;
+}
+
+void ControlPipeline::Submit(const ControlRequest &request) {
+  // The simulator waits for the reply before sending the next frame, the queue only fills up with more sessions
+  // than its capacity
+  while (!requests.Push(request)) {
+    this_thread::yield();
+  }
+  ++submitted;
+
+  // Pairs with the fence of the control thread: either the control thread sees the frame before sleeping or this
+  // thread sees that it sleeps
+  atomic_thread_fence(memory_order_seq_cst);
+  if (idle.load(memory_order_relaxed)) {
+    Wake();
+  }
+}
+
+bool ControlPipeline::Poll(ControlReply &reply) { return replies.Pop(reply); }
+
+void ControlPipeline::Drain() {
+  while (processed.load(memory_order_acquire) != submitted) {
+    this_thread::yield();
+  }
+}
+
+uint64_t ControlPipeline::Wakeups() { return wakeups.load(memory_order_relaxed); }
+
+void ControlPipeline::Wake() {
+  lock_guard<mutex> lock(idle_mutex);
+  idle = false;
+  idle_signal.notify_one();
+}
+
+void ControlPipeline::Run() {
+  ControlRequest request;
+  chrono::nanoseconds spin_time(thread::hardware_concurrency() > 1 ? SPIN_NS : 0);
+  chrono::steady_clock::time_point spin_start;
+  bool spinning = false;
+
+  while (true) {
+    if (requests.Pop(request)) {
+      Session *session = request.session;
+      ControlReply reply = {session, request.id, false, {0.0, 0.0}};
+
+#ifdef PID_PROFILE
+      StageProfiler *profiler = session->GetProfiler();
+#endif
+
+      PROFILE_START(profiler);
+      reply.reset = !session->Control(request.telemetry, session->FrameInterval(request.arrival), reply.actuation);
+      PROFILE_END(profiler);
+
+      while (!replies.Push(reply)) {
+        this_thread::yield();
+      }
+      notify();
+
+      if (reply.reset) {
+        // The simulator restarts while the next candidate is proposed
+        session->CompleteCycle();
+      }
+      processed.store(processed.load(memory_order_relaxed) + 1, memory_order_release);
+
+      spinning = false;
+      continue;
+    }
+
+    if (stop) {
+      break;
+    }
+
+    if (!spinning) {
+      spinning = true;
+      spin_start = chrono::steady_clock::now();
+      continue;
+    }
+
+    if (chrono::steady_clock::now() - spin_start < spin_time) {
+      continue;
+    }
+
+    unique_lock<mutex> lock(idle_mutex);
+    idle = true;
+    atomic_thread_fence(memory_order_seq_cst);
+    if (requests.Size() == 0 && !stop) {
+      idle_signal.wait(lock, [this] { return !idle.load(memory_order_relaxed); });
+      wakeups.store(wakeups.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    }
+    idle = false;
+    spinning = false;
+  }
+}
@@ -0,0 +1,116 @@
+#ifndef CONTROL_PIPELINE_H
+#define CONTROL_PIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "RingBuffer.h"
+#include "Session.h"
+
+/*
+ * A telemetry frame decoded by the I/O thread.
+ */
+struct ControlRequest {
+  Session *session;
+  // Id of the session when the frame was received, the reply is dropped if the session was released since
+  unsigned int id;
+  Telemetry telemetry;
+  // Arrival of the frame, for the frame interval
+  std::chrono::steady_clock::time_point arrival;
+};
+
+/*
+ * The outcome of a frame, to be sent by the I/O thread.
+ */
+struct ControlReply {
+  Session *session;
+  unsigned int id;
+  // The simulator must be reset (end of a tuning cycle), otherwise the actuation is sent
+  bool reset;
+  Actuation actuation;
+};
+
+/*
+ * Runs the controllers of the sessions of an event loop on a dedicated control thread, so that the I/O thread only
+ * decodes the frames and sends the replies: a slow frame (e.g. at the end of a tuning cycle) never delays reading
+ * the frames of the other sessions. The frames are passed to the control thread and the replies back through
+ * lock-free SPSC queues.
+ *
+ * The control thread spins for a short while on an empty queue and then sleeps until the next frame is submitted,
+ * so that it does not use a whole core between the frames of the simulator (20 ms apart).
+ */
+class ControlPipeline {
+ public:
+  /*
+   * @param capacity Frames that can be queued in each direction
+   */
+  explicit ControlPipeline(size_t capacity);
+
+  /*
+   * Destructor, stops the control thread if still running.
+   */
+  virtual ~ControlPipeline();
+
+  /*
+   * Starts the control thread.
+   *
+   * @param notify Called by the control thread after queuing a reply, to wake up the I/O thread (e.g. uv_async_send)
+   */
+  void Start(const std::function<void()> &notify);
+
+  /*
+   * Stops the control thread, the frames still queued are processed first.
+   */
+  void Stop();
+
+  /*
+   * Queues a frame for the control thread (I/O thread only), waits while the queue is full.
+   */
+  void Submit(const ControlRequest &request);
+
+  /*
+   * Pops a reply (I/O thread only).
+   *
+   * @return False if there is no reply
+   */
+  bool Poll(ControlReply &reply);
+
+  /*
+   * Waits until the control thread processed all the frames submitted so far (I/O thread only), so that the
+   * session of a closed connection can be released.
+   */
+  void Drain();
+
+  /*
+   * Number of times the control thread was woken up after sleeping on an empty queue.
+   */
+  uint64_t Wakeups();
+
+ private:
+  RingBuffer<ControlRequest> requests;
+  RingBuffer<ControlReply> replies;
+  std::function<void()> notify;
+  std::thread control;
+  bool running;
+
+  // Written by the I/O thread
+  uint64_t submitted;
+  // Written by the control thread
+  std::atomic<uint64_t> processed;
+  std::atomic<uint64_t> wakeups;
+
+  std::mutex idle_mutex;
+  std::condition_variable idle_signal;
+  // Set by the control thread before sleeping, cleared by the thread waking it up
+  std::atomic<bool> idle;
+  std::atomic<bool> stop;
+
+  void Run();
+  void Wake();
+};
+
+#endif /* CONTROL_PIPELINE_H */
@@ -0,0 +1,67 @@
+#include "Controller.h"
+#include <math.h>
+
+static double clamp_steering(double n) { return n < -1 ? -1 : (n > 1 ? 1 : n); }
+
+Controller::Controller(const std::vector<double> &params, unsigned int max_steps)
+    : tuner(params, max_steps), last_steer(0.0) {
+#ifdef PID_PROFILE
+  profiler = nullptr;
+#endif
+  // Initializes the controller coefficients
+  steering_pid.Init(params[0], params[1], params[2]);
+}
+
+Controller::~Controller() {}
+
+void Controller::Reset(const std::vector<double> &params, unsigned int max_steps) {
+  tuner.Reset(params, max_steps);
+  steering_pid = PID();
+  steering_pid.Init(params[0], params[1], params[2]);
+  last_steer = 0.0;
+}
+
+bool Controller::Update(double cte, double speed, double dt, Actuation &actuation) {
+  if (tuner.Enabled()) {
+    // Tune the parameters
+    std::vector<double> tuned_params = tuner.Tune(cte, speed, last_steer, dt);
+
+    // Updates the parameters
+    steering_pid.Init(tuned_params[0], tuned_params[1], tuned_params[2]);
+
+    PROFILE_MARK(profiler, STAGE_TUNE);
+
+    if (tuner.IsResetCycle()) {
+      // The simulator restarts
+      last_steer = 0.0;
+      return false;
+    }
+  }
+
+  // Updates the controller errors
+  steering_pid.UpdateError(cte);
+
+  // Gets the total error and uses it as the steering angle
+  double steer_value = steering_pid.TotalError();
+  // Clamp the value between 1 and -1
+  steer_value = clamp_steering(steer_value);
+
+  // Set throttle value according to steering value, the more the angle the less the throttle.
+  // Min throttle 0.1, max throttle 0.5
+  double throttle = (1 - fabs(steer_value)) * 0.4 + 0.1;
+
+  actuation = {steer_value, throttle};
+  last_steer = steer_value;
+
+  PROFILE_MARK(profiler, STAGE_PID);
+
+  return true;
+}
+
+Tuner &Controller::GetTuner() { return tuner; }
+
+PID &Controller::GetPID() { return steering_pid; }
+
+#ifdef PID_PROFILE
+void Controller::SetProfiler(StageProfiler *profiler) { this->profiler = profiler; }
+#endif
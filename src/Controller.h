@@ -0,0 +1,71 @@
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include <vector>
+#include "PID.h"
+#include "Profiler.h"
+#include "Tuner.h"
+
+/*
+ * Actuation values sent back to the simulator.
+ */
+struct Actuation {
+  double steer_value;
+  double throttle;
+};
+
+/*
+ * Steering controller: drives the PID (and the tuner when enabled) from the cross track error and computes the
+ * steering value and throttle, independently from where the telemetry comes from.
+ */
+class Controller {
+ public:
+  /*
+   * Initializes the controller with the given Kp, Ki and Kd coefficients.
+   *
+   * @param params The Kp, Ki and Kd coefficients
+   * @param max_steps The number of steps of a tuning cycle, 0 disables the tuner
+   */
+  Controller(const std::vector<double> &params, unsigned int max_steps);
+
+  virtual ~Controller();
+
+  /*
+   * Restarts the controller (and the tuner) with the given coefficients, clearing the accumulated errors.
+   */
+  void Reset(const std::vector<double> &params, unsigned int max_steps);
+
+  /*
+   * Processes the given cross track error.
+   *
+   * @param cte Cross track error value
+   * @param speed The current speed (used by the tuner to detect the end of the warmup), NaN if not known
+   * @param dt Time since the previous telemetry (s, used by the continuous tuning), NaN if not known
+   * @param actuation Output steering value and throttle, set only if the function returns true
+   *
+   * @return False if the simulation needs to be reset (end of a tuning cycle)
+   */
+  bool Update(double cte, double speed, double dt, Actuation &actuation);
+
+  Tuner &GetTuner();
+
+  PID &GetPID();
+
+#ifdef PID_PROFILE
+  /*
+   * Sets the profiler recording the tuner and PID stages of Update, nullptr to disable.
+   */
+  void SetProfiler(StageProfiler *profiler);
+#endif
+
+ private:
+  PID steering_pid;
+  Tuner tuner;
+  // Steering value of the previous step
+  double last_steer;
+#ifdef PID_PROFILE
+  StageProfiler *profiler;
+#endif
+};
+
+#endif /* CONTROLLER_H */
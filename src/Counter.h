@@ -0,0 +1,29 @@
+#ifndef COUNTER_H
+#define COUNTER_H
+
+#include <atomic>
+#include <cstdint>
+
+/*
+ * Counter with a single writer that can be read from any thread. The increment is a relaxed load and store rather
+ * than an atomic read-modify-write, so it costs the same as a plain counter on the writer side.
+ */
+class Counter {
+ public:
+  Counter() : value(0) {}
+
+  /*
+   * Increments the counter (writer only).
+   */
+  Counter &operator++() {
+    value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return *this;
+  }
+
+  operator uint64_t() const { return value.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> value;
+};
+
+#endif /* COUNTER_H */
@@ -0,0 +1,296 @@
+#include "EvalStore.h"
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include "Hash.h"
+
+using namespace std;
+
+// Significant bits kept when matching the coefficients
+#define GAIN_BITS 30
+
+// Initial size of the mapping (about 14000 records), doubled when the file outgrows it
+#define MIN_MAP_SIZE (1 << 20)
+
+// Rounds the value to GAIN_BITS significant bits
+static double quantize(double value) {
+  if (value == 0.0 || !isfinite(value)) {
+    return value;
+  }
+  int exponent;
+  frexp(value, &exponent);
+  double scale = ldexp(1.0, exponent - GAIN_BITS);
+  return round(value / scale) * scale;
+}
+
+static uint64_t key_hash(const double *gains, uint64_t context) {
+  double key[3];
+  for (unsigned int i = 0; i < 3; ++i) {
+    key[i] = quantize(gains[i]);
+  }
+  return Fnv1a(key, sizeof(key), Fnv1a(&context, sizeof(context)));
+}
+
+static uint32_t record_checksum(const EvalStoreRecord &record) {
+  return static_cast<uint32_t>(Fnv1a(&record, offsetof(EvalStoreRecord, checksum)));
+}
+
+static bool write_all(int fd, const void *data, size_t length, off_t offset) {
+  const char *p = static_cast<const char *>(data);
+  while (length > 0) {
+    ssize_t result = pwrite(fd, p, length, offset);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    p += result;
+    offset += result;
+    length -= result;
+  }
+  return true;
+}
+
+EvalStore::EvalStore() {
+  this->fd = -1;
+  this->map = nullptr;
+  this->map_size = 0;
+  this->indexed = 0;
+  this->stop = false;
+  this->running = false;
+}
+
+EvalStore::~EvalStore() { Close(); }
+
+bool EvalStore::Open(const string &file_name) {
+  if (IsOpen()) {
+    return false;
+  }
+
+  fd = open(file_name.c_str(), O_RDWR | O_CREAT, 0644);
+
+  if (fd < 0) {
+    return false;
+  }
+
+  EvalStoreHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, EVAL_STORE_MAGIC, sizeof(header.magic));
+  header.version = EVAL_STORE_VERSION;
+  header.record_size = sizeof(EvalStoreRecord);
+
+  // The first writer creates the header, the lock keeps concurrent writers from appending before it
+  flock(fd, LOCK_EX);
+
+  struct stat st;
+  bool valid = fstat(fd, &st) == 0;
+
+  if (valid && st.st_size == 0) {
+    valid = write_all(fd, &header, sizeof(header), 0);
+  } else if (valid) {
+    EvalStoreHeader existing;
+    valid = pread(fd, &existing, sizeof(existing), 0) == sizeof(existing) &&
+            memcmp(&existing, &header, sizeof(header)) == 0;
+  }
+
+  flock(fd, LOCK_UN);
+
+  indexed = sizeof(EvalStoreHeader);
+
+  if (!valid || !Refresh()) {
+    Close();
+    return false;
+  }
+
+  stop = false;
+  running = true;
+  writer = thread(&EvalStore::Run, this);
+
+  return true;
+}
+
+void EvalStore::Close() {
+  if (running) {
+    {
+      lock_guard<mutex> lock(pending_mutex);
+      stop = true;
+    }
+    pending_signal.notify_one();
+    writer.join();
+    running = false;
+  }
+  pending.clear();
+  if (map != nullptr) {
+    munmap(const_cast<char *>(map), map_size);
+    map = nullptr;
+    map_size = 0;
+  }
+  if (fd >= 0) {
+    close(fd);
+    fd = -1;
+  }
+  index.clear();
+  indexed = 0;
+}
+
+bool EvalStore::IsOpen() { return fd >= 0; }
+
+bool EvalStore::Refresh() {
+  struct stat st;
+
+  if (fstat(fd, &st) != 0) {
+    return false;
+  }
+
+  size_t size = st.st_size;
+
+  // The pages past the end of the file become readable as the file grows (appended by this or any other process),
+  // the mapping is only extended when the file outgrows it
+  if (size > map_size) {
+    size_t new_size = max<size_t>(map_size, MIN_MAP_SIZE);
+    while (new_size < size) {
+      new_size *= 2;
+    }
+
+    void *new_map = map == nullptr ? mmap(nullptr, new_size, PROT_READ, MAP_SHARED, fd, 0)
+                                   : mremap(const_cast<char *>(map), map_size, new_size, MREMAP_MAYMOVE);
+
+    if (new_map == MAP_FAILED) {
+      return false;
+    }
+
+    map = static_cast<const char *>(new_map);
+    map_size = new_size;
+  }
+
+  // A record still being appended is indexed on the next refresh
+  while (indexed + sizeof(EvalStoreRecord) <= size) {
+    EvalStoreRecord record;
+    memcpy(&record, map + indexed, sizeof(record));
+    if (record.checksum == record_checksum(record)) {
+      index[key_hash(record.gains, record.context)] = indexed;
+    }
+    indexed += sizeof(EvalStoreRecord);
+  }
+
+  return true;
+}
+
+bool EvalStore::Lookup(const vector<double> &gains, uint64_t context, EvalResult &result) {
+  if (!IsOpen() || gains.size() != 3 || !Refresh()) {
+    return false;
+  }
+
+  auto it = index.find(key_hash(gains.data(), context));
+
+  if (it == index.end()) {
+    return false;
+  }
+
+  EvalStoreRecord record;
+  memcpy(&record, map + it->second, sizeof(record));
+
+  // Hash collision
+  if (record.context != context) {
+    return false;
+  }
+  for (unsigned int i = 0; i < 3; ++i) {
+    if (quantize(record.gains[i]) != quantize(gains[i])) {
+      return false;
+    }
+  }
+
+  result = {record.avg_err, record.max_cte, record.steps, record.timestamp, record.flags};
+
+  return true;
+}
+
+bool EvalStore::Append(const vector<double> &gains, uint64_t context, const EvalResult &result) {
+  if (!IsOpen() || gains.size() != 3) {
+    return false;
+  }
+
+  EvalStoreRecord record;
+  memset(&record, 0, sizeof(record));
+  for (unsigned int i = 0; i < 3; ++i) {
+    record.gains[i] = gains[i];
+  }
+  record.context = context;
+  record.avg_err = result.avg_err;
+  record.max_cte = result.max_cte;
+  record.steps = result.steps;
+  record.timestamp = result.timestamp;
+  record.flags = result.flags;
+  record.checksum = record_checksum(record);
+
+  {
+    lock_guard<mutex> lock(pending_mutex);
+    pending.push_back(record);
+  }
+  pending_signal.notify_one();
+
+  return true;
+}
+
+void EvalStore::Run() {
+  vector<EvalStoreRecord> records;
+
+  while (true) {
+    {
+      unique_lock<mutex> lock(pending_mutex);
+      pending_signal.wait(lock, [this] { return !pending.empty() || stop; });
+      if (pending.empty()) {
+        break;
+      }
+      // Swaps the storage so that the event loop keeps reusing the buffer of the previous records
+      swap(records, pending);
+    }
+
+    if (!WriteRecords(records)) {
+      cerr << "[Error]: Could not write evaluation: " << strerror(errno) << endl;
+    }
+
+    records.clear();
+  }
+}
+
+bool EvalStore::WriteRecords(const vector<EvalStoreRecord> &records) {
+  // The lock keeps the records of concurrent writers from interleaving
+  flock(fd, LOCK_EX);
+
+  struct stat st;
+  bool written = fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(EvalStoreHeader));
+
+  if (written) {
+    // A partial record at the end of the file was left by a writer that died in the middle of an append
+    size_t records_size = (st.st_size - sizeof(EvalStoreHeader)) / sizeof(EvalStoreRecord) * sizeof(EvalStoreRecord);
+    off_t end = sizeof(EvalStoreHeader) + records_size;
+    if (end != st.st_size) {
+      written = ftruncate(fd, end) == 0;
+    }
+    written = written && write_all(fd, records.data(), records.size() * sizeof(EvalStoreRecord), end);
+  }
+
+  flock(fd, LOCK_UN);
+
+  return written;
+}
+
+size_t EvalStore::Size() { return index.size(); }
+
+uint64_t EvalStore::Context(const string &description) { return Fnv1a(description.data(), description.size()); }
+
+int64_t EvalStore::Now() {
+  return chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,159 @@
+#ifndef EVAL_STORE_H
+#define EVAL_STORE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "The evaluation store format is only supported on little-endian platforms"
+#endif
+
+const char EVAL_STORE_MAGIC[8] = {'P', 'I', 'D', 'E', 'V', 'A', 'L', '\0'};
+const uint32_t EVAL_STORE_VERSION = 1;
+
+/*
+ * Flags of an evaluation.
+ */
+enum EvalFlags {
+  // The cycle was ended early (see EarlyAbort), the error is a lower bound of the error of the whole cycle
+  EVAL_ABORTED = 1,
+  // The vehicle left the track, the error is the cross track error at that point
+  EVAL_OFF_TRACK = 2
+};
+
+/*
+ * Outcome of a tuning cycle.
+ */
+struct EvalResult {
+  // Average squared cross track error (the cycle error of the Tuner)
+  double avg_err;
+  double max_cte;
+  // Steps of the cycle, including the warmup
+  uint64_t steps;
+  // Wall clock time of the evaluation in nanoseconds since the epoch
+  int64_t timestamp;
+  uint32_t flags;
+};
+
+/*
+ * Header of the evaluation store file, followed by a sequence of EvalStoreRecord.
+ */
+struct EvalStoreHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+};
+
+struct EvalStoreRecord {
+  double gains[3];
+  // Hash of the plant and of the tuner settings, see EvalStore::Context
+  uint64_t context;
+  double avg_err;
+  double max_cte;
+  uint64_t steps;
+  int64_t timestamp;
+  uint32_t flags;
+  // Lower 32 bits of the FNV-1a hash of the preceding fields
+  uint32_t checksum;
+};
+
+/*
+ * Persistent store of the evaluated coefficients, so that the cycles already run (in this or any previous session,
+ * or by another process) are not run again. The file is append only: each evaluation is a fixed size record appended
+ * by a background thread under an exclusive lock (flock), so that several processes can share the same file and the
+ * event loop never waits for the lock or the disk. The records are written at the end of the last complete record,
+ * the partial record left by a writer that died in the middle of an append is truncated so that it cannot misalign
+ * the records after it. The file is memory mapped for the lookups, the mapping is extended as the file grows and the
+ * records appended since the last lookup (by any writer) are indexed incrementally, the latest evaluation of the same
+ * coefficients wins.
+ *
+ * The coefficients are matched with a relative precision of about 1e-9, so that the values reached through
+ * different sequences of increments are still recognized.
+ */
+class EvalStore {
+ public:
+  EvalStore();
+
+  /*
+   * Destructor, closes the store if still open.
+   */
+  virtual ~EvalStore();
+
+  /*
+   * Opens (or creates) the store file, indexes its records and starts the writer thread.
+   *
+   * @return False if the file could not be opened or is not an evaluation store
+   */
+  bool Open(const std::string &file_name);
+
+  /*
+   * Stops the writer thread, writing the queued evaluations, and closes the file.
+   */
+  void Close();
+
+  bool IsOpen();
+
+  /*
+   * Looks up the latest evaluation of the given coefficients.
+   *
+   * @param gains The Kp, Ki and Kd coefficients
+   * @param context The context of the evaluation
+   * @param result Output result, set only if the function returns true
+   *
+   * @return False if the coefficients were never evaluated in the given context
+   */
+  bool Lookup(const std::vector<double> &gains, uint64_t context, EvalResult &result);
+
+  /*
+   * Queues an evaluation for the writer thread, the lookups find it once it is written.
+   *
+   * @return False if the store is not open
+   */
+  bool Append(const std::vector<double> &gains, uint64_t context, const EvalResult &result);
+
+  /*
+   * Number of distinct evaluations indexed.
+   */
+  size_t Size();
+
+  /*
+   * The context of the evaluations, a hash of the given description of the plant and of the settings that affect
+   * the result of a cycle.
+   */
+  static uint64_t Context(const std::string &description);
+
+  /*
+   * Current wall clock time in nanoseconds since the epoch, to be used as evaluation timestamp.
+   */
+  static int64_t Now();
+
+ private:
+  int fd;
+  const char *map;
+  // Reserved beyond the end of the file, so that the mapping covers the records appended later
+  size_t map_size;
+  // Offset of the first record not indexed yet
+  size_t indexed;
+  // Key hash to record offset
+  std::unordered_map<uint64_t, size_t> index;
+
+  std::thread writer;
+  std::mutex pending_mutex;
+  std::condition_variable pending_signal;
+  // Records queued for the writer thread, swapped with its buffer
+  std::vector<EvalStoreRecord> pending;
+  bool stop;
+  bool running;
+
+  bool Refresh();
+  void Run();
+  bool WriteRecords(const std::vector<EvalStoreRecord> &records);
+};
+
+#endif /* EVAL_STORE_H */
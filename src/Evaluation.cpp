@@ -0,0 +1,33 @@
+#include "Evaluation.h"
+#include <math.h>
+#include "Controller.h"
+
+double EvaluateCycle(const Track &track, const SimulatorSettings &settings, const std::vector<double> &params,
+                     unsigned int max_steps, unsigned int warmup_steps, unsigned int *steps) {
+  Simulator simulator(track, settings);
+  Controller controller(params, 0);
+  double total_err = 0.0;
+
+  // The step that ends the cycle is collected as well, as by the Tuner
+  for (unsigned int step = 0; step <= warmup_steps + max_steps; ++step) {
+    Telemetry telemetry = simulator.GetTelemetry();
+    if (fabs(telemetry.cte) > TUNER_CTE_TOLERANCE) {
+      if (steps != nullptr) {
+        *steps = step;
+      }
+      return fabs(telemetry.cte);
+    }
+    if (step >= warmup_steps) {
+      total_err += telemetry.cte * telemetry.cte;
+    }
+    Actuation actuation;
+    controller.Update(telemetry.cte, telemetry.speed, settings.dt, actuation);
+    simulator.Step(actuation.steer_value, actuation.throttle);
+  }
+
+  if (steps != nullptr) {
+    *steps = warmup_steps + max_steps + 1;
+  }
+
+  return CycleError(total_err, max_steps);
+}
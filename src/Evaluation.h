@@ -0,0 +1,22 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include <vector>
+#include "Simulator.h"
+
+/*
+ * Evaluates the given coefficients with a tuning cycle on a new headless simulator instance, with the same rules of
+ * the Tuner with a fixed warmup: the error is the CycleError after the warmup, or the cross track error at which the
+ * vehicle left the track. Safe to call concurrently.
+ *
+ * @param track The track
+ * @param settings The simulator settings
+ * @param params The Kp, Ki and Kd coefficients
+ * @param max_steps The number of steps of the cycle after the warmup
+ * @param warmup_steps The number of steps of the warmup (TUNER_WARMUP_STEPS for the Tuner default)
+ * @param steps Output number of simulated steps (warmup included), ignored if null
+ */
+double EvaluateCycle(const Track &track, const SimulatorSettings &settings, const std::vector<double> &params,
+                     unsigned int max_steps, unsigned int warmup_steps, unsigned int *steps = nullptr);
+
+#endif /* EVALUATION_H */
@@ -0,0 +1,199 @@
+#include "EventWriter.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+EventWriter::EventWriter() {
+  this->pending_count = 0;
+  this->first_output = 0;
+  this->next_output = 0;
+  this->last_written = 0;
+  this->stop = false;
+  this->is_open = false;
+}
+
+EventWriter::~EventWriter() {
+  Close();
+
+  {
+    lock_guard<mutex> lock(pending_mutex);
+    stop = true;
+  }
+
+  pending_signal.notify_one();
+  if (writer.joinable()) {
+    writer.join();
+  }
+}
+
+bool EventWriter::Open(const string &file_name, bool console) {
+  if (IsOpen()) {
+    return false;
+  }
+
+  int fd = -1;
+
+  if (!file_name.empty()) {
+    fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+      return false;
+    }
+  }
+
+  {
+    lock_guard<mutex> lock(pending_mutex);
+    outputs.push_back({fd, console, false, 0});
+    ++next_output;
+  }
+
+  if (!writer.joinable()) {
+    writer = thread(&EventWriter::Run, this);
+  }
+
+  is_open = true;
+
+  return true;
+}
+
+void EventWriter::Close() {
+  if (!IsOpen()) {
+    return;
+  }
+
+  {
+    lock_guard<mutex> lock(pending_mutex);
+    outputs.back().closed = true;
+  }
+
+  pending_signal.notify_one();
+  is_open = false;
+}
+
+void EventWriter::Wait() {
+  unique_lock<mutex> lock(pending_mutex);
+  // Only the last output can still be open
+  closed_signal.wait(lock, [this] { return outputs.empty() || !outputs.front().closed; });
+}
+
+bool EventWriter::IsOpen() { return is_open; }
+
+void EventWriter::Emit(const TunerEvent &event) {
+  {
+    lock_guard<mutex> lock(pending_mutex);
+    if (pending_count == pending.size()) {
+      pending.emplace_back();
+    }
+    pending[pending_count].event = event;
+    pending[pending_count].output = next_output - 1;
+    ++pending_count;
+  }
+  pending_signal.notify_one();
+}
+
+uint64_t EventWriter::Written() {
+  lock_guard<mutex> lock(pending_mutex);
+  return outputs.empty() ? last_written : outputs.back().written;
+}
+
+void EventWriter::Run() {
+  vector<QueuedEvent> batch;
+  vector<Output *> targets;
+  size_t count = 0;
+  size_t closed = 0;
+  uint64_t first = 0;
+  string json;
+  string text;
+
+  while (true) {
+    {
+      unique_lock<mutex> lock(pending_mutex);
+      pending_signal.wait(lock, [this] {
+        return pending_count > 0 || stop || (!outputs.empty() && outputs.front().closed);
+      });
+      if (pending_count == 0 && (outputs.empty() || !outputs.front().closed)) {
+        break;
+      }
+      // Swaps the storage so that the event loop keeps reusing the events of the previous batch
+      swap(batch, pending);
+      count = pending_count;
+      pending_count = 0;
+      // The events of the outputs closed by now are all in the batch or in the previous ones
+      closed = 0;
+      while (closed < outputs.size() && outputs[closed].closed) {
+        ++closed;
+      }
+      // The outputs are only pushed to the back meanwhile, the references stay valid
+      first = first_output;
+      targets.clear();
+      for (Output &output : outputs) {
+        targets.push_back(&output);
+      }
+    }
+
+    for (size_t begin = 0, end = 0; begin < count; begin = end) {
+      Output *output = targets[batch[begin].output - first];
+
+      json.clear();
+      text.clear();
+      for (end = begin; end < count && batch[end].output == batch[begin].output; ++end) {
+        if (output->fd >= 0) {
+          FormatEventJson(batch[end].event, json);
+        }
+        if (output->console) {
+          FormatEventText(batch[end].event, text);
+        }
+      }
+
+      if (output->fd >= 0) {
+        Write(output->fd, json);
+      }
+      if (output->console) {
+        cout << text << flush;
+      }
+
+      lock_guard<mutex> lock(pending_mutex);
+      output->written += end - begin;
+    }
+
+    for (size_t i = 0; i < closed; ++i) {
+      if (targets[i]->fd >= 0) {
+        close(targets[i]->fd);
+      }
+    }
+
+    if (closed > 0) {
+      {
+        lock_guard<mutex> lock(pending_mutex);
+        for (size_t i = 0; i < closed; ++i) {
+          last_written = outputs.front().written;
+          outputs.pop_front();
+        }
+        first_output += closed;
+      }
+      closed_signal.notify_all();
+    }
+  }
+}
+
+bool EventWriter::Write(int fd, const string &data) {
+  const char *p = data.data();
+  size_t length = data.size();
+
+  while (length > 0) {
+    ssize_t result = write(fd, p, length);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      cerr << "[Error]: Could not write tuner events: " << strerror(errno) << endl;
+      return false;
+    }
+    p += result;
+    length -= result;
+  }
+  return true;
+}
@@ -0,0 +1,98 @@
+#ifndef EVENT_WRITER_H
+#define EVENT_WRITER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "TunerEvents.h"
+
+/*
+ * Writes the tuner events from a background thread, so that the event loop never waits for the console or the
+ * disk: the events are written to a file as JSON lines, and their summary is printed to the console. The event loop
+ * only copies the event into the queue (a few events per tuning cycle). The writer thread outlives the files: closing
+ * the writer only marks the end of its events, the writer thread writes them and closes the file.
+ */
+class EventWriter : public TunerEventSink {
+ public:
+  EventWriter();
+
+  /*
+   * Destructor, closes the writer if still open and waits for the writer thread to close the files.
+   */
+  virtual ~EventWriter();
+
+  /*
+   * Opens the file, starts the writer thread on the first call.
+   *
+   * @param file_name The name of the JSON lines file, empty for no file
+   * @param console Prints the summary of the events to the console
+   *
+   * @return False if the file could not be opened
+   */
+  bool Open(const std::string &file_name, bool console);
+
+  /*
+   * Marks the end of the events of the file, never waits: the writer thread writes the pending events and closes
+   * the file.
+   */
+  void Close();
+
+  /*
+   * Waits until the writer thread has written the events of the closed files and closed them, for the callers that
+   * are not on the event loop.
+   */
+  void Wait();
+
+  bool IsOpen();
+
+  /*
+   * Queues the event for the writer thread, never waits for I/O.
+   */
+  void Emit(const TunerEvent &event);
+
+  /*
+   * Number of events written since the writer was opened, or of the last closed file.
+   */
+  uint64_t Written();
+
+ private:
+  struct Output {
+    int fd;
+    bool console;
+    bool closed;
+    uint64_t written;
+  };
+
+  struct QueuedEvent {
+    TunerEvent event;
+    // Id of the output opened when the event was emitted
+    uint64_t output;
+  };
+
+  std::thread writer;
+  std::mutex pending_mutex;
+  std::condition_variable pending_signal;
+  std::condition_variable closed_signal;
+  // Swapped with the batch of the writer thread, the storage of the events is reused
+  std::vector<QueuedEvent> pending;
+  size_t pending_count;
+  // Open outputs, the writer thread closes the front ones once their events are written
+  std::deque<Output> outputs;
+  // Id of the front output and of the next one opened
+  uint64_t first_output;
+  uint64_t next_output;
+  uint64_t last_written;
+  bool stop;
+
+  // Event loop only
+  bool is_open;
+
+  void Run();
+  bool Write(int fd, const std::string &data);
+};
+
+#endif /* EVENT_WRITER_H */
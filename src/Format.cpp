@@ -0,0 +1,460 @@
+#include "Format.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+/*
+ * Grisu2 implementation, see FormatDouble.
+ */
+
+// Floating point number with a 64 bit significand, value = f * 2^e
+struct DiyFp {
+  uint64_t f;
+  int e;
+};
+
+struct CachedPower {
+  uint64_t f;
+  int e;
+  int k;
+};
+
+// Target range for the binary exponent of the scaled value
+static const int ALPHA = -60;
+static const int GAMMA = -32;
+
+// Normalized powers of ten 10^k for k = -300, -292, ..., 324
+static const int CACHED_POWERS_MIN_DEC_EXP = -300;
+static const int CACHED_POWERS_DEC_STEP = 8;
+static const CachedPower CACHED_POWERS[] = {
+    {0xAB70FE17C79AC6CA, -1060, -300},
+    {0xFF77B1FCBEBCDC4F, -1034, -292},
+    {0xBE5691EF416BD60C, -1007, -284},
+    {0x8DD01FAD907FFC3C, -980, -276},
+    {0xD3515C2831559A83, -954, -268},
+    {0x9D71AC8FADA6C9B5, -927, -260},
+    {0xEA9C227723EE8BCB, -901, -252},
+    {0xAECC49914078536D, -874, -244},
+    {0x823C12795DB6CE57, -847, -236},
+    {0xC21094364DFB5637, -821, -228},
+    {0x9096EA6F3848984F, -794, -220},
+    {0xD77485CB25823AC7, -768, -212},
+    {0xA086CFCD97BF97F4, -741, -204},
+    {0xEF340A98172AACE5, -715, -196},
+    {0xB23867FB2A35B28E, -688, -188},
+    {0x84C8D4DFD2C63F3B, -661, -180},
+    {0xC5DD44271AD3CDBA, -635, -172},
+    {0x936B9FCEBB25C996, -608, -164},
+    {0xDBAC6C247D62A584, -582, -156},
+    {0xA3AB66580D5FDAF6, -555, -148},
+    {0xF3E2F893DEC3F126, -529, -140},
+    {0xB5B5ADA8AAFF80B8, -502, -132},
+    {0x87625F056C7C4A8B, -475, -124},
+    {0xC9BCFF6034C13053, -449, -116},
+    {0x964E858C91BA2655, -422, -108},
+    {0xDFF9772470297EBD, -396, -100},
+    {0xA6DFBD9FB8E5B88F, -369, -92},
+    {0xF8A95FCF88747D94, -343, -84},
+    {0xB94470938FA89BCF, -316, -76},
+    {0x8A08F0F8BF0F156B, -289, -68},
+    {0xCDB02555653131B6, -263, -60},
+    {0x993FE2C6D07B7FAC, -236, -52},
+    {0xE45C10C42A2B3B06, -210, -44},
+    {0xAA242499697392D3, -183, -36},
+    {0xFD87B5F28300CA0E, -157, -28},
+    {0xBCE5086492111AEB, -130, -20},
+    {0x8CBCCC096F5088CC, -103, -12},
+    {0xD1B71758E219652C, -77, -4},
+    {0x9C40000000000000, -50, 4},
+    {0xE8D4A51000000000, -24, 12},
+    {0xAD78EBC5AC620000, 3, 20},
+    {0x813F3978F8940984, 30, 28},
+    {0xC097CE7BC90715B3, 56, 36},
+    {0x8F7E32CE7BEA5C70, 83, 44},
+    {0xD5D238A4ABE98068, 109, 52},
+    {0x9F4F2726179A2245, 136, 60},
+    {0xED63A231D4C4FB27, 162, 68},
+    {0xB0DE65388CC8ADA8, 189, 76},
+    {0x83C7088E1AAB65DB, 216, 84},
+    {0xC45D1DF942711D9A, 242, 92},
+    {0x924D692CA61BE758, 269, 100},
+    {0xDA01EE641A708DEA, 295, 108},
+    {0xA26DA3999AEF774A, 322, 116},
+    {0xF209787BB47D6B85, 348, 124},
+    {0xB454E4A179DD1877, 375, 132},
+    {0x865B86925B9BC5C2, 402, 140},
+    {0xC83553C5C8965D3D, 428, 148},
+    {0x952AB45CFA97A0B3, 455, 156},
+    {0xDE469FBD99A05FE3, 481, 164},
+    {0xA59BC234DB398C25, 508, 172},
+    {0xF6C69A72A3989F5C, 534, 180},
+    {0xB7DCBF5354E9BECE, 561, 188},
+    {0x88FCF317F22241E2, 588, 196},
+    {0xCC20CE9BD35C78A5, 614, 204},
+    {0x98165AF37B2153DF, 641, 212},
+    {0xE2A0B5DC971F303A, 667, 220},
+    {0xA8D9D1535CE3B396, 694, 228},
+    {0xFB9B7CD9A4A7443C, 720, 236},
+    {0xBB764C4CA7A44410, 747, 244},
+    {0x8BAB8EEFB6409C1A, 774, 252},
+    {0xD01FEF10A657842C, 800, 260},
+    {0x9B10A4E5E9913129, 827, 268},
+    {0xE7109BFBA19C0C9D, 853, 276},
+    {0xAC2820D9623BF429, 880, 284},
+    {0x80444B5E7AA7CF85, 907, 292},
+    {0xBF21E44003ACDD2D, 933, 300},
+    {0x8E679C2F5E44FF8F, 960, 308},
+    {0xD433179D9C8CB841, 986, 316},
+    {0x9E19DB92B4E31BA9, 1013, 324},
+};
+
+// Exponent limits for the fixed notation, outside of the range the exponential notation is used
+static const int MIN_FIXED_EXP = -4;
+static const int MAX_FIXED_EXP = 15;
+
+static inline DiyFp diy_sub(const DiyFp &x, const DiyFp &y) { return {x.f - y.f, x.e}; }
+
+// Upper 64 bits of the 128 bit product, rounded
+static DiyFp diy_mul(const DiyFp &x, const DiyFp &y) {
+  const uint64_t u_lo = x.f & 0xFFFFFFFFu;
+  const uint64_t u_hi = x.f >> 32u;
+  const uint64_t v_lo = y.f & 0xFFFFFFFFu;
+  const uint64_t v_hi = y.f >> 32u;
+
+  const uint64_t p0 = u_lo * v_lo;
+  const uint64_t p1 = u_lo * v_hi;
+  const uint64_t p2 = u_hi * v_lo;
+  const uint64_t p3 = u_hi * v_hi;
+
+  uint64_t q = (p0 >> 32u) + (p1 & 0xFFFFFFFFu) + (p2 & 0xFFFFFFFFu);
+  q += uint64_t{1} << 31u;
+
+  return {p3 + (p2 >> 32u) + (p1 >> 32u) + (q >> 32u), x.e + y.e + 64};
+}
+
+static inline DiyFp diy_normalize(DiyFp x) {
+  while ((x.f >> 63u) == 0) {
+    x.f <<= 1u;
+    x.e--;
+  }
+  return x;
+}
+
+static inline DiyFp diy_normalize_to(const DiyFp &x, int target_exponent) {
+  return {x.f << (x.e - target_exponent), target_exponent};
+}
+
+// Computes the (normalized) value and its boundaries m- and m+, the halfway points to the adjacent doubles
+static void compute_boundaries(double value, DiyFp &v, DiyFp &m_minus, DiyFp &m_plus) {
+  const int bias = 1023 + 52;
+  const int min_exp = 1 - bias;
+  const uint64_t hidden_bit = uint64_t{1} << 52u;
+
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+
+  const uint64_t E = bits >> 52u;
+  const uint64_t F = bits & (hidden_bit - 1);
+
+  DiyFp w = E == 0 ? DiyFp{F, min_exp} : DiyFp{F + hidden_bit, static_cast<int>(E) - bias};
+
+  const bool lower_boundary_is_closer = F == 0 && E > 1;
+
+  DiyFp plus = {2 * w.f + 1, w.e - 1};
+  DiyFp minus = lower_boundary_is_closer ? DiyFp{4 * w.f - 1, w.e - 2} : DiyFp{2 * w.f - 1, w.e - 1};
+
+  m_plus = diy_normalize(plus);
+  m_minus = diy_normalize_to(minus, m_plus.e);
+  v = diy_normalize(w);
+}
+
+static const CachedPower &cached_power(int e) {
+  const int f = ALPHA - e - 1;
+  const int k = (f * 78913) / (1 << 18) + (f > 0);
+  const int index = (-CACHED_POWERS_MIN_DEC_EXP + k + (CACHED_POWERS_DEC_STEP - 1)) / CACHED_POWERS_DEC_STEP;
+  return CACHED_POWERS[index];
+}
+
+static int find_largest_pow10(uint32_t n, uint32_t &pow10) {
+  static const uint32_t POWERS[] = {1,      10,      100,      1000,      10000,
+                                    100000, 1000000, 10000000, 100000000, 1000000000};
+  int digits = 10;
+  while (digits > 1 && n < POWERS[digits - 1]) {
+    --digits;
+  }
+  pow10 = POWERS[digits - 1];
+  return digits;
+}
+
+static void grisu2_round(char *buffer, int length, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t ten_k) {
+  // Moves the last digit towards w while staying within the boundaries
+  while (rest < dist && delta - rest >= ten_k && (rest + ten_k < dist || dist - rest > rest + ten_k - dist)) {
+    buffer[length - 1]--;
+    rest += ten_k;
+  }
+}
+
+static void grisu2_digit_gen(char *buffer, int &length, int &decimal_exponent, DiyFp m_minus, DiyFp w,
+                             DiyFp m_plus) {
+  uint64_t delta = diy_sub(m_plus, m_minus).f;
+  uint64_t dist = diy_sub(m_plus, w).f;
+
+  const DiyFp one = {uint64_t{1} << -m_plus.e, m_plus.e};
+
+  uint32_t p1 = static_cast<uint32_t>(m_plus.f >> -one.e);
+  uint64_t p2 = m_plus.f & (one.f - 1);
+
+  uint32_t pow10;
+  int n = find_largest_pow10(p1, pow10);
+
+  // Integral part
+  while (n > 0) {
+    const uint32_t d = p1 / pow10;
+    p1 %= pow10;
+    buffer[length++] = static_cast<char>('0' + d);
+    --n;
+
+    const uint64_t rest = (uint64_t{p1} << -one.e) + p2;
+    if (rest <= delta) {
+      decimal_exponent += n;
+      grisu2_round(buffer, length, dist, delta, rest, uint64_t{pow10} << -one.e);
+      return;
+    }
+
+    pow10 /= 10;
+  }
+
+  // Fractional part
+  int m = 0;
+  for (;;) {
+    p2 *= 10;
+    const uint64_t d = p2 >> -one.e;
+    p2 &= one.f - 1;
+    buffer[length++] = static_cast<char>('0' + d);
+    ++m;
+    delta *= 10;
+    dist *= 10;
+    if (p2 <= delta) {
+      break;
+    }
+  }
+
+  decimal_exponent -= m;
+
+  grisu2_round(buffer, length, dist, delta, p2, one.f);
+}
+
+// Generates the digits of a positive finite value, value = digits * 10^decimal_exponent
+static void grisu2(char *buffer, int &length, int &decimal_exponent, double value) {
+  DiyFp v, m_minus, m_plus;
+
+  compute_boundaries(value, v, m_minus, m_plus);
+
+  const CachedPower &cached = cached_power(m_plus.e);
+  const DiyFp c_minus_k = {cached.f, cached.e};
+
+  const DiyFp w = diy_mul(v, c_minus_k);
+  const DiyFp w_minus = diy_mul(m_minus, c_minus_k);
+  const DiyFp w_plus = diy_mul(m_plus, c_minus_k);
+
+  // Conservative boundaries to account for the error in the products
+  const DiyFp M_minus = {w_minus.f + 1, w_minus.e};
+  const DiyFp M_plus = {w_plus.f - 1, w_plus.e};
+
+  length = 0;
+  decimal_exponent = -cached.k;
+
+  grisu2_digit_gen(buffer, length, decimal_exponent, M_minus, w, M_plus);
+}
+
+static char *append_exponent(char *buffer, int e) {
+  if (e < 0) {
+    e = -e;
+    *buffer++ = '-';
+  } else {
+    *buffer++ = '+';
+  }
+  if (e < 10) {
+    *buffer++ = '0';
+    *buffer++ = static_cast<char>('0' + e);
+  } else if (e < 100) {
+    *buffer++ = static_cast<char>('0' + e / 10);
+    *buffer++ = static_cast<char>('0' + e % 10);
+  } else {
+    *buffer++ = static_cast<char>('0' + e / 100);
+    e %= 100;
+    *buffer++ = static_cast<char>('0' + e / 10);
+    *buffer++ = static_cast<char>('0' + e % 10);
+  }
+  return buffer;
+}
+
+// Lays out the digits in fixed or exponential notation, k is the number of digits and n the position of the decimal
+// point (value = 0.d1d2...dk * 10^n)
+static char *format_digits(char *buffer, int k, int n) {
+  if (k <= n && n <= MAX_FIXED_EXP) {
+    // digits[000].0
+    memset(buffer + k, '0', n - k);
+    buffer[n] = '.';
+    buffer[n + 1] = '0';
+    return buffer + n + 2;
+  }
+
+  if (0 < n && n <= MAX_FIXED_EXP) {
+    // dig.its
+    memmove(buffer + n + 1, buffer + n, k - n);
+    buffer[n] = '.';
+    return buffer + k + 1;
+  }
+
+  if (MIN_FIXED_EXP < n && n <= 0) {
+    // 0.[000]digits
+    memmove(buffer + 2 - n, buffer, k);
+    buffer[0] = '0';
+    buffer[1] = '.';
+    memset(buffer + 2, '0', -n);
+    return buffer + 2 - n + k;
+  }
+
+  if (k == 1) {
+    // dE+123
+    buffer += 1;
+  } else {
+    // d.igitsE+123
+    memmove(buffer + 2, buffer + 1, k - 1);
+    buffer[1] = '.';
+    buffer += 1 + k;
+  }
+
+  *buffer++ = 'e';
+  return append_exponent(buffer, n - 1);
+}
+
+size_t FormatDouble(double value, char *buffer) {
+  char *begin = buffer;
+
+  if (!std::isfinite(value)) {
+    memcpy(buffer, "null", 4);
+    return 4;
+  }
+
+  if (std::signbit(value)) {
+    value = -value;
+    *buffer++ = '-';
+  }
+
+  if (value == 0) {
+    *buffer++ = '0';
+    *buffer++ = '.';
+    *buffer++ = '0';
+    return buffer - begin;
+  }
+
+  int length;
+  int decimal_exponent;
+
+  grisu2(buffer, length, decimal_exponent, value);
+
+  buffer = format_digits(buffer, length, length + decimal_exponent);
+
+  return buffer - begin;
+}
+
+// Exactly representable powers of 10 used by the fast decimal path
+static const double POW10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                               1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+static const uint64_t MAX_EXACT_MANTISSA = 1ULL << 53;
+
+static inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+bool ParseDecimal(const char *begin, const char *end, double &value) {
+  const char *p = begin;
+  bool negative = false;
+
+  if (p != end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  bool has_digits = false;
+  bool truncated = false;
+
+  for (; p != end && is_digit(*p); ++p) {
+    has_digits = true;
+    if (mantissa == 0 && *p == '0') {
+      continue;
+    }
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (*p - '0');
+      ++digits;
+    } else {
+      truncated = true;
+      ++exponent;
+    }
+  }
+
+  if (p != end && *p == '.') {
+    for (++p; p != end && is_digit(*p); ++p) {
+      has_digits = true;
+      if (mantissa == 0 && *p == '0') {
+        --exponent;
+        continue;
+      }
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        ++digits;
+        --exponent;
+      } else {
+        truncated = true;
+      }
+    }
+  }
+
+  if (!has_digits) {
+    return false;
+  }
+
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool negative_exp = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+      negative_exp = *p == '-';
+      ++p;
+    }
+    if (p == end || !is_digit(*p)) {
+      return false;
+    }
+    int exp_value = 0;
+    for (; p != end && is_digit(*p); ++p) {
+      if (exp_value < 10000) {
+        exp_value = exp_value * 10 + (*p - '0');
+      }
+    }
+    exponent += negative_exp ? -exp_value : exp_value;
+  }
+
+  if (p != end) {
+    return false;
+  }
+
+  if (mantissa == 0) {
+    value = negative ? -0.0 : 0.0;
+    return true;
+  }
+
+  // Outside of the exact path (Clinger's fast path), let the generic parser deal with it
+  if (truncated || mantissa > MAX_EXACT_MANTISSA || exponent < -22 || exponent > 22) {
+    return false;
+  }
+
+  double result = static_cast<double>(mantissa);
+  result = exponent < 0 ? result / POW10[-exponent] : result * POW10[exponent];
+
+  value = negative ? -result : result;
+
+  return true;
+}
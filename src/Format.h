@@ -0,0 +1,38 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <cstddef>
+
+/*
+ * Minimum size of the buffer passed to FormatDouble.
+ */
+const size_t DOUBLE_BUFFER_SIZE = 32;
+
+/*
+ * Formats the given value into the buffer using the shortest decimal representation that parses back (round-trip)
+ * to the exact same double. Digits are generated with the Grisu2 algorithm (Florian Loitsch, "Printing Floating-Point
+ * Numbers Quickly and Accurately with Integers"), which is always round-trip correct and produces the shortest output
+ * for the vast majority of inputs. The output is locale independent, JSON compatible (e.g. "0.0", "-1.25",
+ * "1.5e-07", non finite values are written as null) and no heap allocation is performed.
+ *
+ * @param value The value to format
+ * @param buffer The output buffer of at least DOUBLE_BUFFER_SIZE chars, the result is not null terminated
+ *
+ * @return The number of chars written into the buffer
+ */
+size_t FormatDouble(double value, char *buffer);
+
+/*
+ * Locale independent decimal parser for the [begin, end) range (e.g. "-0.7598", "12", "1.5e-3"). The value is
+ * computed exactly (correctly rounded) when the significand fits in 53 bits and the decimal exponent is within
+ * [-22, 22], any other input is rejected.
+ *
+ * @param begin The first character of the number
+ * @param end One past the last character of the number
+ * @param value Output value, set only if the function returns true
+ *
+ * @return True if the whole range was parsed, false otherwise
+ */
+bool ParseDecimal(const char *begin, const char *end, double &value);
+
+#endif /* FORMAT_H */
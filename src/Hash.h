@@ -0,0 +1,26 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+/*
+ * 64 bit FNV-1a hash of the given bytes.
+ *
+ * @param data The bytes to hash
+ * @param length The number of bytes
+ * @param hash The initial value, the hash of the previous bytes to hash a sequence of ranges
+ */
+inline uint64_t Fnv1a(const void *data, size_t length, uint64_t hash = FNV_OFFSET_BASIS) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= bytes[i];
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+#endif /* HASH_H */
@@ -0,0 +1,81 @@
+#include "Histogram.h"
+#include <cmath>
+#include <limits>
+
+#define HALF_SUB_BUCKETS (HISTOGRAM_SUB_BUCKETS / 2)
+
+Histogram::Histogram() : counts(HISTOGRAM_BUCKETS) { Reset(); }
+
+uint64_t Histogram::HighestValue(size_t index) {
+  if (index < HISTOGRAM_SUB_BUCKETS) {
+    return index;
+  }
+  unsigned int shift = (index - HISTOGRAM_SUB_BUCKETS) / HALF_SUB_BUCKETS + 1;
+  uint64_t sub_bucket = (index - HISTOGRAM_SUB_BUCKETS) % HALF_SUB_BUCKETS + HALF_SUB_BUCKETS;
+  return ((sub_bucket + 1) << shift) - 1;
+}
+
+void Histogram::Merge(const Histogram &other) {
+  for (size_t i = 0; i < counts.size(); ++i) {
+    uint64_t count = other.counts[i].load(std::memory_order_relaxed);
+    if (count > 0) {
+      counts[i].store(counts[i].load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    }
+  }
+  total.store(total.load(std::memory_order_relaxed) + other.Count(), std::memory_order_relaxed);
+  sum.store(sum.load(std::memory_order_relaxed) + other.sum.load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+  if (other.Count() > 0) {
+    if (other.Min() < min.load(std::memory_order_relaxed)) {
+      min.store(other.Min(), std::memory_order_relaxed);
+    }
+    if (other.Max() > max.load(std::memory_order_relaxed)) {
+      max.store(other.Max(), std::memory_order_relaxed);
+    }
+  }
+}
+
+void Histogram::Reset() {
+  for (std::atomic<uint64_t> &count : counts) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  total.store(0, std::memory_order_relaxed);
+  sum.store(0, std::memory_order_relaxed);
+  min.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+  max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t Histogram::Count() const { return total.load(std::memory_order_relaxed); }
+
+uint64_t Histogram::Min() const { return Count() == 0 ? 0 : min.load(std::memory_order_relaxed); }
+
+uint64_t Histogram::Max() const { return max.load(std::memory_order_relaxed); }
+
+double Histogram::Mean() const {
+  uint64_t count = Count();
+  return count == 0 ? 0.0 : static_cast<double>(sum.load(std::memory_order_relaxed)) / count;
+}
+
+uint64_t Histogram::Percentile(double percentile) const {
+  // The total is computed from the buckets, so that the result is consistent under concurrent updates
+  uint64_t count = 0;
+  for (const std::atomic<uint64_t> &bucket : counts) {
+    count += bucket.load(std::memory_order_relaxed);
+  }
+  if (count == 0) {
+    return 0;
+  }
+  uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * count));
+  rank = rank == 0 ? 1 : (rank > count ? count : rank);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < counts.size(); ++i) {
+    seen += counts[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      uint64_t value = HighestValue(i);
+      // The max is exact, never report a value above it
+      uint64_t highest = Max();
+      return highest > 0 && value > highest ? highest : value;
+    }
+  }
+  return Max();
+}
@@ -0,0 +1,94 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Values below 2^HISTOGRAM_SUB_BUCKET_BITS are recorded exactly, above that each power of 2 range is split in half
+ * that number of buckets.
+ */
+const unsigned int HISTOGRAM_SUB_BUCKET_BITS = 7;
+const size_t HISTOGRAM_SUB_BUCKETS = 1 << HISTOGRAM_SUB_BUCKET_BITS;
+const size_t HISTOGRAM_BUCKETS = HISTOGRAM_SUB_BUCKETS + (64 - HISTOGRAM_SUB_BUCKET_BITS) * HISTOGRAM_SUB_BUCKETS / 2;
+
+/*
+ * Log-linear histogram of non negative integer values (e.g. latencies in nanoseconds), in the style of the
+ * HdrHistogram: each power of 2 range is split into a fixed number of linear sub buckets so that the relative error
+ * of the reported values is below 1/64 over the whole 64 bit range, with constant memory and O(1) recording.
+ *
+ * The histogram has a single writer (Record, Merge and Reset) while any thread can read it concurrently without
+ * locking: the counters are atomic and updated with relaxed stores, a concurrent reader may see a snapshot that
+ * is slightly behind the writer.
+ */
+class Histogram {
+ public:
+  Histogram();
+
+  /*
+   * Records a value (writer only).
+   */
+  void Record(uint64_t value) {
+    size_t index = Index(value);
+    counts[index].store(counts[index].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    total.store(total.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    sum.store(sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    if (value < min.load(std::memory_order_relaxed)) {
+      min.store(value, std::memory_order_relaxed);
+    }
+    if (value > max.load(std::memory_order_relaxed)) {
+      max.store(value, std::memory_order_relaxed);
+    }
+  }
+
+  /*
+   * Adds the values recorded by the given histogram (writer only).
+   */
+  void Merge(const Histogram &other);
+
+  /*
+   * Clears the recorded values (writer only).
+   */
+  void Reset();
+
+  uint64_t Count() const;
+
+  uint64_t Min() const;
+
+  uint64_t Max() const;
+
+  double Mean() const;
+
+  /*
+   * The value below which the given percentage of the recorded values fall, reported as the highest value
+   * equivalent to the bucket (i.e. never lower than the exact percentile).
+   *
+   * @param percentile The percentile in [0, 100]
+   *
+   * @return The percentile value, 0 if no value was recorded
+   */
+  uint64_t Percentile(double percentile) const;
+
+ private:
+  std::vector<std::atomic<uint64_t>> counts;
+  std::atomic<uint64_t> total;
+  std::atomic<uint64_t> sum;
+  std::atomic<uint64_t> min;
+  std::atomic<uint64_t> max;
+
+  static size_t Index(uint64_t value) {
+    if (value < HISTOGRAM_SUB_BUCKETS) {
+      return value;
+    }
+    unsigned int shift = (63 - __builtin_clzll(value)) - HISTOGRAM_SUB_BUCKET_BITS + 1;
+    return HISTOGRAM_SUB_BUCKETS + (shift - 1) * (HISTOGRAM_SUB_BUCKETS / 2) + (value >> shift) -
+           HISTOGRAM_SUB_BUCKETS / 2;
+  }
+
+  // Highest value that maps to the given bucket
+  static uint64_t HighestValue(size_t index);
+};
+
+#endif /* HISTOGRAM_H */
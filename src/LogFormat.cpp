@@ -0,0 +1,117 @@
+#include "LogFormat.h"
+#include <cmath>
+#include <cstring>
+#include "Format.h"
+
+// Max size of a formatted TSV record
+#define TSV_RECORD_SIZE (5 * (DOUBLE_BUFFER_SIZE + 1))
+
+template <typename T>
+static void append(std::vector<char> &out, const T *data, size_t count) {
+  const char *bytes = reinterpret_cast<const char *>(data);
+  out.insert(out.end(), bytes, bytes + count * sizeof(T));
+}
+
+static inline uint64_t raw_bits(double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+// Formats a field of the TSV log, the non finite values are written as nan, inf or -inf (readable by strtod) rather
+// than as the JSON null of FormatDouble
+static inline size_t format_field(double value, char *buffer) {
+  if (std::isnan(value)) {
+    memcpy(buffer, "nan", 3);
+    return 3;
+  }
+  if (std::isinf(value)) {
+    const char *text = value < 0 ? "-inf" : "inf";
+    size_t length = strlen(text);
+    memcpy(buffer, text, length);
+    return length;
+  }
+  return FormatDouble(value, buffer);
+}
+
+void TsvLogEncoder::Begin(std::vector<char> &out) {}
+
+void TsvLogEncoder::Append(const LogRecord &record, std::vector<char> &out) {
+  char buffer[TSV_RECORD_SIZE];
+  char *p = buffer;
+  p += format_field(record.speed, p);
+  *p++ = '\t';
+  p += format_field(record.angle, p);
+  *p++ = '\t';
+  p += format_field(record.cte, p);
+  *p++ = '\t';
+  p += format_field(record.steer_value, p);
+  *p++ = '\t';
+  p += format_field(record.throttle, p);
+  *p++ = '\n';
+  out.insert(out.end(), buffer, p);
+}
+
+void TsvLogEncoder::Finish(std::vector<char> &out) {}
+
+uint32_t TsvLogEncoder::Buffered() { return 0; }
+
+BinaryLogEncoder::BinaryLogEncoder(const std::vector<double> &gains, uint32_t block_capacity) {
+  this->gains = gains;
+  this->gains.resize(3, 0.0);
+  this->block_capacity = block_capacity;
+  this->block_cycle = 0;
+  this->count = 0;
+  for (unsigned int i = 0; i < LOG_COLUMNS; ++i) {
+    columns[i].resize(block_capacity);
+  }
+}
+
+void BinaryLogEncoder::Begin(std::vector<char> &out) {
+  BinaryLogHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, BINARY_LOG_MAGIC, sizeof(header.magic));
+  header.version = BINARY_LOG_VERSION;
+  header.columns = LOG_COLUMNS;
+  header.block_capacity = block_capacity;
+  for (unsigned int i = 0; i < 3; ++i) {
+    header.gains[i] = gains[i];
+  }
+  append(out, &header, 1);
+}
+
+void BinaryLogEncoder::Append(const LogRecord &record, std::vector<char> &out) {
+  // Blocks never span multiple cycles
+  if (count == block_capacity || (count > 0 && record.cycle != block_cycle)) {
+    Finish(out);
+  }
+
+  block_cycle = record.cycle;
+
+  columns[LOG_SPEED][count] = raw_bits(record.speed);
+  columns[LOG_ANGLE][count] = raw_bits(record.angle);
+  columns[LOG_CTE][count] = raw_bits(record.cte);
+  columns[LOG_STEER_VALUE][count] = raw_bits(record.steer_value);
+  columns[LOG_THROTTLE][count] = raw_bits(record.throttle);
+  columns[LOG_TIMESTAMP][count] = static_cast<uint64_t>(record.timestamp);
+
+  ++count;
+}
+
+void BinaryLogEncoder::Finish(std::vector<char> &out) {
+  if (count == 0) {
+    return;
+  }
+
+  BinaryLogBlockHeader header = {count, block_cycle};
+
+  append(out, &header, 1);
+
+  for (unsigned int i = 0; i < LOG_COLUMNS; ++i) {
+    append(out, columns[i].data(), count);
+  }
+
+  count = 0;
+}
+
+uint32_t BinaryLogEncoder::Buffered() { return count; }
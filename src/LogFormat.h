@@ -0,0 +1,119 @@
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "The binary log format is only supported on little-endian platforms"
+#endif
+
+/*
+ * Fixed size record for a single telemetry frame.
+ */
+struct LogRecord {
+  double speed;
+  double angle;
+  double cte;
+  double steer_value;
+  double throttle;
+  // Monotonic timestamp in nanoseconds
+  int64_t timestamp;
+  // Tuner cycle the record belongs to
+  uint32_t cycle;
+};
+
+enum class LogFormat {
+  TSV,    // Tab separated text: speed, angle, cte, steering value and throttle
+  BINARY  // Binary columnar format, see BinaryLogHeader
+};
+
+/*
+ * Columns of the binary log, each column is stored as an array of 8 bytes values within a block.
+ */
+enum LogColumn { LOG_SPEED, LOG_ANGLE, LOG_CTE, LOG_STEER_VALUE, LOG_THROTTLE, LOG_TIMESTAMP, LOG_COLUMNS };
+
+const char BINARY_LOG_MAGIC[8] = {'P', 'I', 'D', 'L', 'O', 'G', '\0', '\0'};
+const uint32_t BINARY_LOG_VERSION = 1;
+
+/*
+ * Header of the binary log file. The header is followed by a sequence of blocks, each block starts with a
+ * BinaryLogBlockHeader followed by LOG_COLUMNS column arrays of block_header.count little-endian values (doubles,
+ * except for the int64 timestamp column). A block never spans two tuner cycles, so that the cycle boundaries are
+ * block boundaries.
+ */
+struct BinaryLogHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t columns;
+  // Max number of records in a block
+  uint32_t block_capacity;
+  uint32_t reserved;
+  // Initial Kp, Ki and Kd coefficients
+  double gains[3];
+};
+
+struct BinaryLogBlockHeader {
+  uint32_t count;
+  uint32_t cycle;
+};
+
+/*
+ * Encodes log records into a byte buffer for the logger writer thread.
+ */
+class LogEncoder {
+ public:
+  virtual ~LogEncoder() {}
+
+  /*
+   * Appends the file header, if any.
+   */
+  virtual void Begin(std::vector<char> &out) = 0;
+
+  /*
+   * Encodes the record, the encoder may buffer records and append them later.
+   */
+  virtual void Append(const LogRecord &record, std::vector<char> &out) = 0;
+
+  /*
+   * Appends any buffered record.
+   */
+  virtual void Finish(std::vector<char> &out) = 0;
+
+  /*
+   * Number of records appended but still buffered by the encoder.
+   */
+  virtual uint32_t Buffered() = 0;
+};
+
+class TsvLogEncoder : public LogEncoder {
+ public:
+  void Begin(std::vector<char> &out) override;
+  void Append(const LogRecord &record, std::vector<char> &out) override;
+  void Finish(std::vector<char> &out) override;
+  uint32_t Buffered() override;
+};
+
+/*
+ * Buffers the records of the current block, which is appended once it is full, at the end of the cycle or by Finish.
+ */
+class BinaryLogEncoder : public LogEncoder {
+ public:
+  BinaryLogEncoder(const std::vector<double> &gains, uint32_t block_capacity);
+
+  void Begin(std::vector<char> &out) override;
+  void Append(const LogRecord &record, std::vector<char> &out) override;
+  void Finish(std::vector<char> &out) override;
+  uint32_t Buffered() override;
+
+ private:
+  std::vector<double> gains;
+  uint32_t block_capacity;
+  uint32_t block_cycle;
+  uint32_t count;
+  // Column buffers for the current block (timestamps are stored as raw 8 bytes values)
+  std::vector<uint64_t> columns[LOG_COLUMNS];
+};
+
+#endif /* LOG_FORMAT_H */
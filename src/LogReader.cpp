@@ -0,0 +1,399 @@
+#include "LogReader.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include "Format.h"
+
+// Size of the read buffer of the TSV stream, a line must fit in the buffer
+#define TSV_BUFFER_SIZE 65536
+// Max length of a field parsed with the generic parser
+#define FIELD_SIZE 64
+
+BinaryLogReader::BinaryLogReader() : data(nullptr), length(0), header(nullptr), records(0) {}
+
+BinaryLogReader::~BinaryLogReader() { Close(); }
+
+bool BinaryLogReader::Open(const std::string &file_name) {
+  Close();
+
+  int fd = open(file_name.c_str(), O_RDONLY);
+
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(BinaryLogHeader)) {
+    close(fd);
+    return false;
+  }
+
+  length = st.st_size;
+  data = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  // The mapping stays valid after the file is closed
+  close(fd);
+
+  if (data == MAP_FAILED) {
+    data = nullptr;
+    length = 0;
+    return false;
+  }
+
+  header = static_cast<const BinaryLogHeader *>(data);
+
+  if (memcmp(header->magic, BINARY_LOG_MAGIC, sizeof(header->magic)) != 0 || header->version != BINARY_LOG_VERSION ||
+      header->columns != LOG_COLUMNS) {
+    Close();
+    return false;
+  }
+
+  madvise(data, length, MADV_SEQUENTIAL);
+
+  const char *base = static_cast<const char *>(data);
+  size_t position = sizeof(BinaryLogHeader);
+
+  while (position + sizeof(BinaryLogBlockHeader) <= length) {
+    const BinaryLogBlockHeader *block_header = reinterpret_cast<const BinaryLogBlockHeader *>(base + position);
+    size_t column_size = block_header->count * sizeof(double);
+    size_t block_size = sizeof(BinaryLogBlockHeader) + LOG_COLUMNS * column_size;
+
+    if (block_header->count == 0 || block_header->count > header->block_capacity ||
+        position + block_size > length) {
+      // Truncated or corrupted block
+      break;
+    }
+
+    LogBlock block;
+    block.cycle = block_header->cycle;
+    block.offset = records;
+    block.count = block_header->count;
+
+    const char *column = base + position + sizeof(BinaryLogBlockHeader);
+
+    for (unsigned int i = 0; i < LOG_TIMESTAMP; ++i) {
+      block.columns[i] = reinterpret_cast<const double *>(column);
+      column += column_size;
+    }
+
+    block.timestamps = reinterpret_cast<const int64_t *>(column);
+
+    blocks.push_back(block);
+    records += block.count;
+    position += block_size;
+  }
+
+  return true;
+}
+
+void BinaryLogReader::Close() {
+  if (data != nullptr) {
+    munmap(data, length);
+  }
+  data = nullptr;
+  length = 0;
+  header = nullptr;
+  blocks.clear();
+  records = 0;
+}
+
+std::vector<double> BinaryLogReader::Gains() {
+  if (header == nullptr) {
+    return std::vector<double>();
+  }
+  return std::vector<double>(header->gains, header->gains + 3);
+}
+
+size_t BinaryLogReader::Records() { return records; }
+
+const std::vector<LogBlock> &BinaryLogReader::Blocks() { return blocks; }
+
+Span<double> BinaryLogReader::Column(size_t block, LogColumn column) {
+  return {blocks[block].columns[column], blocks[block].count};
+}
+
+Span<int64_t> BinaryLogReader::Timestamps(size_t block) { return {blocks[block].timestamps, blocks[block].count}; }
+
+std::vector<LogCycle> BinaryLogReader::Cycles() {
+  std::vector<LogCycle> cycles;
+  for (const LogBlock &block : blocks) {
+    if (!cycles.empty() && cycles.back().cycle == block.cycle) {
+      cycles.back().count += block.count;
+    } else {
+      cycles.push_back({block.cycle, block.offset, block.count});
+    }
+  }
+  return cycles;
+}
+
+LogRecord BinaryLogReader::Record(size_t block, size_t index) {
+  const LogBlock &b = blocks[block];
+  return {b.columns[LOG_SPEED][index],
+          b.columns[LOG_ANGLE][index],
+          b.columns[LOG_CTE][index],
+          b.columns[LOG_STEER_VALUE][index],
+          b.columns[LOG_THROTTLE][index],
+          b.timestamps[index],
+          b.cycle};
+}
+
+TsvLogStream::TsvLogStream() : fd(-1), failed(false), begin(0), end(0), line(0), eof(false) {}
+
+TsvLogStream::~TsvLogStream() {
+  if (fd >= 0) {
+    close(fd);
+  }
+}
+
+bool TsvLogStream::Open(const std::string &file_name) {
+  if (fd >= 0) {
+    close(fd);
+  }
+
+  fd = open(file_name.c_str(), O_RDONLY);
+
+  if (fd < 0) {
+    return false;
+  }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+  buffer.resize(TSV_BUFFER_SIZE);
+  begin = end = line = 0;
+  eof = false;
+  failed = false;
+
+  return true;
+}
+
+bool TsvLogStream::Fill() {
+  if (eof) {
+    return false;
+  }
+
+  // Moves the partial line at the start of the buffer
+  memmove(buffer.data(), buffer.data() + begin, end - begin);
+  end -= begin;
+  begin = 0;
+
+  if (end == buffer.size()) {
+    // Line too long
+    failed = true;
+    return false;
+  }
+
+  ssize_t result = read(fd, buffer.data() + end, buffer.size() - end);
+
+  if (result <= 0) {
+    eof = true;
+    return false;
+  }
+
+  end += result;
+
+  return true;
+}
+
+// Parses a field with the fast parser, falling back to strtod for numbers outside of its exact range and for nan and
+// inf. The null written for the non finite values by the previous versions of the logger is read as nan.
+static bool parse_field(const char *first, const char *last, double &value) {
+  if (ParseDecimal(first, last, value)) {
+    return true;
+  }
+  size_t length = last - first;
+  if (length == 4 && memcmp(first, "null", 4) == 0) {
+    value = NAN;
+    return true;
+  }
+  if (length == 0 || length >= FIELD_SIZE) {
+    return false;
+  }
+  char field[FIELD_SIZE];
+  memcpy(field, first, length);
+  field[length] = '\0';
+  char *parsed;
+  value = strtod(field, &parsed);
+  return parsed == field + length;
+}
+
+bool TsvLogStream::Next(LogRecord &record) {
+  if (fd < 0) {
+    return false;
+  }
+
+  while (true) {
+    const char *data = buffer.data();
+    const char *newline = static_cast<const char *>(memchr(data + begin, '\n', end - begin));
+    const char *line_end = newline;
+
+    if (newline == nullptr) {
+      if (Fill()) {
+        continue;
+      }
+      if (failed) {
+        return false;
+      }
+      // Last line without a trailing newline
+      if (begin == end) {
+        return false;
+      }
+      data = buffer.data();
+      line_end = data + end;
+    }
+
+    const char *p = data + begin;
+
+    begin = (newline == nullptr ? end : (line_end - data) + 1);
+    ++line;
+
+    double values[5];
+    unsigned int count = 0;
+
+    while (p < line_end && count < 5) {
+      while (p < line_end && (*p == '\t' || *p == ' ' || *p == '\r')) {
+        ++p;
+      }
+      const char *field = p;
+      while (p < line_end && *p != '\t' && *p != ' ' && *p != '\r') {
+        ++p;
+      }
+      if (p == field) {
+        break;
+      }
+      if (!parse_field(field, p, values[count++])) {
+        failed = true;
+        return false;
+      }
+    }
+
+    if (count == 0) {
+      // Empty line
+      continue;
+    }
+
+    if (count < 5) {
+      failed = true;
+      return false;
+    }
+
+    record = {values[0], values[1], values[2], values[3], values[4], 0, 0};
+
+    return true;
+  }
+}
+
+std::vector<double> TsvLogStream::Gains() { return std::vector<double>(); }
+
+bool TsvLogStream::Failed() { return failed; }
+
+size_t TsvLogStream::Line() { return line; }
+
+// Reads exactly the given number of bytes, false at the end of the file or on error
+static bool read_fully(int fd, void *data, size_t length) {
+  char *p = static_cast<char *>(data);
+  while (length > 0) {
+    ssize_t result = read(fd, p, length);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      return false;
+    }
+    p += result;
+    length -= result;
+  }
+  return true;
+}
+
+BinaryLogStream::BinaryLogStream() : fd(-1), block({0, 0}), index(0) { memset(&header, 0, sizeof(header)); }
+
+BinaryLogStream::~BinaryLogStream() {
+  if (fd >= 0) {
+    close(fd);
+  }
+}
+
+bool BinaryLogStream::Open(const std::string &file_name) {
+  if (fd >= 0) {
+    close(fd);
+  }
+
+  block = {0, 0};
+  index = 0;
+  fd = open(file_name.c_str(), O_RDONLY);
+
+  if (fd < 0) {
+    return false;
+  }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+  if (!read_fully(fd, &header, sizeof(header)) || memcmp(header.magic, BINARY_LOG_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != BINARY_LOG_VERSION || header.columns != LOG_COLUMNS) {
+    close(fd);
+    fd = -1;
+    return false;
+  }
+
+  return true;
+}
+
+bool BinaryLogStream::ReadBlock() {
+  if (!read_fully(fd, &block, sizeof(block)) || block.count == 0 || block.count > header.block_capacity) {
+    // End of the log, truncated or corrupted block
+    block.count = 0;
+    return false;
+  }
+
+  columns.resize(static_cast<size_t>(block.count) * LOG_COLUMNS);
+
+  if (!read_fully(fd, columns.data(), columns.size() * sizeof(uint64_t))) {
+    block.count = 0;
+    return false;
+  }
+
+  index = 0;
+
+  return true;
+}
+
+bool BinaryLogStream::Next(LogRecord &record) {
+  if (fd < 0 || (index >= block.count && !ReadBlock())) {
+    return false;
+  }
+
+  const uint64_t *values = columns.data() + index;
+  double doubles[LOG_TIMESTAMP];
+
+  for (unsigned int i = 0; i < LOG_TIMESTAMP; ++i) {
+    memcpy(&doubles[i], &values[i * block.count], sizeof(double));
+  }
+
+  record = {doubles[LOG_SPEED],
+            doubles[LOG_ANGLE],
+            doubles[LOG_CTE],
+            doubles[LOG_STEER_VALUE],
+            doubles[LOG_THROTTLE],
+            static_cast<int64_t>(values[LOG_TIMESTAMP * block.count]),
+            block.cycle};
+  ++index;
+
+  return true;
+}
+
+std::vector<double> BinaryLogStream::Gains() {
+  if (fd < 0) {
+    return std::vector<double>();
+  }
+  return std::vector<double>(header.gains, header.gains + 3);
+}
@@ -0,0 +1,187 @@
+#ifndef LOG_READER_H
+#define LOG_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "LogFormat.h"
+
+/*
+ * Read only view over a contiguous array, the data is not owned.
+ */
+template <typename T>
+struct Span {
+  const T *data;
+  size_t size;
+
+  const T *begin() const { return data; }
+  const T *end() const { return data + size; }
+  const T &operator[](size_t i) const { return data[i]; }
+};
+
+/*
+ * A block of the binary log, the columns point directly into the mapped file.
+ */
+struct LogBlock {
+  uint32_t cycle;
+  // Index of the first record of the block in the log
+  size_t offset;
+  size_t count;
+  const double *columns[LOG_TIMESTAMP];
+  const int64_t *timestamps;
+};
+
+/*
+ * Range of records that belong to a single tuner cycle.
+ */
+struct LogCycle {
+  uint32_t cycle;
+  size_t offset;
+  size_t count;
+};
+
+/*
+ * Reader for the binary log format, the file is memory mapped and the columns are exposed without copying the data.
+ */
+class BinaryLogReader {
+ public:
+  BinaryLogReader();
+
+  /*
+   * Destructor, unmaps the file.
+   */
+  virtual ~BinaryLogReader();
+
+  /*
+   * Maps the given file and indexes its blocks. A truncated trailing block (e.g. if the program was interrupted while
+   * writing) is ignored.
+   *
+   * @return False if the file could not be mapped or is not a valid binary log
+   */
+  bool Open(const std::string &file_name);
+
+  void Close();
+
+  /*
+   * The initial Kp, Ki and Kd coefficients.
+   */
+  std::vector<double> Gains();
+
+  /*
+   * Total number of records.
+   */
+  size_t Records();
+
+  const std::vector<LogBlock> &Blocks();
+
+  /*
+   * Values of the given column (except LOG_TIMESTAMP) for the block with the given index.
+   */
+  Span<double> Column(size_t block, LogColumn column);
+
+  Span<int64_t> Timestamps(size_t block);
+
+  /*
+   * The cycle boundaries, consecutive blocks of the same cycle are merged.
+   */
+  std::vector<LogCycle> Cycles();
+
+  /*
+   * Reads the record at the given index (offset within the given block).
+   */
+  LogRecord Record(size_t block, size_t index);
+
+ private:
+  void *data;
+  size_t length;
+  const BinaryLogHeader *header;
+  std::vector<LogBlock> blocks;
+  size_t records;
+};
+
+/*
+ * Sequential reader of log records, with constant memory usage regardless of the size of the log.
+ */
+class LogStream {
+ public:
+  virtual ~LogStream() {}
+
+  virtual bool Open(const std::string &file_name) = 0;
+
+  /*
+   * Reads the next record.
+   *
+   * @return False at the end of the log (or on a malformed line for the TSV format)
+   */
+  virtual bool Next(LogRecord &record) = 0;
+
+  /*
+   * The initial coefficients if stored in the log, empty otherwise.
+   */
+  virtual std::vector<double> Gains() = 0;
+
+  /*
+   * True if the stream stopped before the end of the log because of malformed content.
+   */
+  virtual bool Failed() { return false; }
+};
+
+/*
+ * Streams a TSV log through a fixed size buffer. The timestamp and cycle of the records are not available and are
+ * set to zero.
+ */
+class TsvLogStream : public LogStream {
+ public:
+  TsvLogStream();
+
+  virtual ~TsvLogStream();
+
+  bool Open(const std::string &file_name) override;
+  bool Next(LogRecord &record) override;
+  std::vector<double> Gains() override;
+  bool Failed() override;
+
+  /*
+   * Line number of the last line read.
+   */
+  size_t Line();
+
+ private:
+  int fd;
+  bool failed;
+  std::vector<char> buffer;
+  size_t begin;
+  size_t end;
+  size_t line;
+  bool eof;
+
+  bool Fill();
+};
+
+/*
+ * Streams a binary log, reading one block at a time: the memory usage is bounded by the block capacity. As for the
+ * BinaryLogReader, a truncated trailing block ends the stream.
+ */
+class BinaryLogStream : public LogStream {
+ public:
+  BinaryLogStream();
+
+  virtual ~BinaryLogStream();
+
+  bool Open(const std::string &file_name) override;
+  bool Next(LogRecord &record) override;
+  std::vector<double> Gains() override;
+
+ private:
+  int fd;
+  BinaryLogHeader header;
+  BinaryLogBlockHeader block;
+  // Columns of the current block, one after the other
+  std::vector<uint64_t> columns;
+  size_t index;
+
+  bool ReadBlock();
+};
+
+#endif /* LOG_READER_H */
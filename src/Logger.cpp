@@ -0,0 +1,229 @@
+#include "Logger.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// Size of the batch buffer, written as soon as it is full regardless of the flush interval
+#define BATCH_SIZE 65536
+// Max interval (ms) between checks of the queue from the writer thread
+#define POLL_INTERVAL 10
+
+Logger::Logger(LoggerSettings settings) : settings(settings), queue(settings.capacity) {
+  this->stop = false;
+  this->is_open = false;
+  this->pushed = 0;
+  this->dropped = 0;
+  this->dropped_base = 0;
+  this->written = 0;
+}
+
+Logger::~Logger() {
+  Close();
+
+  {
+    lock_guard<mutex> lock(files_mutex);
+    stop = true;
+  }
+
+  files_signal.notify_one();
+  if (writer.joinable()) {
+    writer.join();
+  }
+}
+
+bool Logger::Open(const string &file_name, const vector<double> &gains) {
+  if (IsOpen()) {
+    return false;
+  }
+
+  int fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+  if (fd < 0) {
+    return false;
+  }
+
+  LogEncoder *encoder;
+
+  if (settings.format == LogFormat::BINARY) {
+    encoder = new BinaryLogEncoder(gains, settings.block_capacity);
+  } else {
+    encoder = new TsvLogEncoder();
+  }
+
+  dropped_base = dropped.load(memory_order_relaxed);
+
+  {
+    lock_guard<mutex> lock(files_mutex);
+    files.emplace_back(fd, encoder);
+  }
+
+  files_signal.notify_one();
+
+  if (!writer.joinable()) {
+    writer = thread(&Logger::Run, this);
+  }
+
+  is_open = true;
+
+  return true;
+}
+
+void Logger::Close() {
+  if (!IsOpen()) {
+    return;
+  }
+
+  {
+    lock_guard<mutex> lock(files_mutex);
+    LogFile &file = files.back();
+    file.dropped = Dropped();
+    // The records pushed so far are visible to the writer thread once it sees the end
+    file.end.store(pushed, memory_order_release);
+  }
+
+  files_signal.notify_one();
+  is_open = false;
+}
+
+bool Logger::IsOpen() { return is_open; }
+
+bool Logger::Log(const LogRecord &record) {
+  if (!queue.Push(record)) {
+    dropped.fetch_add(1, memory_order_relaxed);
+    return false;
+  }
+  ++pushed;
+  return true;
+}
+
+uint64_t Logger::Dropped() {
+  return dropped.load(memory_order_relaxed) - dropped_base.load(memory_order_relaxed);
+}
+
+uint64_t Logger::Written() { return written.load(memory_order_relaxed); }
+
+size_t Logger::Pending() { return queue.Size(); }
+
+int64_t Logger::Now() {
+  return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Logger::Run() {
+  vector<char> batch;
+  batch.reserve(BATCH_SIZE);
+  uint64_t reported_dropped = 0;
+  uint64_t popped = 0;
+  // Record popped past the end of the current file, the first one of the next file
+  LogRecord record;
+  bool has_record = false;
+
+  auto poll_interval = chrono::milliseconds(min<unsigned int>(POLL_INTERVAL, max(1u, settings.flush_interval)));
+  auto flush_interval = chrono::milliseconds(settings.flush_interval);
+
+  while (true) {
+    LogFile *file;
+
+    {
+      unique_lock<mutex> lock(files_mutex);
+      files_signal.wait(lock, [this] { return !files.empty() || stop; });
+      if (files.empty()) {
+        break;
+      }
+      // The references to the front are not invalidated by the files opened meanwhile
+      file = &files.front();
+    }
+
+    uint64_t appended = 0;
+    auto last_flush = chrono::steady_clock::now();
+
+    written = 0;
+    file->encoder->Begin(batch);
+
+    while (true) {
+      // The end is read after the pop: a record pushed after the file was closed always sees its end
+      while (has_record || queue.Pop(record)) {
+        has_record = true;
+        if (popped >= file->end.load(memory_order_acquire)) {
+          break;
+        }
+        has_record = false;
+        ++popped;
+        file->encoder->Append(record, batch);
+        ++appended;
+        if (batch.size() >= BATCH_SIZE) {
+          Flush(*file, batch, appended, false);
+        }
+      }
+
+      uint64_t current_dropped = dropped.load(memory_order_relaxed);
+
+      if (current_dropped != reported_dropped) {
+        cout << "[Warning]: Logger queue full, " << (current_dropped - reported_dropped) << " records dropped" << endl;
+        reported_dropped = current_dropped;
+      }
+
+      // Every record of a closed file was pushed before its end was set
+      if (popped == file->end.load(memory_order_acquire)) {
+        break;
+      }
+
+      auto now = chrono::steady_clock::now();
+
+      // Only the encoded output is flushed, the block being filled by the binary encoder stays open
+      if (!batch.empty() && now - last_flush >= flush_interval) {
+        Flush(*file, batch, appended, true);
+        last_flush = now;
+      }
+
+      unique_lock<mutex> lock(files_mutex);
+      files_signal.wait_for(lock, poll_interval, [file] { return file->end.load(memory_order_acquire) != UINT64_MAX; });
+    }
+
+    file->encoder->Finish(batch);
+    Flush(*file, batch, appended, true);
+    close(file->fd);
+
+    if (file->dropped > 0) {
+      cout << "[Warning]: Logger dropped " << file->dropped << " records" << endl;
+    }
+
+    lock_guard<mutex> lock(files_mutex);
+    files.pop_front();
+  }
+}
+
+void Logger::Flush(LogFile &file, vector<char> &batch, uint64_t appended, bool sync) {
+  if (!batch.empty() && Write(file.fd, batch.data(), batch.size()) && sync &&
+      settings.durability == LogDurability::SYNC) {
+#ifdef __APPLE__
+    fsync(file.fd);
+#else
+    fdatasync(file.fd);
+#endif
+  }
+
+  written.store(appended - file.encoder->Buffered(), memory_order_relaxed);
+  batch.clear();
+}
+
+bool Logger::Write(int fd, const char *data, size_t length) {
+  while (length > 0) {
+    ssize_t result = write(fd, data, length);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      cerr << "[Error]: Could not write log: " << strerror(errno) << endl;
+      return false;
+    }
+    data += result;
+    length -= result;
+  }
+  return true;
+}
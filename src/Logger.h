@@ -0,0 +1,139 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LogFormat.h"
+#include "RingBuffer.h"
+
+/*
+ * Durability of the records written by the logger.
+ */
+enum class LogDurability {
+  BUFFERED,  // Batches are written to the OS page cache
+  SYNC       // Each batch is synced to the disk (fdatasync)
+};
+
+struct LoggerSettings {
+  // Number of records that can be queued before the logger starts dropping them
+  size_t capacity;
+  // Max amount of time (ms) an encoded record is kept in memory before the batch is written, the records of the
+  // block being filled by the binary encoder are written with the block
+  unsigned int flush_interval;
+  LogDurability durability;
+  LogFormat format;
+  // Max number of records in a block of the binary format, a block is written once full or at the end of the cycle
+  uint32_t block_capacity;
+
+  LoggerSettings()
+      : capacity(8192),
+        flush_interval(100),
+        durability(LogDurability::BUFFERED),
+        format(LogFormat::TSV),
+        block_capacity(4096) {}
+};
+
+/*
+ * Asynchronous logger for the telemetry records. The event loop pushes records into a lock-free ring buffer and a
+ * dedicated writer thread encodes them (see LogFormat) and writes them to disk in batches. Logging never blocks the
+ * caller: when the ring buffer is full the record is dropped and counted. The writer thread outlives the files: closing
+ * a file only marks the end of its records, the writer thread writes them and closes the file, so that the event loop
+ * never waits for the disk.
+ */
+class Logger {
+ public:
+  Logger(LoggerSettings settings);
+
+  /*
+   * Destructor, closes the logger if still open and waits for the writer thread to close the files.
+   */
+  virtual ~Logger();
+
+  /*
+   * Opens the file for writing, starts the writer thread on the first call.
+   *
+   * @param file_name The name of the log file
+   * @param gains The initial coefficients, stored in the header of the binary format
+   *
+   * @return False if the file could not be opened
+   */
+  bool Open(const std::string &file_name, const std::vector<double> &gains);
+
+  /*
+   * Marks the end of the records of the file, never waits: the writer thread writes the pending records and closes
+   * the file.
+   */
+  void Close();
+
+  bool IsOpen();
+
+  /*
+   * Queues a record for writing, never blocks.
+   *
+   * @return False if the queue was full and the record was dropped
+   */
+  bool Log(const LogRecord &record);
+
+  /*
+   * Number of records dropped since the logger was opened.
+   */
+  uint64_t Dropped();
+
+  /*
+   * Number of records written since the logger was opened.
+   */
+  uint64_t Written();
+
+  /*
+   * Number of records waiting to be written.
+   */
+  size_t Pending();
+
+  /*
+   * Current monotonic time in nanoseconds, to be used as record timestamp.
+   */
+  static int64_t Now();
+
+ private:
+  LoggerSettings settings;
+  RingBuffer<LogRecord> queue;
+
+  struct LogFile {
+    int fd;
+    std::unique_ptr<LogEncoder> encoder;
+    // Number of records pushed when the file was closed, i.e. the end of its records in the queue (max while open)
+    std::atomic<uint64_t> end;
+    // Set before the end, printed by the writer thread
+    uint64_t dropped;
+
+    LogFile(int fd, LogEncoder *encoder) : fd(fd), encoder(encoder), end(UINT64_MAX), dropped(0) {}
+  };
+
+  // Open files, the writer thread writes the front one and closes it once it reaches its end
+  std::deque<LogFile> files;
+  std::thread writer;
+  std::mutex files_mutex;
+  std::condition_variable files_signal;
+  bool stop;
+
+  // Event loop only
+  bool is_open;
+  uint64_t pushed;
+
+  std::atomic<uint64_t> dropped;
+  std::atomic<uint64_t> dropped_base;
+  std::atomic<uint64_t> written;
+
+  void Run();
+  void Flush(LogFile &file, std::vector<char> &batch, uint64_t appended, bool sync);
+  bool Write(int fd, const char *data, size_t length);
+};
+
+#endif /* LOGGER_H */
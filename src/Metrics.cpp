@@ -0,0 +1,167 @@
+#include "Metrics.h"
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include "Format.h"
+#include "Session.h"
+
+using namespace std;
+
+struct SessionMetrics {
+  unsigned int id;
+  ControllerSnapshot snapshot;
+  size_t log_pending;
+  uint64_t log_dropped;
+};
+
+#ifdef PID_PROFILE
+static const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+#endif
+
+static string format_value(double value) {
+  if (std::isnan(value)) {
+    return "NaN";
+  }
+  if (std::isinf(value)) {
+    return value > 0 ? "+Inf" : "-Inf";
+  }
+  char buffer[DOUBLE_BUFFER_SIZE];
+  return string(buffer, FormatDouble(value, buffer));
+}
+
+static void header(ostringstream &oss, const char *name, const char *type, const char *help) {
+  oss << "# HELP " << name << " " << help << "\n";
+  oss << "# TYPE " << name << " " << type << "\n";
+}
+
+Metrics::Metrics() : last_frames(0), last_scrape(chrono::steady_clock::now()) {}
+
+Metrics::~Metrics() {}
+
+string Metrics::Render() {
+  SessionCounts totals = {0, 0, 0, 0, 0};
+  vector<SessionMetrics> active;
+  double frames_rate;
+#ifdef PID_PROFILE
+  unique_ptr<StageProfiler> profile(new StageProfiler());
+#endif
+
+  // Only the values are copied under the locks, the quantiles and the text are computed after releasing them
+  {
+    lock_guard<mutex> lock(scrape_mutex);
+
+    // Totals over all the sessions, including the idle ones so that the counters never decrease
+    SessionPool::ForEachSession(
+        [&](Session &session) {
+          SessionStats &stats = session.Stats();
+          totals.frames += stats.frames;
+          totals.manual_frames += stats.manual_frames;
+          totals.fallback_frames += stats.fallback_frames;
+          totals.parse_errors += stats.parse_errors;
+          totals.resets += stats.resets;
+          if (session.IsActive()) {
+            Logger &logger = session.GetLogger();
+            active.push_back({session.Id(), session.Snapshot(), logger.Pending(), logger.Dropped()});
+#ifdef PID_PROFILE
+            profile->Merge(*session.GetProfiler());
+#endif
+          }
+        },
+        false);
+
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    double elapsed = chrono::duration<double>(now - last_scrape).count();
+    frames_rate = elapsed > 0 ? (totals.frames - last_frames) / elapsed : 0.0;
+    last_frames = totals.frames;
+    last_scrape = now;
+  }
+
+  ostringstream oss;
+
+  header(oss, "pid_sessions_active", "gauge", "Number of connected simulators.");
+  oss << "pid_sessions_active " << active.size() << "\n";
+
+  header(oss, "pid_frames_total", "counter", "Telemetry frames processed.");
+  oss << "pid_frames_total " << totals.frames << "\n";
+
+  header(oss, "pid_frames_per_second", "gauge", "Telemetry frames processed per second since the previous scrape.");
+  oss << "pid_frames_per_second " << format_value(frames_rate) << "\n";
+
+  header(oss, "pid_manual_frames_total", "counter", "Frames received while the simulator is in manual mode.");
+  oss << "pid_manual_frames_total " << totals.manual_frames << "\n";
+
+  header(oss, "pid_fallback_frames_total", "counter", "Frames decoded through the generic JSON parser.");
+  oss << "pid_fallback_frames_total " << totals.fallback_frames << "\n";
+
+  header(oss, "pid_parse_errors_total", "counter", "Frames that could not be parsed.");
+  oss << "pid_parse_errors_total " << totals.parse_errors << "\n";
+
+  header(oss, "pid_resets_total", "counter", "Simulator resets requested at the end of a tuning cycle.");
+  oss << "pid_resets_total " << totals.resets << "\n";
+
+  header(oss, "pid_tuning", "gauge", "1 if the session is tuning the coefficients.");
+  for (const SessionMetrics &session : active) {
+    oss << "pid_tuning{session=\"" << session.id << "\"} " << session.snapshot.tuning << "\n";
+  }
+
+  header(oss, "pid_tuner_cycle", "gauge", "Current tuning cycle.");
+  for (const SessionMetrics &session : active) {
+    oss << "pid_tuner_cycle{session=\"" << session.id << "\"} " << session.snapshot.cycle << "\n";
+  }
+
+  header(oss, "pid_tuner_best_error", "gauge", "Average squared CTE of the best tuning cycle.");
+  for (const SessionMetrics &session : active) {
+    double best_err = session.snapshot.best_err;
+    if (best_err == numeric_limits<double>::max()) {
+      best_err = numeric_limits<double>::infinity();
+    }
+    oss << "pid_tuner_best_error{session=\"" << session.id << "\"} " << format_value(best_err) << "\n";
+  }
+
+  header(oss, "pid_tuner_steps_saved", "gauge", "Simulator steps saved by the early termination of tuning cycles.");
+  for (const SessionMetrics &session : active) {
+    oss << "pid_tuner_steps_saved{session=\"" << session.id << "\"} " << session.snapshot.steps_saved << "\n";
+  }
+
+  header(oss, "pid_tuner_avg_warmup_steps", "gauge", "Average warmup steps of the tuning cycles.");
+  for (const SessionMetrics &session : active) {
+    oss << "pid_tuner_avg_warmup_steps{session=\"" << session.id << "\"} "
+        << format_value(session.snapshot.avg_warmup) << "\n";
+  }
+
+  header(oss, "pid_gain", "gauge", "Current controller coefficients.");
+  for (const SessionMetrics &session : active) {
+    const char *terms[] = {"kp", "ki", "kd"};
+    for (unsigned int i = 0; i < 3; ++i) {
+      oss << "pid_gain{session=\"" << session.id << "\",term=\"" << terms[i] << "\"} "
+          << format_value(session.snapshot.gains[i]) << "\n";
+    }
+  }
+
+  header(oss, "pid_log_queue_depth", "gauge", "Records waiting for the log writer thread.");
+  for (const SessionMetrics &session : active) {
+    oss << "pid_log_queue_depth{session=\"" << session.id << "\"} " << session.log_pending << "\n";
+  }
+
+  header(oss, "pid_log_dropped", "gauge", "Log records dropped by the current connection.");
+  for (const SessionMetrics &session : active) {
+    oss << "pid_log_dropped{session=\"" << session.id << "\"} " << session.log_dropped << "\n";
+  }
+
+#ifdef PID_PROFILE
+  header(oss, "pid_stage_latency_seconds", "gauge", "Latency quantiles of the frame handling stages.");
+  for (unsigned int i = 0; i < STAGES; ++i) {
+    ProfileStage stage = static_cast<ProfileStage>(i);
+    if (profile->Stage(stage).Count() == 0) {
+      continue;
+    }
+    for (double quantile : QUANTILES) {
+      oss << "pid_stage_latency_seconds{stage=\"" << STAGE_NAMES[i] << "\",quantile=\"" << format_value(quantile)
+          << "\"} " << format_value(profile->Percentile(stage, quantile * 100.0) * 1e-9) << "\n";
+    }
+  }
+#endif
+
+  return oss.str();
+}
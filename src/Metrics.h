@@ -0,0 +1,33 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+/*
+ * Renders the metrics of all the sessions of the process in the Prometheus text format. The values are read from
+ * the session counters, snapshots and histograms without blocking the event loops, the lock only serializes the
+ * copies of the values of concurrent scrapes (that can be served by different event loops), the metrics are
+ * formatted after releasing it.
+ */
+class Metrics {
+ public:
+  Metrics();
+
+  virtual ~Metrics();
+
+  /*
+   * @return The metrics in the Prometheus text exposition format (version 0.0.4)
+   */
+  std::string Render();
+
+ private:
+  std::mutex scrape_mutex;
+  // Frames and time of the previous scrape, for the frames/s gauge
+  uint64_t last_frames;
+  std::chrono::steady_clock::time_point last_scrape;
+};
+
+#endif /* METRICS_H */
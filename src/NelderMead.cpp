@@ -0,0 +1,282 @@
+#include "NelderMead.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+using namespace std;
+
+// Standard coefficients
+#define REFLECTION 1.0
+#define EXPANSION 2.0
+#define CONTRACTION 0.5
+#define SHRINKAGE 0.5
+
+// Relative size of the initial simplex
+#define INITIAL_STEP 0.1
+
+NelderMead::NelderMead(const vector<double> &params, double tolerance) {
+  this->origin = params;
+  for (unsigned int i = 0; i < params.size(); ++i) {
+    if (params[i] != 0) {
+      dims.push_back(i);
+    }
+  }
+
+  size_t m = dims.size();
+
+  simplex.assign(m + 1, vector<double>(m, 1.0));
+  for (unsigned int k = 1; k <= m; ++k) {
+    simplex[k][k - 1] += INITIAL_STEP;
+  }
+  errors.assign(m + 1, numeric_limits<double>::max());
+  reflected.assign(m, 1.0);
+  reflected_err = numeric_limits<double>::max();
+  point.assign(m, 1.0);
+
+  this->phase = INIT;
+  this->vertex = 0;
+  this->pending = false;
+  this->next_id = 0;
+  this->best_params = params;
+  this->best_err = numeric_limits<double>::max();
+  this->tolerance = tolerance;
+}
+
+NelderMead::~NelderMead() {}
+
+bool NelderMead::Propose(Candidate &candidate) {
+  if (pending) {
+    return false;
+  }
+  NextPoint();
+  pending = true;
+  candidate.id = next_id++;
+  candidate.params = ToParams(point);
+  candidate.fidelity = 1.0;
+  return true;
+}
+
+void NelderMead::NextPoint() {
+  size_t m = dims.size();
+
+  if (phase == INIT) {
+    point = simplex[vertex];
+    return;
+  }
+
+  if (phase == SHRINK) {
+    for (unsigned int d = 0; d < m; ++d) {
+      point[d] = simplex[0][d] + SHRINKAGE * (simplex[vertex][d] - simplex[0][d]);
+    }
+    return;
+  }
+
+  vector<double> centroid;
+  Centroid(centroid);
+
+  for (unsigned int d = 0; d < m; ++d) {
+    double c = centroid[d];
+    switch (phase) {
+      case REFLECT:
+        point[d] = c + REFLECTION * (c - simplex[m][d]);
+        break;
+      case EXPAND:
+        point[d] = c + EXPANSION * (reflected[d] - c);
+        break;
+      case CONTRACT_OUTSIDE:
+        point[d] = c + CONTRACTION * (reflected[d] - c);
+        break;
+      default:
+        point[d] = c + CONTRACTION * (simplex[m][d] - c);
+        break;
+    }
+  }
+}
+
+void NelderMead::Report(const Candidate &candidate, double error) {
+  if (!pending || candidate.id + 1 != next_id) {
+    return;
+  }
+
+  pending = false;
+
+  if (error < best_err) {
+    best_err = error;
+    best_params = candidate.params;
+  }
+
+  size_t m = dims.size();
+
+  switch (phase) {
+    case INIT:
+      simplex[vertex] = point;
+      errors[vertex] = error;
+      if (++vertex > m) {
+        Sort();
+        phase = REFLECT;
+        vertex = 0;
+      }
+      break;
+    case REFLECT:
+      if (error < errors[0]) {
+        reflected = point;
+        reflected_err = error;
+        phase = EXPAND;
+      } else if (m == 0 || error < errors[m - 1]) {
+        Replace(point, error);
+      } else if (error < errors[m]) {
+        reflected = point;
+        reflected_err = error;
+        phase = CONTRACT_OUTSIDE;
+      } else {
+        phase = CONTRACT_INSIDE;
+      }
+      break;
+    case EXPAND:
+      if (error < reflected_err) {
+        Replace(point, error);
+      } else {
+        Replace(reflected, reflected_err);
+      }
+      phase = REFLECT;
+      break;
+    case CONTRACT_OUTSIDE:
+    case CONTRACT_INSIDE:
+      if (phase == CONTRACT_OUTSIDE ? error <= reflected_err : error < errors[m]) {
+        Replace(point, error);
+        phase = REFLECT;
+      } else {
+        phase = SHRINK;
+        vertex = 1;
+      }
+      break;
+    case SHRINK:
+      simplex[vertex] = point;
+      errors[vertex] = error;
+      if (++vertex > m) {
+        Sort();
+        phase = REFLECT;
+        vertex = 0;
+      }
+      break;
+  }
+}
+
+void NelderMead::Centroid(vector<double> &centroid) {
+  size_t m = dims.size();
+  centroid.assign(m, 0.0);
+  // All the vertices but the worst one
+  for (unsigned int k = 0; k < m; ++k) {
+    for (unsigned int d = 0; d < m; ++d) {
+      centroid[d] += simplex[k][d] / m;
+    }
+  }
+}
+
+void NelderMead::Sort() {
+  vector<unsigned int> order(simplex.size());
+  iota(order.begin(), order.end(), 0);
+  stable_sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) { return errors[a] < errors[b]; });
+
+  vector<vector<double>> sorted_simplex;
+  vector<double> sorted_errors;
+  for (unsigned int k : order) {
+    sorted_simplex.push_back(simplex[k]);
+    sorted_errors.push_back(errors[k]);
+  }
+  simplex.swap(sorted_simplex);
+  errors.swap(sorted_errors);
+}
+
+void NelderMead::Replace(const vector<double> &vertex, double error) {
+  // Replaces the worst vertex
+  simplex.back() = vertex;
+  errors.back() = error;
+  Sort();
+}
+
+vector<double> NelderMead::ToParams(const vector<double> &vertex) {
+  vector<double> params = origin;
+  for (unsigned int d = 0; d < dims.size(); ++d) {
+    params[dims[d]] = origin[dims[d]] * vertex[d];
+  }
+  return params;
+}
+
+bool NelderMead::Converged() {
+  if (phase == INIT) {
+    return dims.empty();
+  }
+  double size = 0.0;
+  for (unsigned int k = 1; k < simplex.size(); ++k) {
+    for (unsigned int d = 0; d < dims.size(); ++d) {
+      size = fmax(size, fabs(simplex[k][d] - simplex[0][d]));
+    }
+  }
+  return size <= tolerance;
+}
+
+vector<double> NelderMead::BestParams() { return best_params; }
+
+double NelderMead::BestError() { return best_err; }
+
+void NelderMead::Save(vector<double> &state) {
+  state.clear();
+  state.push_back(phase);
+  state.push_back(vertex);
+  state.push_back(reflected_err);
+  state.push_back(best_err);
+  state.insert(state.end(), best_params.begin(), best_params.end());
+  for (const vector<double> &v : simplex) {
+    state.insert(state.end(), v.begin(), v.end());
+  }
+  state.insert(state.end(), errors.begin(), errors.end());
+  state.insert(state.end(), reflected.begin(), reflected.end());
+}
+
+bool NelderMead::Restore(const vector<double> &state) {
+  size_t n = origin.size();
+  size_t m = dims.size();
+
+  if (state.size() != 4 + n + (m + 1) * m + (m + 1) + m || state[0] < INIT || state[0] > SHRINK || state[1] < 0 ||
+      state[1] > m) {
+    return false;
+  }
+
+  const double *p = state.data();
+
+  phase = static_cast<Phase>(static_cast<int>(*p++));
+  vertex = static_cast<unsigned int>(*p++);
+  reflected_err = *p++;
+  best_err = *p++;
+  for (unsigned int i = 0; i < n; ++i) {
+    best_params[i] = *p++;
+  }
+  for (vector<double> &v : simplex) {
+    for (unsigned int d = 0; d < m; ++d) {
+      v[d] = *p++;
+    }
+  }
+  for (unsigned int k = 0; k <= m; ++k) {
+    errors[k] = *p++;
+  }
+  for (unsigned int d = 0; d < m; ++d) {
+    reflected[d] = *p++;
+  }
+  pending = false;
+
+  return true;
+}
+
+void NelderMead::GetState(vector<OptimizerValue> &state) {
+  static const char *PHASE_NAMES[] = {"init", "reflect", "expand", "contract (outside)", "contract (inside)",
+                                      "shrink"};
+  state.resize(2);
+  state[0].name = "Simplex step";
+  state[0].values.clear();
+  state[0].text = PHASE_NAMES[phase];
+  state[1].name = "Simplex errors";
+  state[1].values = errors;
+  state[1].text.clear();
+}
@@ -0,0 +1,75 @@
+#ifndef NELDER_MEAD_H
+#define NELDER_MEAD_H
+
+#include <vector>
+#include "Optimizer.h"
+
+/*
+ * Nelder-Mead simplex search (reflection, expansion, contraction and shrink with the standard coefficients). The
+ * search runs on the parameters relative to the initial ones, so that coefficients of very different magnitudes
+ * (e.g. Ki and Kd) move at the same relative pace, and the initial simplex is the initial parameters plus each
+ * vertex with one parameter increased by 10% (as the first twiddle deltas). Converges when all the vertices are
+ * within the relative tolerance of the best one. A single candidate is evaluated at a time.
+ */
+class NelderMead : public Optimizer {
+ public:
+  /*
+   * @param params The initial parameters
+   * @param tolerance Relative size of the simplex at convergence
+   */
+  NelderMead(const std::vector<double> &params, double tolerance);
+
+  virtual ~NelderMead();
+
+  bool Propose(Candidate &candidate);
+
+  void Report(const Candidate &candidate, double error);
+
+  bool Converged();
+
+  std::vector<double> BestParams();
+
+  double BestError();
+
+  void Save(std::vector<double> &state);
+
+  bool Restore(const std::vector<double> &state);
+
+  void GetState(std::vector<OptimizerValue> &state);
+
+ private:
+  enum Phase { INIT, REFLECT, EXPAND, CONTRACT_OUTSIDE, CONTRACT_INSIDE, SHRINK };
+
+  // Initial parameters, the scale of the search
+  std::vector<double> origin;
+  // Indexes of the parameters that are tuned
+  std::vector<unsigned int> dims;
+
+  // Vertices (relative coordinates) and their errors, sorted by error once initialized
+  std::vector<std::vector<double>> simplex;
+  std::vector<double> errors;
+
+  // Reflected point and its error
+  std::vector<double> reflected;
+  double reflected_err;
+  // Point being evaluated
+  std::vector<double> point;
+
+  Phase phase;
+  // Vertex being evaluated in the INIT and SHRINK phases
+  unsigned int vertex;
+  bool pending;
+  unsigned int next_id;
+
+  std::vector<double> best_params;
+  double best_err;
+  double tolerance;
+
+  void NextPoint();
+  void Centroid(std::vector<double> &centroid);
+  void Sort();
+  void Replace(const std::vector<double> &vertex, double error);
+  std::vector<double> ToParams(const std::vector<double> &vertex);
+};
+
+#endif /* NELDER_MEAD_H */
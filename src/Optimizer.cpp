@@ -0,0 +1,107 @@
+#include "Optimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include "BayesOpt.h"
+#include "CmaEs.h"
+#include "NelderMead.h"
+#include "SuccessiveHalving.h"
+#include "Twiddle.h"
+
+using namespace std;
+
+#define PRINT_INDENT 19
+
+// Sum of the deltas at the convergence of twiddle
+#define TWIDDLE_TOLERANCE 0.05
+// Relative size of the simplex at the convergence of Nelder-Mead
+#define NELDER_MEAD_TOLERANCE 0.01
+// Relative standard deviation at the convergence of CMA-ES
+#define CMA_ES_TOLERANCE 0.01
+// Fixed seed, the runs are reproducible
+#define CMA_ES_SEED 1
+// Noise of the evaluations relative to the variance of the log errors
+#define BAYES_OPT_NOISE 0.01
+// Expected improvement of the log error at the convergence of the Bayesian optimization
+#define BAYES_OPT_TOLERANCE 0.01
+// Evaluations of the Bayesian optimization, each one costs a lap of the Udacity simulator
+#define BAYES_OPT_BUDGET 100
+#define BAYES_OPT_SEED 1
+// Brackets of 9 candidates on cycles of 1/9 of the steps, the best 3 on 1/3 and the best one on a full cycle
+#define HALVING_BRACKET_SIZE 9
+#define HALVING_ETA 3
+#define HALVING_RUNGS 3
+// Spread of the samples at the convergence of the successive halving
+#define HALVING_TOLERANCE 0.02
+#define HALVING_SEED 1
+
+unique_ptr<Optimizer> CreateOptimizer(OptimizerType type, const vector<double> &params, unsigned int population) {
+  switch (type) {
+    case OptimizerType::NELDER_MEAD:
+      return unique_ptr<Optimizer>(new NelderMead(params, NELDER_MEAD_TOLERANCE));
+    case OptimizerType::CMA_ES:
+      return unique_ptr<Optimizer>(new CmaEs(params, population, CMA_ES_TOLERANCE, CMA_ES_SEED));
+    case OptimizerType::BAYES_OPT:
+      return unique_ptr<Optimizer>(new BayesOpt(params, BAYES_OPT_NOISE, BAYES_OPT_TOLERANCE, BAYES_OPT_BUDGET,
+                                                BAYES_OPT_SEED));
+    case OptimizerType::HALVING:
+      return unique_ptr<Optimizer>(new SuccessiveHalving(params, HALVING_BRACKET_SIZE, HALVING_ETA, HALVING_RUNGS,
+                                                         HALVING_TOLERANCE, HALVING_SEED));
+    default:
+      return unique_ptr<Optimizer>(new Twiddle(params, TWIDDLE_TOLERANCE));
+  }
+}
+
+bool AcceptsLowerBounds(OptimizerType type) { return type == OptimizerType::TWIDDLE; }
+
+unsigned int FidelitySteps(unsigned int steps, double fidelity) {
+  return max(1u, static_cast<unsigned int>(round(steps * fidelity)));
+}
+
+bool ParseOptimizerType(const string &name, OptimizerType &type) {
+  if (name == "twiddle") {
+    type = OptimizerType::TWIDDLE;
+  } else if (name == "nelder-mead") {
+    type = OptimizerType::NELDER_MEAD;
+  } else if (name == "cma-es") {
+    type = OptimizerType::CMA_ES;
+  } else if (name == "bayes-opt") {
+    type = OptimizerType::BAYES_OPT;
+  } else if (name == "halving") {
+    type = OptimizerType::HALVING;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+string OptimizerName(OptimizerType type) {
+  switch (type) {
+    case OptimizerType::NELDER_MEAD:
+      return "nelder-mead";
+    case OptimizerType::CMA_ES:
+      return "cma-es";
+    case OptimizerType::BAYES_OPT:
+      return "bayes-opt";
+    case OptimizerType::HALVING:
+      return "halving";
+    default:
+      return "twiddle";
+  }
+}
+
+string FormatOptimizerState(const vector<OptimizerValue> &state) {
+  ostringstream out;
+  for (const OptimizerValue &value : state) {
+    out << setw(PRINT_INDENT) << value.name + ": ";
+    if (!value.text.empty()) {
+      out << value.text;
+    }
+    for (double v : value.values) {
+      out << v << " ";
+    }
+    out << endl;
+  }
+  return out.str();
+}
@@ -0,0 +1,136 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * A parameter vector proposed for evaluation.
+ */
+struct Candidate {
+  // Assigned by the optimizer, identifies the candidate when its result is reported
+  unsigned int id;
+  std::vector<double> params;
+  // Fraction of a full evaluation (e.g. of the steps of a tuning cycle) to spend on the candidate, the errors of the
+  // evaluations of different fidelities are not comparable
+  double fidelity;
+};
+
+/*
+ * A named value of the internal state of an optimizer (e.g. the step sizes), for the progress reports.
+ */
+struct OptimizerValue {
+  std::string name;
+  std::vector<double> values;
+  // Non numeric value (e.g. the name of a phase), empty otherwise
+  std::string text;
+};
+
+/*
+ * Black box minimization of the error of the Kp, Ki and Kd coefficients, driven by the caller through an ask and tell
+ * loop: the caller asks for a candidate (Propose), evaluates it (e.g. a tuning cycle on the simulator) and reports
+ * the error (Report) until the optimizer converges. Parameters that are zero in the initial vector are not tuned.
+ */
+class Optimizer {
+ public:
+  virtual ~Optimizer() {}
+
+  /*
+   * Proposes the next candidate to evaluate.
+   *
+   * @param candidate Output candidate, set only if the function returns true
+   *
+   * @return False if no candidate can be proposed until the pending ones are reported
+   */
+  virtual bool Propose(Candidate &candidate) = 0;
+
+  /*
+   * Reports the error of a proposed candidate.
+   */
+  virtual void Report(const Candidate &candidate, double error) = 0;
+
+  virtual bool Converged() = 0;
+
+  virtual std::vector<double> BestParams() = 0;
+
+  /*
+   * The error of the best candidate, max double if no candidate was reported.
+   */
+  virtual double BestError() = 0;
+
+  /*
+   * Saves the state of the optimizer (see Restore), the pending candidates are not included and are proposed again
+   * after a restore.
+   */
+  virtual void Save(std::vector<double> &state) = 0;
+
+  /*
+   * Restores a state saved by an optimizer of the same type and with the same number of parameters.
+   *
+   * @return False if the state is not valid for this optimizer
+   */
+  virtual bool Restore(const std::vector<double> &state) = 0;
+
+  /*
+   * The internal state (e.g. the step sizes) for the progress reports, reusing the storage of the given vector.
+   */
+  virtual void GetState(std::vector<OptimizerValue> &state) = 0;
+};
+
+enum class OptimizerType {
+  // Coordinate descent with adaptive step sizes (the original tuner)
+  TWIDDLE,
+  // Nelder-Mead simplex
+  NELDER_MEAD,
+  // Covariance matrix adaptation evolution strategy, proposes a population of candidates at a time
+  CMA_ES,
+  // Bayesian optimization with a Gaussian process surrogate, for the expensive evaluations
+  BAYES_OPT,
+  // Successive halving, evaluates many candidates on short cycles and only the best ones on full cycles
+  HALVING
+};
+
+/*
+ * Creates an optimizer of the given type starting from the given parameters.
+ *
+ * @param population Candidates of a generation of the population based optimizers, 0 uses their default
+ */
+std::unique_ptr<Optimizer> CreateOptimizer(OptimizerType type, const std::vector<double> &params,
+                                           unsigned int population = 0);
+
+/*
+ * Parses the name of an optimizer type as used on the command line (e.g. "nelder-mead").
+ *
+ * @return False if the name is not known
+ */
+bool ParseOptimizerType(const std::string &name, OptimizerType &type);
+
+std::string OptimizerName(OptimizerType type);
+
+/*
+ * Formats the state of an optimizer for the console, a line per value.
+ */
+std::string FormatOptimizerState(const std::vector<OptimizerValue> &state);
+
+/*
+ * Whether the optimizer of the given type can be told a lower bound of the error in place of the error, for the
+ * evaluations ended early (see EarlyAbort): only twiddle, which just compares an error with the best one. The others
+ * use the values of the errors (the simplex ordering of Nelder-Mead, the ranking of CMA-ES and successive halving, the
+ * surrogate of BayesOpt) and would take the bound for a measured error.
+ */
+bool AcceptsLowerBounds(OptimizerType type);
+
+/*
+ * Number of steps of an evaluation of the given fidelity, out of the steps of a full evaluation (at least one).
+ */
+unsigned int FidelitySteps(unsigned int steps, double fidelity);
+
+/*
+ * Evaluates a candidate parameter vector with the given fidelity returning its error, must be safe to call
+ * concurrently.
+ */
+typedef std::function<double(const std::vector<double> &params, double fidelity)> Evaluator;
+
+#endif /* OPTIMIZER_H */
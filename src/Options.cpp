@@ -0,0 +1,10 @@
+#include "Options.h"
+
+bool ReadOption(const std::string &arg, const std::string &name, std::string &value) {
+  std::string prefix = "--" + name + "=";
+  if (arg.compare(0, prefix.length(), prefix) != 0) {
+    return false;
+  }
+  value = arg.substr(prefix.length());
+  return true;
+}
@@ -0,0 +1,34 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <sstream>
+#include <string>
+
+/*
+ * Reads a command line option in the form --name=value.
+ *
+ * @param arg The command line argument
+ * @param name The name of the option (without the leading --)
+ * @param value Output value of the option, set only if the argument matches
+ *
+ * @return True if the argument matches the option name
+ */
+bool ReadOption(const std::string &arg, const std::string &name, std::string &value);
+
+/*
+ * Parses the whole string into the given value.
+ *
+ * @return False if the string could not be parsed
+ */
+template <typename T>
+bool ParseValue(const std::string &str, T &value) {
+  std::istringstream iss(str);
+  T result;
+  if (!(iss >> result) || !iss.eof()) {
+    return false;
+  }
+  value = result;
+  return true;
+}
+
+#endif /* OPTIONS_H */
@@ -26,3 +26,9 @@ void PID::UpdateError(double cte) {
 }
 
 double PID::TotalError() { return -Kp * p_error - Kd * d_error - Ki * i_error; }
+
+double PID::GetKp() { return Kp; }
+
+double PID::GetKi() { return Ki; }
+
+double PID::GetKd() { return Kd; }
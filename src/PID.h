@@ -34,6 +34,13 @@ class PID {
    */
   double TotalError();
 
+  /*
+   * The current coefficients.
+   */
+  double GetKp();
+  double GetKi();
+  double GetKd();
+
  private:
   /*
    * Errors for proportional, integral and derivative values
@@ -0,0 +1,74 @@
+#include "Profiler.h"
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+#define PRINT_INDENT 19
+#define CALIBRATION_MS 20
+
+const char *const STAGE_NAMES[STAGES] = {"decode", "tune", "pid", "print", "log", "encode", "send", "frame"};
+
+// Set once by CalibrateTicks, before the threads that read it are started
+static double ticks_per_ns = 1.0;
+
+void CalibrateTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+  auto clock_start = chrono::steady_clock::now();
+  uint64_t ticks_start = ReadTicks();
+  while (chrono::steady_clock::now() - clock_start < chrono::milliseconds(CALIBRATION_MS)) {
+  }
+  uint64_t ticks = ReadTicks() - ticks_start;
+  double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - clock_start).count();
+  ticks_per_ns = ticks / ns;
+#endif
+}
+
+double TicksPerNs() { return ticks_per_ns; }
+
+StageProfiler::StageProfiler() : start(0), last(0), period(1), countdown(1), sampling(false) {}
+
+void StageProfiler::SetPeriod(unsigned int period) {
+  this->period = period == 0 ? 1 : period;
+  countdown = 1;
+}
+
+void StageProfiler::Reset() {
+  countdown = 1;
+  sampling = false;
+  for (Histogram &stage : stages) {
+    stage.Reset();
+  }
+}
+
+void StageProfiler::Merge(const StageProfiler &other) {
+  for (unsigned int i = 0; i < STAGES; ++i) {
+    stages[i].Merge(other.stages[i]);
+  }
+}
+
+const Histogram &StageProfiler::Stage(ProfileStage stage) const { return stages[stage]; }
+
+double StageProfiler::Percentile(ProfileStage stage, double percentile) const {
+  return stages[stage].Percentile(percentile) / TicksPerNs();
+}
+
+string StageProfiler::Summary() const {
+  double scale = 1.0 / TicksPerNs();
+  ostringstream oss;
+  oss << fixed << setprecision(0);
+  oss << setw(PRINT_INDENT) << "Stage (ns): " << setw(10) << "count" << setw(10) << "mean" << setw(10) << "p50"
+      << setw(10) << "p99" << setw(10) << "p99.9" << setw(10) << "max" << endl;
+  for (unsigned int i = 0; i < STAGES; ++i) {
+    const Histogram &stage = stages[i];
+    if (stage.Count() == 0) {
+      continue;
+    }
+    oss << setw(PRINT_INDENT) << (string(STAGE_NAMES[i]) + ": ") << setw(10) << stage.Count() << setw(10)
+        << stage.Mean() * scale << setw(10) << stage.Percentile(50.0) * scale << setw(10)
+        << stage.Percentile(99.0) * scale << setw(10) << stage.Percentile(99.9) * scale << setw(10)
+        << stage.Max() * scale << endl;
+  }
+  return oss.str();
+}
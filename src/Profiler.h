@@ -0,0 +1,164 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <string>
+#include "Histogram.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+/*
+ * Stages of the handling of a telemetry frame, in order.
+ */
+enum ProfileStage {
+  STAGE_DECODE,  // Frame decoding
+  STAGE_TUNE,    // Tuner::Tune (only when tuning)
+  STAGE_PID,     // PID UpdateError and TotalError, throttle
+  STAGE_PRINT,   // Console status snapshot (Session::Observe)
+  STAGE_LOG,     // Queuing the log record
+  STAGE_ENCODE,  // Encoding the reply
+  STAGE_SEND,    // ws.send
+  STAGE_FRAME,   // The whole frame
+  STAGES
+};
+
+extern const char *const STAGE_NAMES[STAGES];
+
+/*
+ * Reads the time stamp counter on x86 (a few ns, assumes an invariant TSC as on any recent CPU), the monotonic clock
+ * in nanoseconds elsewhere.
+ */
+inline uint64_t ReadTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+/*
+ * Calibrates the ticks against the monotonic clock, busy waiting for 20 ms on x86. To be called once at startup,
+ * before the event loops start.
+ */
+void CalibrateTicks();
+
+/*
+ * Number of ticks (as returned by ReadTicks) per nanosecond, as calibrated by CalibrateTicks.
+ */
+double TicksPerNs();
+
+/*
+ * Per stage latency histograms of the frame handling. The profiler is updated by the event loop thread only and can
+ * be read from any thread without locking (see Histogram). The values are recorded in ticks and converted to
+ * nanoseconds when reported.
+ *
+ * The profiler is enabled by the PID_PROFILE definition (see the CMake option), otherwise the PROFILE_* macros
+ * compile to nothing.
+ */
+class StageProfiler {
+ public:
+  StageProfiler();
+
+  /*
+   * Sets the sampling period, only one frame every period frames is profiled.
+   */
+  void SetPeriod(unsigned int period);
+
+  /*
+   * Starts the profiling of a frame.
+   */
+  void Start() {
+    if (--countdown == 0) {
+      countdown = period;
+      sampling = true;
+      start = last = ReadTicks();
+    } else {
+      sampling = false;
+    }
+  }
+
+  /*
+   * Ends the given stage, the time since the end of the previous stage (or the start of the frame) is recorded.
+   */
+  void Mark(ProfileStage stage) {
+    if (!sampling) {
+      return;
+    }
+    uint64_t now = ReadTicks();
+    stages[stage].Record(now - last);
+    last = now;
+  }
+
+  /*
+   * Ends the profiling of a frame, recording the whole frame time.
+   */
+  void End() {
+    if (sampling) {
+      stages[STAGE_FRAME].Record(ReadTicks() - start);
+      sampling = false;
+    }
+  }
+
+  /*
+   * Clears the histograms (event loop thread only).
+   */
+  void Reset();
+
+  /*
+   * Adds the histograms of the given profiler (the profiler must not be in use by an event loop).
+   */
+  void Merge(const StageProfiler &other);
+
+  const Histogram &Stage(ProfileStage stage) const;
+
+  /*
+   * The given percentile of a stage, in nanoseconds.
+   */
+  double Percentile(ProfileStage stage, double percentile) const;
+
+  /*
+   * Prints count, mean and percentiles (in nanoseconds) of each stage that was recorded.
+   */
+  std::string Summary() const;
+
+ private:
+  Histogram stages[STAGES];
+  uint64_t start;
+  uint64_t last;
+  unsigned int period;
+  unsigned int countdown;
+  bool sampling;
+};
+
+// The profiler argument is a pointer, nothing is recorded if null
+#ifdef PID_PROFILE
+#define PROFILE_START(profiler)  \
+  do {                           \
+    if ((profiler) != nullptr) { \
+      (profiler)->Start();       \
+    }                            \
+  } while (0)
+#define PROFILE_MARK(profiler, stage) \
+  do {                                \
+    if ((profiler) != nullptr) {      \
+      (profiler)->Mark(stage);        \
+    }                                 \
+  } while (0)
+#define PROFILE_END(profiler)    \
+  do {                           \
+    if ((profiler) != nullptr) { \
+      (profiler)->End();         \
+    }                            \
+  } while (0)
+#else
+#define PROFILE_START(profiler)
+#define PROFILE_MARK(profiler, stage)
+#define PROFILE_END(profiler)
+#endif
+
+#endif /* PROFILER_H */
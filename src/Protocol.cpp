@@ -0,0 +1,271 @@
+#include "Protocol.h"
+#include "Format.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+static const char TELEMETRY_EVENT[] = "\"telemetry\"";
+static const char NULL_VALUE[] = "null";
+
+static const char RESET_MESSAGE[] = "42[\"reset\",{}]";
+static const char MANUAL_MESSAGE[] = "42[\"manual\",{}]";
+static const char STEER_PREFIX[] = "42[\"steer\",{\"steering_angle\":";
+static const char THROTTLE_KEY[] = ",\"throttle\":";
+static const char STEER_SUFFIX[] = "}]";
+
+const Frame RESET_FRAME = {RESET_MESSAGE, sizeof(RESET_MESSAGE) - 1};
+const Frame MANUAL_FRAME = {MANUAL_MESSAGE, sizeof(MANUAL_MESSAGE) - 1};
+
+static inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+static inline bool is_space(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+static inline const char *skip_space(const char *p, const char *end) {
+  while (p != end && is_space(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+static inline bool starts_with(const char *p, const char *end, const char *prefix, size_t prefix_length) {
+  return static_cast<size_t>(end - p) >= prefix_length && memcmp(p, prefix, prefix_length) == 0;
+}
+
+// Scans a string starting at the opening quote, on success returns the pointer past the closing quote and sets the
+// content range. Escaped strings are skipped correctly but flagged so that keys containing escapes are not matched.
+static const char *scan_string(const char *p, const char *end, const char *&begin, const char *&last, bool &escaped) {
+  if (p == end || *p != '"') {
+    return nullptr;
+  }
+  begin = ++p;
+  escaped = false;
+  while (p != end) {
+    if (*p == '\\') {
+      escaped = true;
+      if (++p == end) {
+        return nullptr;
+      }
+    } else if (*p == '"') {
+      last = p;
+      return p + 1;
+    }
+    ++p;
+  }
+  return nullptr;
+}
+
+// Skips any JSON value (string, number, literal, object or array), returns nullptr on malformed input
+static const char *skip_value(const char *p, const char *end) {
+  if (p == end) {
+    return nullptr;
+  }
+  const char *begin;
+  const char *last;
+  bool escaped;
+  if (*p == '"') {
+    return scan_string(p, end, begin, last, escaped);
+  }
+  if (*p == '{' || *p == '[') {
+    int depth = 0;
+    while (p != end) {
+      if (*p == '"') {
+        p = scan_string(p, end, begin, last, escaped);
+        if (p == nullptr) {
+          return nullptr;
+        }
+        continue;
+      }
+      if (*p == '{' || *p == '[') {
+        ++depth;
+      } else if ((*p == '}' || *p == ']') && --depth == 0) {
+        return p + 1;
+      }
+      ++p;
+    }
+    return nullptr;
+  }
+  // Numbers and literals
+  const char *start = p;
+  while (p != end && *p != ',' && *p != '}' && *p != ']' && !is_space(*p)) {
+    ++p;
+  }
+  return p == start ? nullptr : p;
+}
+
+// Parses a numeric value that can be either quoted (as sent by the simulator) or a plain JSON number
+static const char *parse_number_value(const char *p, const char *end, double &value) {
+  const char *begin;
+  const char *last;
+  if (p != end && *p == '"') {
+    bool escaped;
+    p = scan_string(p, end, begin, last, escaped);
+    if (p == nullptr || escaped) {
+      return nullptr;
+    }
+  } else {
+    begin = p;
+    while (p != end && (is_digit(*p) || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E')) {
+      ++p;
+    }
+    last = p;
+  }
+  return ParseDecimal(begin, last, value) ? p : nullptr;
+}
+
+FrameType DecodeFrame(const char *data, size_t length, Telemetry &telemetry) {
+  // "42" at the start of the message means there's a websocket message event.
+  // The 4 signifies a websocket message
+  // The 2 signifies a websocket event
+  if (length <= 2 || data[0] != '4' || data[1] != '2') {
+    return FrameType::INVALID;
+  }
+
+  const char *end = data + length;
+  const char *p = skip_space(data + 2, end);
+
+  if (p == end || *p != '[') {
+    return FrameType::UNKNOWN;
+  }
+
+  p = skip_space(p + 1, end);
+
+  if (!starts_with(p, end, TELEMETRY_EVENT, sizeof(TELEMETRY_EVENT) - 1)) {
+    return FrameType::UNKNOWN;
+  }
+
+  p = skip_space(p + sizeof(TELEMETRY_EVENT) - 1, end);
+
+  if (p == end || *p != ',') {
+    return FrameType::UNKNOWN;
+  }
+
+  p = skip_space(p + 1, end);
+
+  if (starts_with(p, end, NULL_VALUE, sizeof(NULL_VALUE) - 1)) {
+    return FrameType::MANUAL;
+  }
+
+  if (p == end || *p != '{') {
+    return FrameType::UNKNOWN;
+  }
+
+  const unsigned int CTE = 1, SPEED = 2, ANGLE = 4;
+  unsigned int found = 0;
+  Telemetry values;
+
+  p = skip_space(p + 1, end);
+
+  while (p != end && *p != '}') {
+    const char *key;
+    const char *key_end;
+    bool escaped;
+
+    p = scan_string(p, end, key, key_end, escaped);
+    if (p == nullptr || escaped) {
+      return FrameType::UNKNOWN;
+    }
+
+    p = skip_space(p, end);
+    if (p == end || *p != ':') {
+      return FrameType::UNKNOWN;
+    }
+    p = skip_space(p + 1, end);
+
+    size_t key_length = key_end - key;
+    double *target = nullptr;
+    unsigned int flag = 0;
+
+    if (key_length == 3 && memcmp(key, "cte", 3) == 0) {
+      target = &values.cte;
+      flag = CTE;
+    } else if (key_length == 5 && memcmp(key, "speed", 5) == 0) {
+      target = &values.speed;
+      flag = SPEED;
+    } else if (key_length == 14 && memcmp(key, "steering_angle", 14) == 0) {
+      target = &values.angle;
+      flag = ANGLE;
+    }
+
+    p = target == nullptr ? skip_value(p, end) : parse_number_value(p, end, *target);
+
+    if (p == nullptr) {
+      return FrameType::UNKNOWN;
+    }
+
+    found |= flag;
+
+    p = skip_space(p, end);
+    if (p != end && *p == ',') {
+      p = skip_space(p + 1, end);
+    } else if (p == end || *p != '}') {
+      return FrameType::UNKNOWN;
+    }
+  }
+
+  if (p == end || found != (CTE | SPEED | ANGLE)) {
+    return FrameType::UNKNOWN;
+  }
+
+  p = skip_space(p + 1, end);
+
+  if (p == end || *p != ']') {
+    return FrameType::UNKNOWN;
+  }
+
+  telemetry = values;
+
+  return FrameType::TELEMETRY;
+}
+
+// Checks if the SocketIO event has JSON data.
+// If there is data the JSON object in string format will be returned,
+// else the empty string "" will be returned.
+static std::string hasData(std::string s) {
+  auto found_null = s.find("null");
+  auto b1 = s.find_first_of("[");
+  auto b2 = s.find_last_of("]");
+  if (found_null != std::string::npos) {
+    return "";
+  } else if (b1 != std::string::npos && b2 != std::string::npos) {
+    return s.substr(b1, b2 - b1 + 1);
+  }
+  return "";
+}
+
+FrameType DecodeFrameJson(const char *data, size_t length, Telemetry &telemetry) {
+  if (length <= 2 || data[0] != '4' || data[1] != '2') {
+    return FrameType::INVALID;
+  }
+  auto s = hasData(std::string(data, length));
+  if (s == "") {
+    return FrameType::MANUAL;
+  }
+  auto j = json::parse(s);
+  std::string event = j[0].get<std::string>();
+  if (event != "telemetry") {
+    return FrameType::UNKNOWN;
+  }
+  // j[1] is the data JSON object
+  telemetry.cte = std::stod(j[1]["cte"].get<std::string>());
+  telemetry.speed = std::stod(j[1]["speed"].get<std::string>());
+  telemetry.angle = std::stod(j[1]["steering_angle"].get<std::string>());
+  return FrameType::TELEMETRY;
+}
+
+Frame SteerEncoder::Encode(double steer_value, double throttle) {
+  char *p = buffer;
+
+  memcpy(p, STEER_PREFIX, sizeof(STEER_PREFIX) - 1);
+  p += sizeof(STEER_PREFIX) - 1;
+  p += FormatDouble(steer_value, p);
+  memcpy(p, THROTTLE_KEY, sizeof(THROTTLE_KEY) - 1);
+  p += sizeof(THROTTLE_KEY) - 1;
+  p += FormatDouble(throttle, p);
+  memcpy(p, STEER_SUFFIX, sizeof(STEER_SUFFIX) - 1);
+  p += sizeof(STEER_SUFFIX) - 1;
+
+  return {buffer, static_cast<size_t>(p - buffer)};
+}
@@ -0,0 +1,83 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <cstddef>
+
+/*
+ * Values carried by a "telemetry" event sent by the simulator.
+ */
+struct Telemetry {
+  double cte;
+  double speed;
+  double angle;
+};
+
+/*
+ * Result of decoding a SocketIO frame received from the simulator.
+ */
+enum class FrameType {
+  TELEMETRY,  // Telemetry event with data, the Telemetry values are set
+  MANUAL,     // Event without data, the simulator is in manual mode
+  UNKNOWN,    // Event shape not handled by the decoder, or the event is not a telemetry event
+  INVALID     // Not a SocketIO event message (does not start with "42")
+};
+
+/*
+ * Decodes a SocketIO frame directly from the buffer received by the websocket with a single forward scan and
+ * without any heap allocation. Frames that the decoder does not understand (e.g. unexpected layout, escaped keys or
+ * numbers outside of the fast parsing path) are reported as UNKNOWN and should be decoded with DecodeFrameJson.
+ *
+ * @param data The buffer with the frame content, not required to be null terminated
+ * @param length The length of the frame
+ * @param telemetry Output telemetry values, set only if the result is TELEMETRY
+ */
+FrameType DecodeFrame(const char *data, size_t length, Telemetry &telemetry);
+
+/*
+ * Decodes a SocketIO frame using the generic JSON parser, this is the (slower) fallback path for any frame that is
+ * not recognized by DecodeFrame. Note that json parsing errors are propagated as exceptions.
+ *
+ * @param data The buffer with the frame content, not required to be null terminated
+ * @param length The length of the frame
+ * @param telemetry Output telemetry values, set only if the result is TELEMETRY
+ */
+FrameType DecodeFrameJson(const char *data, size_t length, Telemetry &telemetry);
+
+/*
+ * A SocketIO frame ready to be sent through the websocket.
+ */
+struct Frame {
+  const char *data;
+  size_t length;
+};
+
+/*
+ * Pre-built frames for the messages that do not carry any data.
+ */
+extern const Frame RESET_FRAME;
+extern const Frame MANUAL_FRAME;
+
+/*
+ * Size of the buffer used to encode a "steer" frame, enough for the frame with the longest formatted values.
+ */
+const size_t STEER_FRAME_SIZE = 128;
+
+/*
+ * Encodes "steer" replies into a reusable fixed buffer, without any heap allocation.
+ */
+class SteerEncoder {
+ public:
+  /*
+   * Encodes the "steer" frame with the given values, the returned frame points to the internal buffer and is valid
+   * until the next call.
+   *
+   * @param steer_value The steering value in [-1, 1]
+   * @param throttle The throttle value
+   */
+  Frame Encode(double steer_value, double throttle);
+
+ private:
+  char buffer[STEER_FRAME_SIZE];
+};
+
+#endif /* PROTOCOL_H */
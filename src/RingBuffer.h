@@ -0,0 +1,97 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#define CACHE_LINE_SIZE 64
+
+/*
+ * Bounded lock-free single producer single consumer queue. Push is only called by the producer thread and Pop only by
+ * the consumer thread, neither of them ever blocks or allocates.
+ */
+template <typename T>
+class RingBuffer {
+ public:
+  /*
+   * Creates a ring buffer that can hold at least the given number of items (rounded up to a power of 2).
+   */
+  explicit RingBuffer(size_t capacity) : head(0), cached_tail(0), tail(0), cached_head(0) {
+    size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    buffer.resize(size);
+    mask = size - 1;
+  }
+
+  /*
+   * Pushes an item in the queue (producer only).
+   *
+   * @return False if the queue is full and the item was not pushed
+   */
+  bool Push(const T &item) {
+    const size_t t = tail.load(std::memory_order_relaxed);
+    if (t - cached_head > mask) {
+      cached_head = head.load(std::memory_order_acquire);
+      if (t - cached_head > mask) {
+        return false;
+      }
+    }
+    buffer[t & mask] = item;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  /*
+   * Pops an item from the queue (consumer only).
+   *
+   * @return False if the queue is empty
+   */
+  bool Pop(T &item) {
+    const size_t h = head.load(std::memory_order_relaxed);
+    if (h == cached_tail) {
+      cached_tail = tail.load(std::memory_order_acquire);
+      if (h == cached_tail) {
+        return false;
+      }
+    }
+    item = buffer[h & mask];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  /*
+   * Approximate number of items in the queue, can be called from any thread.
+   */
+  size_t Size() const {
+    const size_t h = head.load(std::memory_order_acquire);
+    const size_t t = tail.load(std::memory_order_acquire);
+    return t - h;
+  }
+
+  size_t Capacity() const { return mask + 1; }
+
+ private:
+  std::vector<T> buffer;
+  size_t mask;
+
+  // The indexes are padded to separate cache lines, to avoid false sharing between producer and consumer (padding
+  // rather than alignas so that the buffer can be heap allocated without over-aligned new)
+  char padding0[CACHE_LINE_SIZE];
+
+  // Written by the consumer
+  std::atomic<size_t> head;
+  // Consumer local copy of tail
+  size_t cached_tail;
+  char padding1[CACHE_LINE_SIZE];
+
+  // Written by the producer
+  std::atomic<size_t> tail;
+  // Producer local copy of head
+  size_t cached_head;
+  char padding2[CACHE_LINE_SIZE];
+};
+
+#endif /* RING_BUFFER_H */
@@ -0,0 +1,38 @@
+#ifndef RUNNING_STATS_H
+#define RUNNING_STATS_H
+
+/*
+ * Mean and variance of all the values added so far, updated without keeping the values (Welford's algorithm).
+ */
+class RunningStats {
+ public:
+  RunningStats() { Clear(); }
+
+  void Clear() {
+    count = 0;
+    mean = 0.0;
+    m2 = 0.0;
+  }
+
+  void Add(double value) {
+    double delta = value - mean;
+    mean += delta / ++count;
+    m2 += delta * (value - mean);
+  }
+
+  unsigned int Count() const { return count; }
+
+  double Mean() const { return mean; }
+
+  /*
+   * Sample variance of the values, 0 with less than 2 values.
+   */
+  double Variance() const { return count < 2 ? 0.0 : m2 / (count - 1); }
+
+ private:
+  unsigned int count;
+  double mean;
+  double m2;
+};
+
+#endif /* RUNNING_STATS_H */
@@ -0,0 +1,67 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/*
+ * Sequence lock protecting a small trivially copyable value with a single writer: the writer never waits and the
+ * readers retry until they read a consistent copy. The value is stored as relaxed atomic words so that the
+ * concurrent accesses are well defined.
+ */
+template <typename T>
+class Seqlock {
+  static_assert(sizeof(T) % sizeof(uint64_t) == 0, "The size of the value must be a multiple of 8 bytes");
+
+ public:
+  Seqlock() : sequence(0) {
+    for (std::atomic<uint64_t> &word : words) {
+      word.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /*
+   * Publishes a new value (writer only).
+   */
+  void Store(const T &value) {
+    uint64_t data[WORDS];
+    memcpy(data, &value, sizeof(T));
+    uint64_t s = sequence.load(std::memory_order_relaxed);
+    sequence.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < WORDS; ++i) {
+      words[i].store(data[i], std::memory_order_relaxed);
+    }
+    sequence.store(s + 2, std::memory_order_release);
+  }
+
+  /*
+   * Reads a consistent copy of the last published value, from any thread.
+   */
+  T Load() const {
+    uint64_t data[WORDS];
+    uint64_t before;
+    uint64_t after;
+    do {
+      before = sequence.load(std::memory_order_acquire);
+      for (size_t i = 0; i < WORDS; ++i) {
+        data[i] = words[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+    T value;
+    memcpy(&value, data, sizeof(T));
+    return value;
+  }
+
+ private:
+  static const size_t WORDS = sizeof(T) / sizeof(uint64_t);
+
+  std::atomic<uint64_t> sequence;
+  std::atomic<uint64_t> words[WORDS];
+};
+
+#endif /* SEQLOCK_H */
@@ -0,0 +1,417 @@
+#include "Session.h"
+#include <math.h>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+#define PRINT_INDENT 19
+
+Session::Session(const SessionSettings &settings)
+    : settings(settings),
+      id(0),
+      active(false),
+      tuning_session(false),
+      controller(settings.params, 0),
+      logger(settings.log_settings),
+      checkpoint_writer(nullptr),
+      eval_store(nullptr),
+      has_last_frame(false),
+      window_started(false) {
+  this->start_counts = {0, 0, 0, 0, 0};
+#ifdef PID_PROFILE
+  profiler.SetPeriod(settings.profile_period);
+  controller.SetProfiler(&profiler);
+#endif
+}
+
+Session::~Session() { Stop(); }
+
+bool Session::Start(unsigned int id, const string &file_name, bool tune, CheckpointWriter *checkpoint_writer,
+                    EvalStore *eval_store, const string &events_name) {
+  this->id = id;
+  this->tuning_session = tune && settings.max_steps > 0;
+  this->start_counts = {stats.frames, stats.manual_frames, stats.fallback_frames, stats.parse_errors, stats.resets};
+
+  controller.Reset(settings.params, tuning_session ? settings.max_steps : 0);
+  controller.GetTuner().SetOptimizer(settings.optimizer);
+  controller.GetTuner().SetEarlyAbort(settings.early_abort);
+  controller.GetTuner().SetRepeats(settings.max_repeats, settings.repeat_alpha);
+  controller.GetTuner().SetWarmup(settings.warmup);
+  controller.GetTuner().SetContinuous(settings.continuous);
+  has_last_frame = false;
+  window_started = false;
+  current_status = {0.0, 0.0, 0.0, 0.0, 0.0, 0, 0.0, 0.0, 0.0, 0, 0.0};
+  status.Store(current_status);
+
+  this->checkpoint_writer = tuning_session ? checkpoint_writer : nullptr;
+
+  // The latest checkpoint is the resumed one or the one of a previous connection to the pool
+  if (this->checkpoint_writer != nullptr && this->checkpoint_writer->Latest(checkpoint) &&
+      !controller.GetTuner().Restore(checkpoint)) {
+    cout << "[Warning]: The checkpoint does not match the tuner, not resumed" << endl;
+  }
+
+  this->eval_store = tuning_session ? eval_store : nullptr;
+
+  if (this->eval_store != nullptr) {
+    controller.GetTuner().SetEvalStore(this->eval_store, "udacity");
+  }
+
+  Publish();
+
+#ifdef PID_PROFILE
+  profiler.Reset();
+#endif
+
+  if (!logger.Open(file_name, settings.params)) {
+    return false;
+  }
+
+  if (tuning_session) {
+    if (!event_writer.Open(events_name, true)) {
+      cout << "[Warning]: Could not open tuner events file " << events_name << endl;
+      event_writer.Open("", true);
+    }
+    controller.GetTuner().SetEventSink(&event_writer);
+  }
+
+  active = true;
+
+  return true;
+}
+
+void Session::Stop() {
+  active = false;
+  // The writer threads write the pending records and events and close the files, the event loop does not wait
+  logger.Close();
+  // The writer of the pool writes the pending checkpoint, the event loop does not wait for the disk
+  checkpoint_writer = nullptr;
+  controller.GetTuner().SetEventSink(nullptr);
+  event_writer.Close();
+  controller.GetTuner().SetEvalStore(nullptr, "");
+  eval_store = nullptr;
+}
+
+unsigned int Session::Id() { return id; }
+
+bool Session::IsActive() { return active; }
+
+Controller &Session::GetController() { return controller; }
+
+Logger &Session::GetLogger() { return logger; }
+
+SessionStats &Session::Stats() { return stats; }
+
+SessionCounts Session::Counts() {
+  return {stats.frames - start_counts.frames, stats.manual_frames - start_counts.manual_frames,
+          stats.fallback_frames - start_counts.fallback_frames, stats.parse_errors - start_counts.parse_errors,
+          stats.resets - start_counts.resets};
+}
+
+void Session::Checkpoint() {
+  if (checkpoint_writer == nullptr) {
+    return;
+  }
+  controller.GetTuner().GetCheckpoint(checkpoint);
+  checkpoint_writer->Write(checkpoint);
+}
+
+void Session::Publish() {
+  PID &pid = controller.GetPID();
+  Tuner &tuner = controller.GetTuner();
+  snapshot.Store({{pid.GetKp(), pid.GetKi(), pid.GetKd()},
+                  tuner.BestError(),
+                  tuner.Cycle(),
+                  tuner.Enabled(),
+                  tuner.StepsSaved(),
+                  tuner.AverageWarmup()});
+}
+
+ControllerSnapshot Session::Snapshot() { return snapshot.Load(); }
+
+double Session::FrameInterval(chrono::steady_clock::time_point arrival) {
+  double interval = has_last_frame ? chrono::duration<double>(arrival - last_frame).count() : NAN;
+  last_frame = arrival;
+  has_last_frame = true;
+  return interval;
+}
+
+bool Session::Control(const Telemetry &telemetry, double dt, Actuation &actuation) {
+#ifdef PID_PROFILE
+  StageProfiler *stage_profiler = &profiler;
+#endif
+
+  Tuner &tuner = controller.GetTuner();
+
+  ++stats.frames;
+
+  // The gains only change while tuning (including the last tuning frame)
+  bool tuning = tuner.Enabled();
+  unsigned int cycle = tuner.Cycle();
+  bool updated = controller.Update(telemetry.cte, telemetry.speed, dt, actuation);
+
+  if (tuning) {
+    Publish();
+  }
+
+  if (updated && tuner.Cycle() != cycle) {
+    // End of a reset-free tuning cycle, the vehicle keeps driving
+    Checkpoint();
+  }
+
+  if (!updated) {
+    // End of a tuning cycle, checkpointed by CompleteCycle
+    ++stats.resets;
+    return false;
+  }
+
+  // Printed by the status reporter thread
+  if (!tuner.Enabled()) {
+    Observe(telemetry.speed, telemetry.angle, telemetry.cte, actuation.steer_value, actuation.throttle);
+  }
+
+  PROFILE_MARK(stage_profiler, STAGE_PRINT);
+
+  // Queues the output for the writer thread
+  logger.Log({telemetry.speed, telemetry.angle, telemetry.cte, actuation.steer_value, actuation.throttle,
+              Logger::Now(), tuner.Cycle()});
+
+  PROFILE_MARK(stage_profiler, STAGE_LOG);
+
+  return true;
+}
+
+void Session::CompleteCycle() {
+  controller.GetTuner().CompleteCycle();
+  Checkpoint();
+  Publish();
+}
+
+void Session::Observe(double speed, double angle, double cte, double steer_value, double throttle) {
+  if (window_started) {
+    ++window_frames;
+    window_sum += cte;
+    window_min = fmin(window_min, cte);
+    window_max = fmax(window_max, cte);
+    double length = chrono::duration<double>(last_frame - window_start).count();
+    if (length * 1000.0 >= settings.status_interval) {
+      current_status.cte_min = window_min;
+      current_status.cte_max = window_max;
+      current_status.cte_mean = window_sum / window_frames;
+      current_status.window_frames = window_frames;
+      current_status.window_length = length;
+      window_started = false;
+    }
+  }
+
+  if (!window_started) {
+    // The frame starts the next window, which holds the frames after it
+    window_start = last_frame;
+    window_started = true;
+    window_frames = 0;
+    window_sum = 0.0;
+    window_min = INFINITY;
+    window_max = -INFINITY;
+  }
+
+  current_status.speed = speed;
+  current_status.angle = angle;
+  current_status.cte = cte;
+  current_status.steer_value = steer_value;
+  current_status.throttle = throttle;
+  current_status.updated = chrono::duration_cast<chrono::nanoseconds>(last_frame.time_since_epoch()).count();
+  status.Store(current_status);
+}
+
+SessionStatus Session::Status() { return status.Load(); }
+
+#ifdef PID_PROFILE
+StageProfiler *Session::GetProfiler() { return &profiler; }
+#endif
+
+void Session::PrintStats() {
+  SessionCounts counts = Counts();
+  cout << "Session " << id << endl;
+  cout << setw(PRINT_INDENT) << "Frames: " << counts.frames << endl;
+  cout << setw(PRINT_INDENT) << "Manual frames: " << counts.manual_frames << endl;
+  cout << setw(PRINT_INDENT) << "Fallback frames: " << counts.fallback_frames << endl;
+  cout << setw(PRINT_INDENT) << "Parse errors: " << counts.parse_errors << endl;
+  cout << setw(PRINT_INDENT) << "Resets: " << counts.resets << endl;
+  if (tuning_session) {
+    cout << setw(PRINT_INDENT) << "Average warmup: " << controller.GetTuner().AverageWarmup() << endl;
+  }
+  if (eval_store != nullptr) {
+    cout << setw(PRINT_INDENT) << "Cached cycles: " << controller.GetTuner().CachedCycles() << endl;
+  }
+  if (tuning_session && settings.early_abort != EarlyAbort::OFF) {
+    cout << setw(PRINT_INDENT) << "Steps saved: " << controller.GetTuner().StepsSaved() << endl;
+  }
+  if (tuning_session && settings.max_repeats > 0) {
+    cout << setw(PRINT_INDENT) << "Repeated cycles: " << controller.GetTuner().RepeatedCycles() << endl;
+  }
+  if (checkpoint_writer != nullptr) {
+    // Written by the tuning sessions of the pool since it was created
+    cout << setw(PRINT_INDENT) << "Checkpoints: " << checkpoint_writer->Written() << endl;
+  }
+  if (tuning_session) {
+    cout << setw(PRINT_INDENT) << "Tuner events: " << event_writer.Written() << endl;
+  }
+  cout << setw(PRINT_INDENT) << "Log dropped: " << logger.Dropped() << endl;
+#ifdef PID_PROFILE
+  cout << profiler.Summary();
+#endif
+}
+
+atomic<unsigned int> SessionPool::next_id(1);
+
+mutex SessionPool::pools_mutex;
+
+vector<SessionPool *> SessionPool::pools;
+
+SessionPool::SessionPool(unsigned int id, unsigned int capacity, const SessionSettings &settings)
+    : settings(settings), tuning(nullptr) {
+  if (settings.max_steps > 0) {
+    checkpoint_writer.Open(CheckpointFileName(settings.params, id));
+    if (settings.resume) {
+      // The first session resumes from it, and it is the checkpoint of the pool until the end of the next cycle
+      checkpoint_writer.Write(settings.resume_state);
+    }
+    if (!settings.eval_db.empty() && !eval_store.Open(settings.eval_db)) {
+      cout << "[Warning]: Could not open evaluation store " << settings.eval_db << endl;
+    }
+  }
+
+  for (unsigned int i = 0; i < capacity; ++i) {
+    sessions.push_back(unique_ptr<Session>(new Session(this->settings)));
+    free_list.push_back(capacity - i - 1);
+  }
+  active.reserve(capacity);
+
+  lock_guard<mutex> lock(pools_mutex);
+  pools.push_back(this);
+}
+
+SessionPool::~SessionPool() {
+  lock_guard<mutex> lock(pools_mutex);
+  pools.erase(find(pools.begin(), pools.end(), this));
+}
+
+Session *SessionPool::Acquire() {
+  if (free_list.empty()) {
+    return nullptr;
+  }
+
+  unsigned int id = next_id++;
+  string file_name = LogFileName(id);
+  Session *session = sessions[free_list.back()].get();
+  bool tune = tuning == nullptr;
+
+  if (!session->Start(id, file_name, tune, &checkpoint_writer, eval_store.IsOpen() ? &eval_store : nullptr,
+                      EventsFileName(id))) {
+    cout << "Could not open file " << file_name << " for writing" << endl;
+    return nullptr;
+  }
+
+  if (settings.max_steps > 0 && tune) {
+    tuning = session;
+  } else if (settings.max_steps > 0) {
+    cout << "[Warning]: Session " << tuning->Id() << " is tuning, session " << id << " drives with the initial gains"
+         << endl;
+  }
+
+  free_list.pop_back();
+  active.push_back(session);
+
+  return session;
+}
+
+void SessionPool::Release(Session *session) {
+  auto it = find(active.begin(), active.end(), session);
+
+  if (it == active.end()) {
+    return;
+  }
+
+  session->Stop();
+
+  if (session == tuning) {
+    tuning = nullptr;
+  }
+
+  active.erase(it);
+
+  for (unsigned int i = 0; i < sessions.size(); ++i) {
+    if (sessions[i].get() == session) {
+      free_list.push_back(i);
+      break;
+    }
+  }
+}
+
+unsigned int SessionPool::Active() { return active.size(); }
+
+unsigned int SessionPool::Capacity() { return sessions.size(); }
+
+void SessionPool::ForEachSession(const function<void(Session &)> &function, bool active_only) {
+  lock_guard<mutex> lock(pools_mutex);
+  for (SessionPool *pool : pools) {
+    for (unique_ptr<Session> &session : pool->sessions) {
+      if (!active_only || session->IsActive()) {
+        function(*session);
+      }
+    }
+  }
+}
+
+string SessionPool::LogFileName(unsigned int id) {
+  const vector<double> &params = settings.params;
+  ostringstream oss;
+
+  oss << "cte_out_" << params[0] << "_" << params[1] << "_" << params[2];
+
+  // The first session keeps the original name
+  if (id > 1) {
+    oss << "_" << id;
+  }
+
+  oss << (settings.log_settings.format == LogFormat::BINARY ? ".bin" : ".txt");
+
+  return oss.str();
+}
+
+string SessionPool::CheckpointFileName(const vector<double> &params, unsigned int id) {
+  ostringstream oss;
+
+  oss << "tuner_" << params[0] << "_" << params[1] << "_" << params[2];
+
+  // The first pool keeps the original name
+  if (id > 0) {
+    oss << "_loop" << id;
+  }
+
+  oss << ".ckpt";
+
+  return oss.str();
+}
+
+string SessionPool::EventsFileName(unsigned int id) {
+  if (!settings.events) {
+    return "";
+  }
+
+  const vector<double> &params = settings.params;
+  ostringstream oss;
+
+  oss << "tuner_" << params[0] << "_" << params[1] << "_" << params[2];
+
+  if (id > 1) {
+    oss << "_" << id;
+  }
+
+  oss << ".jsonl";
+
+  return oss.str();
+}
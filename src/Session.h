@@ -0,0 +1,339 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Checkpoint.h"
+#include "Controller.h"
+#include "Counter.h"
+#include "EventWriter.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "Protocol.h"
+#include "Seqlock.h"
+
+/*
+ * Settings shared by all the sessions.
+ */
+struct SessionSettings {
+  // Initial Kp, Ki and Kd coefficients
+  std::vector<double> params;
+  // Number of steps of a tuning cycle, 0 disables the tuner
+  unsigned int max_steps;
+  LoggerSettings log_settings;
+  // Profiles one frame every profile_period frames (when built with PID_PROFILE)
+  unsigned int profile_period;
+  // Early termination of the tuning cycles
+  EarlyAbort early_abort;
+  // Repeated evaluations of the improvements that are not significant
+  unsigned int max_repeats;
+  double repeat_alpha;
+  WarmupSettings warmup;
+  // Resumes the tuning from resume_state, otherwise the first session of a pool starts a new tuning
+  bool resume;
+  TunerCheckpoint resume_state;
+  // Store of the evaluated coefficients shared by the sessions, empty to disable
+  std::string eval_db;
+  OptimizerType optimizer;
+  ContinuousSettings continuous;
+  // Writes the tuner events of every session to a JSON lines file
+  bool events;
+  // Redraw interval of the console status (ms), also the window of its CTE aggregates, 0 disables
+  unsigned int status_interval;
+};
+
+/*
+ * Counters of a session, updated by the event loop thread and readable from any thread. The counters are cumulative
+ * over all the connections served by the session, so that the totals of the process never decrease.
+ */
+struct SessionStats {
+  // Telemetry frames processed
+  Counter frames;
+  // Frames received while in manual mode
+  Counter manual_frames;
+  // Frames decoded through the generic JSON path
+  Counter fallback_frames;
+  // Frames that could not be parsed
+  Counter parse_errors;
+  // Simulator resets requested at the end of a tuning cycle
+  Counter resets;
+};
+
+/*
+ * Values of the session counters at a point in time.
+ */
+struct SessionCounts {
+  uint64_t frames;
+  uint64_t manual_frames;
+  uint64_t fallback_frames;
+  uint64_t parse_errors;
+  uint64_t resets;
+};
+
+/*
+ * Controller state published by the event loop for other threads.
+ */
+struct ControllerSnapshot {
+  double gains[3];
+  double best_err;
+  uint64_t cycle;
+  uint64_t tuning;
+  uint64_t steps_saved;
+  double avg_warmup;
+};
+
+/*
+ * Latest telemetry of a session and the CTE over the last completed window, published by the event loop for the
+ * console status.
+ */
+struct SessionStatus {
+  double speed;
+  double angle;
+  double cte;
+  double steer_value;
+  double throttle;
+  // Arrival of the latest frame (steady clock, ns), 0 before the first frame
+  int64_t updated;
+  double cte_min;
+  double cte_max;
+  double cte_mean;
+  // Frames of the window and its length (s), 0 before the first window completes
+  uint64_t window_frames;
+  double window_length;
+};
+
+/*
+ * State of a single simulator connection: controller (and tuner), telemetry log and stats. Sessions are meant to be
+ * reused through the SessionPool, the storage is allocated once and reset when the session starts.
+ *
+ * In the pipelined mode the methods for the event loop thread that run on the frames (FrameInterval, Control and
+ * the methods it calls) are called by the control thread of the loop instead (see ControlPipeline).
+ */
+class Session {
+ public:
+  Session(const SessionSettings &settings);
+
+  virtual ~Session();
+
+  /*
+   * Starts the session, resetting the controller (or resuming the tuning from the latest checkpoint of the writer)
+   * and opening the log file.
+   *
+   * @param id The id of the session
+   * @param file_name The name of the log file
+   * @param tune Whether the session tunes (when enabled by the settings), otherwise it drives with the initial gains
+   * @param checkpoint_writer The writer of the tuner checkpoints of the pool, used by its tuning session
+   * @param eval_store The store of the evaluated coefficients shared by the sessions of the pool, nullptr to disable
+   * @param events_name The name of the tuner events file, empty for the console only
+   *
+   * @return False if the log file could not be opened
+   */
+  bool Start(unsigned int id, const std::string &file_name, bool tune, CheckpointWriter *checkpoint_writer,
+             EvalStore *eval_store, const std::string &events_name);
+
+  /*
+   * Stops the session closing the log file and writing the pending tuner events, the pending checkpoint is left to
+   * the checkpoint writer.
+   */
+  void Stop();
+
+  unsigned int Id();
+
+  /*
+   * True between Start and Stop, can be called from any thread.
+   */
+  bool IsActive();
+
+  Controller &GetController();
+
+  Logger &GetLogger();
+
+  SessionStats &Stats();
+
+  /*
+   * The counters of the current connection.
+   */
+  SessionCounts Counts();
+
+  /*
+   * Queues a checkpoint of the tuner for the writer thread, to be called at the end of a tuning cycle.
+   */
+  void Checkpoint();
+
+  /*
+   * Publishes the current gains and tuner state (event loop thread only).
+   */
+  void Publish();
+
+  /*
+   * The last published controller state, can be called from any thread.
+   */
+  ControllerSnapshot Snapshot();
+
+  /*
+   * Time since the previous frame (s), NaN on the first frame of the connection (event loop thread only).
+   *
+   * @param arrival Arrival of the frame
+   */
+  double FrameInterval(std::chrono::steady_clock::time_point arrival);
+
+  /*
+   * Runs the controller on a telemetry frame: tuning, checkpoints, console status and telemetry log (event loop
+   * thread only).
+   *
+   * @param telemetry The telemetry of the frame
+   * @param dt Time since the previous frame (s), see FrameInterval
+   * @param actuation Set to the steering value and throttle to send
+   *
+   * @return False if the simulator must be reset (end of a tuning cycle), then CompleteCycle must be called once the
+   *         reset is sent
+   */
+  bool Control(const Telemetry &telemetry, double dt, Actuation &actuation);
+
+  /*
+   * Proposes the next candidate of the tuning cycle that ended on the last frame and queues its checkpoint (see
+   * Tuner::CompleteCycle), to be called after the reset is sent so that the simulator restarts meanwhile (event loop
+   * thread only).
+   */
+  void CompleteCycle();
+
+  /*
+   * Publishes the telemetry of a frame for the console status and adds its CTE to the current window (event loop
+   * thread only, after FrameInterval).
+   */
+  void Observe(double speed, double angle, double cte, double steer_value, double throttle);
+
+  /*
+   * The last published telemetry, can be called from any thread.
+   */
+  SessionStatus Status();
+
+#ifdef PID_PROFILE
+  StageProfiler *GetProfiler();
+#endif
+
+  void PrintStats();
+
+ private:
+  const SessionSettings &settings;
+  unsigned int id;
+  std::atomic<bool> active;
+  // The connection runs the tuner (see SessionPool::Acquire)
+  bool tuning_session;
+  Controller controller;
+  Logger logger;
+  // Owned by the pool, nullptr while not tuning
+  CheckpointWriter *checkpoint_writer;
+  // Prints the progress of the tuning (and writes the events file) off the event loop
+  EventWriter event_writer;
+  // Owned by the pool, nullptr if disabled
+  EvalStore *eval_store;
+  // Reused for every checkpoint
+  TunerCheckpoint checkpoint;
+  SessionStats stats;
+  // Counters at the start of the current connection
+  SessionCounts start_counts;
+  Seqlock<ControllerSnapshot> snapshot;
+  // Arrival of the previous telemetry frame, for the distance travelled by the reset-free tuning
+  std::chrono::steady_clock::time_point last_frame;
+  bool has_last_frame;
+  Seqlock<SessionStatus> status;
+  // Reused for every frame
+  SessionStatus current_status;
+  // CTE aggregates of the current window, from the frame that started it (excluded)
+  std::chrono::steady_clock::time_point window_start;
+  bool window_started;
+  uint64_t window_frames;
+  double window_sum;
+  double window_min;
+  double window_max;
+#ifdef PID_PROFILE
+  StageProfiler profiler;
+#endif
+};
+
+/*
+ * Fixed capacity pool of sessions, all the sessions are created upfront so that accepting a connection does not
+ * allocate a new session. A pool is not thread safe and is meant to be owned by a single event loop.
+ */
+class SessionPool {
+ public:
+  /*
+   * @param id The id of the pool (e.g. of its event loop), names its checkpoint file
+   * @param capacity Max number of concurrent sessions
+   * @param settings The settings for the sessions
+   */
+  SessionPool(unsigned int id, unsigned int capacity, const SessionSettings &settings);
+
+  virtual ~SessionPool();
+
+  /*
+   * Starts a session from the pool, the session tunes (when enabled) unless another session of the pool is tuning.
+   *
+   * @return The session, nullptr if the pool is exhausted or the session log could not be opened
+   */
+  Session *Acquire();
+
+  /*
+   * Stops the session and returns it to the pool.
+   */
+  void Release(Session *session);
+
+  /*
+   * Number of active sessions.
+   */
+  unsigned int Active();
+
+  unsigned int Capacity();
+
+  /*
+   * Calls the given function for each session of all the pools of the process, the sessions are in use by their
+   * event loop and only the members that can be read concurrently (stats, snapshot, profiler and logger counters)
+   * should be accessed.
+   *
+   * @param function The function to call
+   * @param active_only Skips the sessions that are not serving a connection
+   */
+  static void ForEachSession(const std::function<void(Session &)> &function, bool active_only = true);
+
+  /*
+   * The name of the tuner checkpoint file of a pool, written by all the sessions of the pool.
+   *
+   * @param params The initial Kp, Ki and Kd coefficients
+   * @param id The id of the pool
+   */
+  static std::string CheckpointFileName(const std::vector<double> &params, unsigned int id);
+
+ private:
+  SessionSettings settings;
+  // Checkpoints of the tuning session of the pool, so that a new connection resumes the tuning from the latest one
+  CheckpointWriter checkpoint_writer;
+  // The session that tunes, nullptr if none: a tuner per pool, so that a single tuning writes the checkpoint and is
+  // resumed from it, the other concurrent sessions drive with the initial gains
+  Session *tuning;
+  // Opened once for all the connections, the event loop never waits for its writer thread
+  EvalStore eval_store;
+  // Never resized after construction, so that the sessions can be iterated from other threads
+  std::vector<std::unique_ptr<Session>> sessions;
+  // Indexes of the free sessions
+  std::vector<unsigned int> free_list;
+  std::vector<Session *> active;
+
+  // Session ids are unique across all the pools of the process
+  static std::atomic<unsigned int> next_id;
+
+  // All the pools of the process, registered on creation
+  static std::mutex pools_mutex;
+  static std::vector<SessionPool *> pools;
+
+  std::string LogFileName(unsigned int id);
+  std::string EventsFileName(unsigned int id);
+};
+
+#endif /* SESSION_H */
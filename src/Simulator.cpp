@@ -0,0 +1,200 @@
+#include "Simulator.h"
+#include <math.h>
+#include <fstream>
+#include <sstream>
+
+// Number of segments around the previous nearest segment checked when computing the cross track error
+#define SEARCH_WINDOW 16
+#define MPS_TO_MPH 2.23694
+
+Track::Track() : length(0.0) {}
+
+bool Track::Load(const std::string &file_name) {
+  std::ifstream in(file_name);
+
+  if (!in.is_open()) {
+    return false;
+  }
+
+  xs.clear();
+  ys.clear();
+
+  std::string line;
+
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream iss(line);
+    double x, y;
+    if (iss >> x >> y) {
+      xs.push_back(x);
+      ys.push_back(y);
+    }
+  }
+
+  if (xs.size() < 3) {
+    return false;
+  }
+
+  Build();
+
+  return true;
+}
+
+Track Track::Default() {
+  Track track;
+  const unsigned int points = 2000;
+  const double radius = 140.0;
+  for (unsigned int i = 0; i < points; ++i) {
+    double t = 2 * M_PI * i / points;
+    double r = radius * (1.0 + 0.18 * sin(3 * t) + 0.08 * cos(2 * t));
+    track.xs.push_back(r * cos(t));
+    track.ys.push_back(r * sin(t));
+  }
+  track.Build();
+  return track;
+}
+
+void Track::Build() {
+  distances.resize(xs.size());
+  length = 0.0;
+  for (size_t i = 0; i < xs.size(); ++i) {
+    size_t next = (i + 1) % xs.size();
+    distances[i] = length;
+    length += hypot(xs[next] - xs[i], ys[next] - ys[i]);
+  }
+}
+
+double Track::Length() const { return length; }
+
+size_t Track::Size() const { return xs.size(); }
+
+double Track::CrossTrackError(double x, double y, size_t &segment, double &progress) const {
+  const size_t n = xs.size();
+  double best_distance = INFINITY;
+  double best_cte = 0.0;
+  size_t best_segment = segment;
+
+  for (int offset = -SEARCH_WINDOW; offset <= SEARCH_WINDOW; ++offset) {
+    size_t i = (segment + n + offset) % n;
+    size_t next = (i + 1) % n;
+
+    double dx = xs[next] - xs[i];
+    double dy = ys[next] - ys[i];
+    double px = x - xs[i];
+    double py = y - ys[i];
+    double segment_length = hypot(dx, dy);
+
+    if (segment_length == 0) {
+      continue;
+    }
+
+    // Projection on the segment, clamped to its end points
+    double t = (px * dx + py * dy) / (segment_length * segment_length);
+    t = t < 0 ? 0 : (t > 1 ? 1 : t);
+
+    double ex = px - t * dx;
+    double ey = py - t * dy;
+    double distance = hypot(ex, ey);
+
+    if (distance < best_distance) {
+      // The cross product is positive when the point is on the left of the segment
+      double cross = dx * py - dy * px;
+      best_distance = distance;
+      best_cte = cross > 0 ? -distance : distance;
+      best_segment = i;
+      progress = distances[i] + t * segment_length;
+    }
+  }
+
+  segment = best_segment;
+
+  return best_cte;
+}
+
+void Track::Start(double &x, double &y, double &yaw) const {
+  x = xs[0];
+  y = ys[0];
+  yaw = atan2(ys[1] - ys[0], xs[1] - xs[0]);
+}
+
+Simulator::Simulator(const Track &track, SimulatorSettings settings)
+    : track(track), settings(settings), random(settings.seed) {
+  Reset();
+}
+
+Simulator::~Simulator() {}
+
+void Simulator::Reset() {
+  track.Start(x, y, yaw);
+  v = 0.0;
+  wheel_angle = 0.0;
+  segment = 0;
+  progress = 0.0;
+  distance = 0.0;
+  steps = 0;
+  delayed_steer.assign(settings.delay + 1, 0.0);
+  delayed_throttle.assign(settings.delay + 1, 0.0);
+  delay_index = 0;
+  UpdateCte();
+}
+
+void Simulator::Step(double steer_value, double throttle) {
+  // The actuation is applied after the delay, the buffer holds the last (delay + 1) commands
+  delayed_steer[delay_index] = steer_value;
+  delayed_throttle[delay_index] = throttle;
+  delay_index = (delay_index + 1) % delayed_steer.size();
+
+  steer_value = delayed_steer[delay_index];
+  throttle = delayed_throttle[delay_index];
+
+  const double dt = settings.dt;
+
+  // Steering actuator, rate limited (positive steering value turns right)
+  double target_angle = -steer_value * settings.max_steer;
+  double max_change = settings.steer_rate * dt;
+  double change = target_angle - wheel_angle;
+  wheel_angle += change < -max_change ? -max_change : (change > max_change ? max_change : change);
+
+  // Longitudinal dynamics
+  double accel = throttle * settings.max_accel - settings.drag * v * v - (v > 0 ? settings.rolling : 0.0);
+  v = fmax(0.0, v + accel * dt);
+
+  // Kinematic bicycle model (rear axle reference)
+  x += v * cos(yaw) * dt;
+  y += v * sin(yaw) * dt;
+  double disturbance = settings.steer_noise > 0.0 ? settings.steer_noise * normal(random) : 0.0;
+  yaw += v / settings.wheel_base * tan(wheel_angle + disturbance) * dt;
+
+  double previous_progress = progress;
+
+  UpdateCte();
+
+  // Handles the wrap around at the end of the lap
+  double delta = progress - previous_progress;
+  if (delta < -track.Length() / 2) {
+    delta += track.Length();
+  } else if (delta > track.Length() / 2) {
+    delta -= track.Length();
+  }
+
+  distance += delta;
+
+  ++steps;
+}
+
+Telemetry Simulator::GetTelemetry() {
+  return {measured_cte, v * MPS_TO_MPH, -wheel_angle * 180.0 / M_PI};
+}
+
+double Simulator::Distance() { return distance; }
+
+bool Simulator::OffTrack() { return fabs(cte) > settings.off_track; }
+
+unsigned int Simulator::Steps() { return steps; }
+
+void Simulator::UpdateCte() {
+  cte = track.CrossTrackError(x, y, segment, progress);
+  measured_cte = settings.cte_noise > 0.0 ? cte + settings.cte_noise * normal(random) : cte;
+}
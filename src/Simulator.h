@@ -0,0 +1,174 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+#include "Protocol.h"
+
+/*
+ * Closed track centerline, as a polyline of (x, y) points in meters.
+ */
+class Track {
+ public:
+  Track();
+
+  /*
+   * Loads the centerline from a text file with one "x y" point per line (lines starting with # are ignored), the
+   * last point is connected to the first one.
+   *
+   * @return False if the file could not be read or has less than 3 points
+   */
+  bool Load(const std::string &file_name);
+
+  /*
+   * Built-in track (about 1 km) with turns of different radius in both directions.
+   */
+  static Track Default();
+
+  /*
+   * Length of the centerline in meters.
+   */
+  double Length() const;
+
+  size_t Size() const;
+
+  /*
+   * Computes the signed cross track error of the given position (positive when on the right side of the centerline).
+   * The search is local to the segments around the given segment index, that is updated with the nearest segment.
+   *
+   * @param x The x position
+   * @param y The y position
+   * @param segment In/out index of the nearest segment
+   * @param progress Output distance along the centerline of the projected position
+   */
+  double CrossTrackError(double x, double y, size_t &segment, double &progress) const;
+
+  /*
+   * Start position and heading (the direction of the first segment).
+   */
+  void Start(double &x, double &y, double &yaw) const;
+
+ private:
+  std::vector<double> xs;
+  std::vector<double> ys;
+  // Distance along the centerline at the start of each segment
+  std::vector<double> distances;
+  double length;
+
+  void Build();
+};
+
+struct SimulatorSettings {
+  // Time step (s)
+  double dt;
+  // Distance between front and rear axles (m)
+  double wheel_base;
+  // Max wheel angle (rad) for a steering value of 1
+  double max_steer;
+  // Max wheel angle rate of change (rad/s)
+  double steer_rate;
+  // Acceleration (m/s^2) at full throttle
+  double max_accel;
+  // Quadratic drag coefficient (1/m)
+  double drag;
+  // Rolling resistance deceleration (m/s^2)
+  double rolling;
+  // Actuation delay in steps
+  unsigned int delay;
+  // Absolute cross track error after which the vehicle is considered off track (m)
+  double off_track;
+  // Standard deviation of the noise of the reported cross track error (m), 0 for a deterministic plant
+  double cte_noise;
+  // Standard deviation of a random disturbance of the steering angle at each step (rad), e.g. an uneven road
+  double steer_noise;
+  // Seed of the noise, the noise is not repeated on reset so that the cycles of a run differ
+  unsigned int seed;
+
+  SimulatorSettings()
+      : dt(0.02),
+        wheel_base(2.67),
+        max_steer(25.0 * 3.14159265358979323846 / 180.0),
+        steer_rate(2.0),
+        max_accel(4.0),
+        drag(0.008),
+        rolling(0.2),
+        delay(2),
+        off_track(5.0),
+        cte_noise(0.0),
+        steer_noise(0.0),
+        seed(1) {}
+};
+
+/*
+ * Headless vehicle simulator based on a kinematic bicycle model, the vehicle follows a Track starting from standstill.
+ * The steering value is positive to the right and, as in the Udacity simulator, the telemetry reports the speed in
+ * mph and the steering angle in degrees.
+ */
+class Simulator {
+ public:
+  Simulator(const Track &track, SimulatorSettings settings);
+
+  virtual ~Simulator();
+
+  /*
+   * Puts the vehicle back to the start of the track, at standstill.
+   */
+  void Reset();
+
+  /*
+   * Advances the simulation by one time step with the given actuation (applied after the actuation delay).
+   *
+   * @param steer_value The steering value in [-1, 1]
+   * @param throttle The throttle value in [-1, 1]
+   */
+  void Step(double steer_value, double throttle);
+
+  /*
+   * Current telemetry as it would be sent by the simulator.
+   */
+  Telemetry GetTelemetry();
+
+  /*
+   * Distance (m) travelled along the centerline since the last reset.
+   */
+  double Distance();
+
+  bool OffTrack();
+
+  /*
+   * Number of steps since the last reset.
+   */
+  unsigned int Steps();
+
+ private:
+  const Track &track;
+  SimulatorSettings settings;
+
+  double x;
+  double y;
+  double yaw;
+  double v;
+  double wheel_angle;
+  double cte;
+  // Reported cross track error, with the noise
+  double measured_cte;
+
+  size_t segment;
+  double progress;
+  double distance;
+  unsigned int steps;
+
+  // Pending actuations (steering value, throttle) for the actuation delay
+  std::vector<double> delayed_steer;
+  std::vector<double> delayed_throttle;
+  size_t delay_index;
+
+  std::mt19937 random;
+  std::normal_distribution<double> normal;
+
+  void UpdateCte();
+};
+
+#endif /* SIMULATOR_H */
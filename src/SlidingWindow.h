@@ -0,0 +1,75 @@
+#ifndef SLIDING_WINDOW_H
+#define SLIDING_WINDOW_H
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * Mean and variance of the last n values, updated incrementally in O(1) per value. The running sums are recomputed
+ * from the window every time it wraps around so that rounding errors do not accumulate.
+ */
+class SlidingWindow {
+ public:
+  explicit SlidingWindow(size_t size = 1) : values(size == 0 ? 1 : size) { Clear(); }
+
+  void Clear() {
+    next = 0;
+    count = 0;
+    sum = 0.0;
+    sum_squares = 0.0;
+  }
+
+  void Add(double value) {
+    if (count == values.size()) {
+      double old = values[next];
+      sum -= old;
+      sum_squares -= old * old;
+    } else {
+      ++count;
+    }
+    values[next] = value;
+    sum += value;
+    sum_squares += value * value;
+    if (++next == values.size()) {
+      next = 0;
+      Recompute();
+    }
+  }
+
+  /*
+   * True when the window holds n values.
+   */
+  bool Full() const { return count == values.size(); }
+
+  double Mean() const { return count == 0 ? 0.0 : sum / count; }
+
+  /*
+   * Population variance of the values in the window.
+   */
+  double Variance() const {
+    if (count == 0) {
+      return 0.0;
+    }
+    double mean = Mean();
+    double variance = sum_squares / count - mean * mean;
+    return variance < 0.0 ? 0.0 : variance;
+  }
+
+ private:
+  std::vector<double> values;
+  size_t next;
+  size_t count;
+  double sum;
+  double sum_squares;
+
+  void Recompute() {
+    sum = 0.0;
+    sum_squares = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+      sum += values[i];
+      sum_squares += values[i] * values[i];
+    }
+  }
+};
+
+#endif /* SLIDING_WINDOW_H */
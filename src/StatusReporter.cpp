@@ -0,0 +1,121 @@
+#include "StatusReporter.h"
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "Session.h"
+
+using namespace std;
+
+#define PRINT_INDENT 19
+
+StatusReporter::StatusReporter() : interval(0), stop(false), running(false) {}
+
+StatusReporter::~StatusReporter() { Stop(); }
+
+void StatusReporter::Start(unsigned int interval) {
+  if (running) {
+    return;
+  }
+
+  this->interval = max(1u, interval);
+  stop = false;
+  running = true;
+  reporter = thread(&StatusReporter::Run, this);
+}
+
+void StatusReporter::Stop() {
+  if (!running) {
+    return;
+  }
+
+  {
+    lock_guard<mutex> lock(stop_mutex);
+    stop = true;
+  }
+
+  stop_signal.notify_one();
+  reporter.join();
+  running = false;
+}
+
+string StatusReporter::Render() {
+  ostringstream out;
+  int64_t now = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+
+  SessionPool::ForEachSession([this, &out, now](Session &session) {
+    if (session.Snapshot().tuning) {
+      // The tuner prints its own progress
+      return;
+    }
+
+    SessionStatus status = session.Status();
+
+    out << "Session " << session.Id();
+    if (status.updated == 0) {
+      out << " (waiting for telemetry)" << endl;
+      return;
+    }
+    double age = (now - status.updated) * 1e-9;
+    if (age * 1000.0 > 2 * interval) {
+      out << " (no telemetry for " << fixed << setprecision(1) << age << " s)" << defaultfloat;
+    }
+    out << endl;
+
+    out << setprecision(4);
+    out << setw(PRINT_INDENT) << "Speed: " << status.speed << " (angle " << status.angle << ")" << endl;
+    out << setw(PRINT_INDENT) << "Steering Value: " << status.steer_value << " (throttle " << status.throttle << ")"
+        << endl;
+    out << setw(PRINT_INDENT) << "CTE: " << status.cte;
+    if (status.window_frames > 0) {
+      out << " (min " << status.cte_min << ", max " << status.cte_max << ", mean " << status.cte_mean << " over "
+          << status.window_length << " s)" << endl;
+      out << setw(PRINT_INDENT) << "Frames/s: " << status.window_frames / status.window_length << endl;
+    } else {
+      out << endl;
+    }
+#ifdef PID_PROFILE
+    // Sampled over the whole connection, a window holds too few sampled frames for a tail percentile
+    const StageProfiler *profiler = session.GetProfiler();
+    if (profiler->Stage(STAGE_FRAME).Count() > 0) {
+      out << setw(PRINT_INDENT) << "Frame p99 (us): " << profiler->Percentile(STAGE_FRAME, 99.0) * 1e-3 << endl;
+    }
+#endif
+    out << setprecision(6);
+  });
+
+  return out.str();
+}
+
+void StatusReporter::Run() {
+  bool terminal = isatty(STDOUT_FILENO);
+  // Lines of the previous block, overwritten by the next one on a terminal
+  size_t lines = 0;
+  bool stopping = false;
+
+  while (!stopping) {
+    {
+      unique_lock<mutex> lock(stop_mutex);
+      stopping = stop_signal.wait_for(lock, chrono::milliseconds(interval), [this] { return stop; });
+    }
+
+    string block = Render();
+
+    if (block.empty()) {
+      lines = 0;
+      continue;
+    }
+
+    if (terminal && lines > 0) {
+      // Moves the cursor to the start of the previous block and clears the screen below
+      cout << "\033[" << lines << "F\033[J";
+    } else if (!terminal) {
+      block += "\n";
+    }
+
+    cout << block << flush;
+    lines = count(block.begin(), block.end(), '\n');
+  }
+}
@@ -0,0 +1,52 @@
+#ifndef STATUS_REPORTER_H
+#define STATUS_REPORTER_H
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/*
+ * Prints the status of the sessions that are not tuning (latest telemetry, CTE over the last window, frames/s and
+ * frame latency) at a fixed rate from its own thread, so that the event loops never write to the console. The
+ * values are read from the session snapshots without blocking the event loops. On a terminal the block is redrawn
+ * in place.
+ */
+class StatusReporter {
+ public:
+  StatusReporter();
+
+  /*
+   * Destructor, stops the reporter if still running.
+   */
+  virtual ~StatusReporter();
+
+  /*
+   * Starts the reporter thread.
+   *
+   * @param interval The redraw interval (ms)
+   */
+  void Start(unsigned int interval);
+
+  /*
+   * Stops the reporter thread.
+   */
+  void Stop();
+
+ private:
+  unsigned int interval;
+  std::thread reporter;
+  std::mutex stop_mutex;
+  std::condition_variable stop_signal;
+  bool stop;
+  bool running;
+
+  void Run();
+
+  /*
+   * The status block of the sessions that are not tuning, empty if there are none.
+   */
+  std::string Render();
+};
+
+#endif /* STATUS_REPORTER_H */
@@ -0,0 +1,180 @@
+#include "SuccessiveHalving.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+using namespace std;
+
+// Initial spread of the samples, standard deviation of the log of the parameters
+#define INITIAL_SPREAD 0.5
+// Reduction of the spread after a bracket that did not improve
+#define SPREAD_SHRINKAGE 0.5
+
+SuccessiveHalving::SuccessiveHalving(const vector<double> &params, unsigned int bracket_size, unsigned int eta,
+                                     unsigned int rungs, double tolerance, unsigned int seed)
+    : random(seed) {
+  for (unsigned int i = 0; i < params.size(); ++i) {
+    if (params[i] != 0) {
+      dims.push_back(i);
+    }
+  }
+
+  this->bracket_size = max(bracket_size, 1u);
+  this->eta = max(eta, 2u);
+  this->rungs = max(rungs, 1u);
+  this->center = params;
+  this->spread = INITIAL_SPREAD;
+  this->bracket = 0;
+  this->first_id = 0;
+  this->best_params = params;
+  this->best_err = numeric_limits<double>::max();
+  this->tolerance = tolerance;
+
+  StartBracket();
+}
+
+SuccessiveHalving::~SuccessiveHalving() {}
+
+void SuccessiveHalving::StartBracket() {
+  normal_distribution<double> normal(0.0, spread);
+  vector<vector<double>> samples;
+
+  bracket_err = best_err;
+
+  // The initial parameters take part in the first bracket
+  if (bracket == 0) {
+    samples.push_back(center);
+  }
+  while (samples.size() < bracket_size) {
+    vector<double> sample = center;
+    for (unsigned int d : dims) {
+      sample[d] *= exp(normal(random));
+    }
+    samples.push_back(sample);
+  }
+
+  rung = 0;
+  StartRung(samples);
+}
+
+void SuccessiveHalving::StartRung(const vector<vector<double>> &rung_candidates) {
+  first_id += candidates.size();
+  candidates = rung_candidates;
+  errors.assign(candidates.size(), numeric_limits<double>::max());
+  reported.assign(candidates.size(), false);
+  proposed = 0;
+  reported_count = 0;
+}
+
+double SuccessiveHalving::Fidelity() { return pow(static_cast<double>(eta), static_cast<int>(rung + 1 - rungs)); }
+
+bool SuccessiveHalving::Propose(Candidate &candidate) {
+  if (proposed == candidates.size()) {
+    // Waits for the rest of the rung
+    return false;
+  }
+  candidate.id = first_id + proposed;
+  candidate.params = candidates[proposed];
+  candidate.fidelity = Fidelity();
+  ++proposed;
+  return true;
+}
+
+void SuccessiveHalving::Report(const Candidate &candidate, double error) {
+  if (candidate.id < first_id || candidate.id >= first_id + proposed || reported[candidate.id - first_id]) {
+    return;
+  }
+
+  unsigned int k = candidate.id - first_id;
+  reported[k] = true;
+  errors[k] = error;
+  ++reported_count;
+
+  if (candidate.fidelity >= 1.0 && error < best_err) {
+    best_err = error;
+    best_params = candidate.params;
+  }
+
+  if (reported_count == candidates.size()) {
+    NextRung();
+  }
+}
+
+void SuccessiveHalving::NextRung() {
+  if (rung + 1 >= rungs || dims.empty()) {
+    // End of the bracket
+    if (best_err < bracket_err) {
+      center = best_params;
+    } else {
+      spread *= SPREAD_SHRINKAGE;
+    }
+    ++bracket;
+    StartBracket();
+    return;
+  }
+
+  vector<unsigned int> order(candidates.size());
+  iota(order.begin(), order.end(), 0);
+  stable_sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) { return errors[a] < errors[b]; });
+
+  size_t promoted = (candidates.size() + eta - 1) / eta;
+  vector<vector<double>> next;
+  for (unsigned int i = 0; i < promoted; ++i) {
+    next.push_back(candidates[order[i]]);
+  }
+
+  ++rung;
+  StartRung(next);
+}
+
+bool SuccessiveHalving::Converged() { return dims.empty() || spread <= tolerance; }
+
+vector<double> SuccessiveHalving::BestParams() { return best_params; }
+
+double SuccessiveHalving::BestError() { return best_err; }
+
+void SuccessiveHalving::Save(vector<double> &state) {
+  state.clear();
+  state.push_back(bracket);
+  state.push_back(spread);
+  state.push_back(best_err);
+  state.insert(state.end(), best_params.begin(), best_params.end());
+  state.insert(state.end(), center.begin(), center.end());
+}
+
+bool SuccessiveHalving::Restore(const vector<double> &state) {
+  size_t n = center.size();
+
+  if (state.size() != 3 + 2 * n || state[0] < 0 || !(state[1] > 0)) {
+    return false;
+  }
+
+  const double *p = state.data();
+
+  bracket = static_cast<unsigned int>(*p++);
+  spread = *p++;
+  best_err = *p++;
+  for (unsigned int i = 0; i < n; ++i) {
+    best_params[i] = *p++;
+  }
+  for (unsigned int i = 0; i < n; ++i) {
+    center[i] = *p++;
+  }
+
+  StartBracket();
+
+  return true;
+}
+
+void SuccessiveHalving::GetState(vector<OptimizerValue> &state) {
+  const char *NAMES[] = {"Bracket", "Rung", "Rungs", "Evaluated", "Candidates", "Fidelity", "Spread"};
+  double values[] = {bracket + 1.0, rung + 1.0, static_cast<double>(rungs), static_cast<double>(reported_count),
+                     static_cast<double>(candidates.size()), Fidelity(), spread};
+  state.resize(7);
+  for (unsigned int i = 0; i < 7; ++i) {
+    state[i].name = NAMES[i];
+    state[i].values.assign(1, values[i]);
+    state[i].text.clear();
+  }
+}
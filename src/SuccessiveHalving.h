@@ -0,0 +1,86 @@
+#ifndef SUCCESSIVE_HALVING_H
+#define SUCCESSIVE_HALVING_H
+
+#include <random>
+#include <vector>
+#include "Optimizer.h"
+
+/*
+ * Multi-fidelity search by successive halving: each bracket samples a number of candidates around the best
+ * parameters (log-normal variations of each parameter), evaluates all of them with a low fidelity (short cycles) and
+ * promotes the best 1/eta of them to the next rung, with an eta times higher fidelity, until the finalists get a
+ * full evaluation. Only the full evaluations are compared with the best error, the errors of a rung are only
+ * compared with each other. The next bracket is centered on the best parameters, the spread of the samples is
+ * halved when a bracket does not improve the best error. Converges when the spread is below the tolerance.
+ *
+ * The candidates of a rung can be proposed at once and evaluated concurrently. The state is saved at the start of
+ * the bracket, a restore restarts the current bracket.
+ */
+class SuccessiveHalving : public Optimizer {
+ public:
+  /*
+   * @param params The initial parameters
+   * @param bracket_size Number of candidates of the first rung of a bracket
+   * @param eta Reduction factor of the candidates and increase factor of the fidelity between the rungs
+   * @param rungs Number of rungs of a bracket, the first one with a fidelity of 1 / eta^(rungs - 1)
+   * @param tolerance Spread (standard deviation of the log of the parameters) at convergence
+   * @param seed Seed of the sampling
+   */
+  SuccessiveHalving(const std::vector<double> &params, unsigned int bracket_size, unsigned int eta,
+                    unsigned int rungs, double tolerance, unsigned int seed);
+
+  virtual ~SuccessiveHalving();
+
+  bool Propose(Candidate &candidate);
+
+  void Report(const Candidate &candidate, double error);
+
+  bool Converged();
+
+  std::vector<double> BestParams();
+
+  double BestError();
+
+  void Save(std::vector<double> &state);
+
+  bool Restore(const std::vector<double> &state);
+
+  void GetState(std::vector<OptimizerValue> &state);
+
+ private:
+  // Indexes of the parameters that are tuned
+  std::vector<unsigned int> dims;
+
+  unsigned int bracket_size;
+  unsigned int eta;
+  unsigned int rungs;
+
+  // Center of the samples of the bracket and spread of the samples
+  std::vector<double> center;
+  double spread;
+  unsigned int bracket;
+  // Best error at the start of the bracket
+  double bracket_err;
+
+  // Current rung: the candidates, their errors and which ones were proposed and reported
+  unsigned int rung;
+  std::vector<std::vector<double>> candidates;
+  std::vector<double> errors;
+  std::vector<bool> reported;
+  unsigned int proposed;
+  unsigned int reported_count;
+  unsigned int first_id;
+
+  std::mt19937 random;
+
+  std::vector<double> best_params;
+  double best_err;
+  double tolerance;
+
+  void StartBracket();
+  void NextRung();
+  void StartRung(const std::vector<std::vector<double>> &rung_candidates);
+  double Fidelity();
+};
+
+#endif /* SUCCESSIVE_HALVING_H */
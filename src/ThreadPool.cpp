@@ -0,0 +1,40 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int threads) : stop(false) {
+  if (threads == 0) {
+    threads = 1;
+  }
+  for (unsigned int i = 0; i < threads; ++i) {
+    workers.push_back(std::thread(&ThreadPool::Run, this));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(tasks_mutex);
+    stop = true;
+  }
+  tasks_available.notify_all();
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+}
+
+unsigned int ThreadPool::Size() { return workers.size(); }
+
+void ThreadPool::Run() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(tasks_mutex);
+      tasks_available.wait(lock, [this] { return stop || !tasks.empty(); });
+      if (tasks.empty()) {
+        // Stopped and no pending task
+        return;
+      }
+      task = std::move(tasks.front());
+      tasks.pop();
+    }
+    task();
+  }
+}
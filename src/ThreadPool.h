@@ -0,0 +1,59 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Fixed size pool of worker threads executing the submitted tasks in FIFO order.
+ */
+class ThreadPool {
+ public:
+  /*
+   * Starts the given number of worker threads (at least one).
+   */
+  explicit ThreadPool(unsigned int threads);
+
+  /*
+   * Destructor, completes the pending tasks and joins the workers.
+   */
+  virtual ~ThreadPool();
+
+  /*
+   * Queues a task for execution.
+   *
+   * @return The future result of the task
+   */
+  template <typename F>
+  std::future<typename std::result_of<F()>::type> Submit(F task) {
+    typedef typename std::result_of<F()>::type Result;
+    auto packaged = std::make_shared<std::packaged_task<Result()>>(task);
+    std::future<Result> result = packaged->get_future();
+    {
+      std::lock_guard<std::mutex> lock(tasks_mutex);
+      tasks.push([packaged]() { (*packaged)(); });
+    }
+    tasks_available.notify_one();
+    return result;
+  }
+
+  unsigned int Size();
+
+ private:
+  std::vector<std::thread> workers;
+  std::queue<std::function<void()>> tasks;
+  std::mutex tasks_mutex;
+  std::condition_variable tasks_available;
+  bool stop;
+
+  void Run();
+};
+
+#endif /* THREAD_POOL_H */
@@ -1,58 +1,200 @@
 #include "Tuner.h"
 #include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <numeric>
+#include <sstream>
 
 using namespace std;
 
-#define PRINT_INDENT 19
+// The simulators report the speed in mph
+#define MPH_TO_MPS 0.44704
 
-Tuner::Tuner(vector<double> params, unsigned int max_steps) {
-  this->params = params;
+// Quantile of the standard normal distribution
+static double normal_quantile(double p) {
+  double low = -40.0;
+  double high = 40.0;
+  for (int i = 0; i < 200; ++i) {
+    double mid = 0.5 * (low + high);
+    if (0.5 * erfc(-mid / sqrt(2.0)) < p) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  return 0.5 * (low + high);
+}
+
+// Quantile of the Student's t distribution from the normal quantile z (Cornish-Fisher expansion, it underestimates
+// the quantile with a single degree of freedom)
+static double student_quantile(double z, unsigned int dof) {
+  double z2 = z * z;
+  double g1 = z * (z2 + 1) / 4;
+  double g2 = z * ((5 * z2 + 16) * z2 + 3) / 96;
+  double g3 = z * (((3 * z2 + 19) * z2 + 17) * z2 - 15) / 384;
+  double g4 = z * ((((79 * z2 + 776) * z2 + 1482) * z2 - 1920) * z2 - 945) / 92160;
+  double n = dof;
+  return z + g1 / n + g2 / (n * n) + g3 / (n * n * n) + g4 / (n * n * n * n);
+}
+
+double CycleError(double total_err, unsigned int cycle_steps) { return total_err / (cycle_steps + 1); }
+
+Tuner::Tuner(vector<double> params, unsigned int max_steps)
+    : optimizer_type(OptimizerType::TWIDDLE), early_abort(EarlyAbort::OFF), store(nullptr),
+      store_context(0), events(nullptr) {
+  SetWarmup(WarmupSettings());
+  SetRepeats(0, 0.05);
+  Reset(params, max_steps);
+}
+
+Tuner::~Tuner() {}
+
+void Tuner::Reset(const vector<double> &params, unsigned int max_steps) {
+  this->initial_params = params;
   this->max_steps = max_steps;
-  this->best_err = numeric_limits<double>::max();
-  this->best_params = params;
   this->total_err = 0.0;
   this->step = 0;
   this->cycle = 1;
-  this->param_idx = 0;
-  this->params_delta.resize(params.size());
-  for (unsigned int i = 0; i < params_delta.size(); ++i) {
+  this->report_pending = false;
+  for (unsigned int i = 0; i < params.size(); ++i) {
     if (Enabled() && params[i] == 0) {
       cout << "[Warining]: Parameter " << i + 1 << " is zero, will not be tuned." << endl;
     }
-    this->params_delta[i] = {params[i] * 0.1, true};
   }
-  this->warmup_steps = 600;
-  this->cte_tolerance = 4.0;
-  this->delta_tolerance = 0.05;
+  this->optimizer = CreateOptimizer(optimizer_type, params);
+  this->optimizer->Propose(candidate);
+  this->cycle_steps = FidelitySteps(max_steps, candidate.fidelity);
+  this->cte_tolerance = TUNER_CTE_TOLERANCE;
+  this->steps_saved = 0;
+  this->aborted_cycles = 0;
+  this->total_warmup = 0;
+  this->warmup_cycles = 0;
+  this->cached_cycles = 0;
+  this->repeated_cycles = 0;
+  this->best_stats.Clear();
+  this->candidate_stats.Clear();
+  this->noise_m2 = 0.0;
+  this->noise_dof = 0;
+  this->repeats = 0;
+  this->repeat_best = false;
+  this->reference.clear();
+  this->reference_err = 0.0;
+  ResetCycle();
+  UpdateStoreContext();
 }
 
-Tuner::~Tuner() {}
+void Tuner::SetOptimizer(OptimizerType type) {
+  optimizer_type = type;
+  Reset(initial_params, max_steps);
+}
+
+void Tuner::SetEarlyAbort(EarlyAbort mode) { early_abort = mode; }
+
+void Tuner::SetRepeats(unsigned int max_repeats, double alpha) {
+  this->max_repeats = max_repeats;
+  repeat_alpha = alpha;
+  repeat_z = normal_quantile(1.0 - alpha);
+}
+
+unsigned long Tuner::RepeatedCycles() { return repeated_cycles; }
+
+void Tuner::SetWarmup(const WarmupSettings &settings) {
+  warmup = settings;
+  cte_window = SlidingWindow(settings.window);
+  steer_window = SlidingWindow(settings.window);
+  speed_window = SlidingWindow(settings.window);
+  ResetCycle();
+  UpdateStoreContext();
+}
+
+void Tuner::SetContinuous(const ContinuousSettings &settings) {
+  continuous = settings;
+  reference.clear();
+  ResetCycle();
+}
+
+void Tuner::SetEvalStore(EvalStore *store, const string &plant) {
+  this->store = store;
+  this->store_plant = plant;
+  UpdateStoreContext();
+}
+
+void Tuner::UpdateStoreContext() {
+  if (store == nullptr) {
+    return;
+  }
+  // The settings that change the outcome of a cycle (the early abort only changes the aborted cycles, that are
+  // recorded as such)
+  ostringstream oss;
+  oss << setprecision(17) << store_plant << ";max_steps=" << cycle_steps << ";warmup=" << warmup.adaptive << ","
+      << warmup.max_steps << "," << warmup.window << "," << warmup.cte_std << "," << warmup.steer_std << ","
+      << warmup.speed_std << ";cte_tolerance=" << cte_tolerance;
+  store_context = EvalStore::Context(oss.str());
+}
+
+unsigned int Tuner::CachedCycles() { return cached_cycles; }
+
+double Tuner::AverageWarmup() { return warmup_cycles == 0 ? 0.0 : static_cast<double>(total_warmup) / warmup_cycles; }
+
+unsigned long Tuner::StepsSaved() { return steps_saved; }
+
+unsigned int Tuner::AbortedCycles() { return aborted_cycles; }
 
 bool Tuner::Enabled() { return max_steps > 0; }
 
+unsigned int Tuner::Cycle() { return cycle; }
+
 bool Tuner::IsResetCycle() { return step == 0; }
 
 bool Tuner::IsTuned() {
-  double sum = accumulate(params_delta.begin(), params_delta.end(), 0.0,
-                          [](double sum, const ParamDelta& param) { return sum + param.value; });
-  return sum <= delta_tolerance;
+  return optimizer->Converged() || (continuous.enabled && continuous.max_cycles > 0 && cycle > continuous.max_cycles);
 }
 
-vector<double> Tuner::BestParams() { return best_params; }
+vector<double> Tuner::BestParams() { return optimizer->BestParams(); }
+
+double Tuner::BestError() { return optimizer->BestError(); }
+
+vector<double> Tuner::Tune(double cte, double speed, double steer_value, double dt) {
+  CompleteCycle();
+
+  // The stored errors are single cycles, not comparable with the means of the repeated cycles
+  if (step == 0 && !continuous.enabled && max_repeats == 0) {
+    SkipEvaluatedCycles();
+  }
 
-vector<double> Tuner::Tune(double cte) {
   if (IsTuned()) {
-    cout << "Tuning finished, best error: " << best_err << endl;
-    PrintBestParams();
+    TunerEvent &finished = NewEvent(TunerEventType::FINISHED);
+    finished.avg_warmup = AverageWarmup();
+    finished.steps_saved = steps_saved;
+    finished.aborted_cycles = aborted_cycles;
+    finished.cached_cycles = cached_cycles;
+    Emit();
     max_steps = 0;  // Disable tuner
-    return best_params;
+    return BestParams();
+  }
+
+  if (continuous.enabled) {
+    return TuneContinuous(cte, speed, steer_value, dt);
+  }
+
+  if (warmup.adaptive && step < warmup_steps) {
+    cte_window.Add(cte);
+    steer_window.Add(steer_value);
+    if (!std::isnan(speed)) {
+      speed_window.Add(speed);
+    }
+    if (IsSteady()) {
+      warmup_steps = step;
+    }
   }
 
   if (step == warmup_steps) {
-    cout << "Cycle " << cycle << " Warmup Completed" << endl;
+    NewEvent(TunerEventType::WARMUP).steps = step;
+    Emit();
+    total_warmup += step;
+    ++warmup_cycles;
   }
 
   // Let the simulation sink in for a while
@@ -61,113 +203,457 @@ vector<double> Tuner::Tune(double cte) {
   }
 
   double cte_abs = fabs(cte);
+  max_cte = fmax(max_cte, cte_abs);
+
+  bool aborted = cte_abs <= cte_tolerance && step >= warmup_steps && step < (cycle_steps + warmup_steps) &&
+                 CannotImprove();
 
   // End of collection cycle
-  if (step++ == (max_steps + warmup_steps) || cte_abs > cte_tolerance) {
+  if (step++ == (cycle_steps + warmup_steps) || cte_abs > cte_tolerance || aborted) {
     // Computes the average error
     double err_avg;
 
     if (cte_abs > cte_tolerance) {
       err_avg = cte_abs;
+    } else if (aborted) {
+      // The error that the cycle would have at least, not lower than the best error
+      err_avg = abort_err;
+      steps_saved += cycle_steps + warmup_steps + 1 - step;
+      ++aborted_cycles;
     } else {
-      err_avg = total_err / (step - warmup_steps);
+      err_avg = CycleError(total_err, cycle_steps);
     }
 
-    cout << endl << "End of Cycle " << cycle << endl;
-    cout << "----------------------------------------------" << endl;
-    PrintParams();
-    PrintParamsDelta();
-    cout << setw(PRINT_INDENT) << "Cycle Error: " << err_avg << endl;
-    cout << setw(PRINT_INDENT) << "Previous Best: " << best_err << endl;
-    cout << setw(PRINT_INDENT) << "Current index: " << param_idx << endl;
-    cout << setw(PRINT_INDENT) << "Error delta: " << (err_avg - best_err) << endl;
-
-    if (err_avg < best_err) {
-      // Error improved
-      best_err = err_avg;
-      best_params = params;
-      TuneUp();                                  // Tune up this parameter
-      params_delta[param_idx].increment = true;  // Reset increment status
-      NextParam();                               // Tune next param
-    } else if (params_delta[param_idx].increment) {
-      params_delta[param_idx].increment = false;  // Try decrementing
-    } else {
-      Increase();                                // Puts back to original value
-      TuneDown();                                // Tune down this parameter
-      params_delta[param_idx].increment = true;  // Try incrementing
-      NextParam();                               // Tune next param
+    // Only the errors of the full cycles are compared
+    bool complete = !aborted && cte_abs <= cte_tolerance && candidate.fidelity >= 1.0;
+
+    if (store != nullptr) {
+      unsigned int flags = (aborted ? EVAL_ABORTED : 0) | (cte_abs > cte_tolerance ? EVAL_OFF_TRACK : 0);
+      store->Append(repeat_best ? BestParams() : candidate.params, store_context,
+                    {err_avg, max_cte, step, EvalStore::Now(), flags});
     }
 
-    if (params_delta[param_idx].increment) {
-      Increase();
-    } else {
-      Decrease();
+    TunerEvent &end = NewEvent(TunerEventType::CYCLE_END);
+    end.flags = EVENT_RESET | (aborted ? EVENT_ABORTED : 0) | (cte_abs > cte_tolerance ? EVENT_OFF_TRACK : 0) |
+                (repeat_best ? EVENT_REPEAT_BEST : repeats > 0 ? EVENT_REPEAT : 0);
+    end.err = err_avg;
+    end.steps = step;
+    end.cycle_steps = cycle_steps;
+    end.steps_saved = steps_saved;
+    end.aborted_cycles = aborted_cycles;
+    end.repeats = repeats;
+    end.max_repeats = max_repeats;
+    optimizer->GetState(end.state);
+    Emit();
+
+    if (max_repeats > 0 && complete && !CompareCandidate(err_avg)) {
+      // The comparison needs another cycle
+      ResetCycle();
+      ++cycle;
+      return repeat_best ? BestParams() : candidate.params;
     }
 
-    cout << setw(PRINT_INDENT) << "Current Best: " << best_err << endl;
-    PrintBestParams();
-    cout << "----------------------------------------------" << endl << endl;
+    if (repeat_best && !complete) {
+      // The best parameters left the track, the candidate is not accepted on a comparison that did not complete
+      err_avg = BestError();
+    }
+
+    // The simulator is reset with the current coefficients, the next candidate is proposed by CompleteCycle
+    report_pending = true;
+    report_err = err_avg;
+
     // Clear the cycle
     ResetCycle();
-    ++cycle;
   }
 
-  return params;
+  return repeat_best ? BestParams() : candidate.params;
 }
 
-void Tuner::NextParam() {
-  ++param_idx %= params.size();
-  while (params_delta[param_idx].value == 0) {
-    // Skip parameters that have a delta of zero
-    NextParam();
+void Tuner::CompleteCycle() {
+  if (!report_pending) {
+    return;
   }
+  report_pending = false;
+  NextCandidate(report_err);
+  ++cycle;
 }
 
-void Tuner::TuneUp() {
-  cout << setw(PRINT_INDENT - 3) << "TUNING p_delta_" << param_idx << ": (" << params_delta[param_idx].value
-       << " * 1.1)" << endl;
-  params_delta[param_idx].value *= 1.1;
+void Tuner::GetCheckpoint(TunerCheckpoint &checkpoint) {
+  checkpoint.optimizer = optimizer_type;
+  optimizer->Save(checkpoint.state);
+  checkpoint.best_params = optimizer->BestParams();
+  checkpoint.best_err = optimizer->BestError();
+  checkpoint.cycle = cycle;
+  checkpoint.max_steps = max_steps;
+  checkpoint.steps_saved = steps_saved;
+  checkpoint.aborted_cycles = aborted_cycles;
+  checkpoint.total_warmup = total_warmup;
+  checkpoint.warmup_cycles = warmup_cycles;
 }
 
-void Tuner::TuneDown() {
-  cout << setw(PRINT_INDENT - 3) << "TUNING p_delta_" << param_idx << ": (" << params_delta[param_idx].value
-       << " * 0.9)" << endl;
-  params_delta[param_idx].value *= 0.9;
+bool Tuner::Restore(const TunerCheckpoint &checkpoint) {
+  unique_ptr<Optimizer> restored = CreateOptimizer(checkpoint.optimizer, initial_params);
+  if (checkpoint.best_params.size() != initial_params.size() || !restored->Restore(checkpoint.state)) {
+    return false;
+  }
+  optimizer_type = checkpoint.optimizer;
+  optimizer = move(restored);
+  optimizer->Propose(candidate);
+  report_pending = false;
+  UpdateCycleSteps();
+  reference.clear();
+  // The evaluations are not saved, the first comparison uses the restored best error as it is
+  best_stats.Clear();
+  candidate_stats.Clear();
+  repeats = 0;
+  repeat_best = false;
+  cycle = checkpoint.cycle;
+  steps_saved = checkpoint.steps_saved;
+  aborted_cycles = checkpoint.aborted_cycles;
+  total_warmup = checkpoint.total_warmup;
+  warmup_cycles = checkpoint.warmup_cycles;
+  ResetCycle();
+  return true;
 }
 
-void Tuner::Increase() {
-  double delta = params_delta[param_idx].value;
-  cout << setw(PRINT_INDENT - 3) << "INCREASING p_" << param_idx << ": (" << params[param_idx] << " + " << delta << ")"
-       << endl;
-  params[param_idx] += delta;
+void Tuner::NextCandidate(double err_avg) {
+  double previous_best = BestError();
+  optimizer->Report(candidate, err_avg);
+  TunerEvent &report = NewEvent(TunerEventType::REPORT);
+  report.flags = BestError() < previous_best ? EVENT_ACCEPTED : 0;
+  report.err = err_avg;
+  Emit();
+  RunningStats &retired = BestError() < previous_best ? best_stats : candidate_stats;
+  if (retired.Count() > 1) {
+    noise_m2 += retired.Variance() * (retired.Count() - 1);
+    noise_dof += retired.Count() - 1;
+  }
+  if (&retired == &best_stats) {
+    best_stats = candidate_stats;
+  }
+  candidate_stats.Clear();
+  repeats = 0;
+  repeat_best = false;
+  optimizer->Propose(candidate);
+  UpdateCycleSteps();
 }
 
-void Tuner::Decrease() {
-  double delta = 2 * params_delta[param_idx].value;
-  cout << setw(PRINT_INDENT - 3) << "DECREASING p_" << param_idx << ": (" << params[param_idx] << " - " << delta << ")"
-       << endl;
-  params[param_idx] -= delta;
+bool Tuner::CompareCandidate(double &err_avg) {
+  (repeat_best ? best_stats : candidate_stats).Add(log(fmax(err_avg, 1e-12)));
+
+  // Without an evaluation of the best parameters (e.g. the first cycle) the errors are compared as they are
+  if (best_stats.Count() == 0 || candidate_stats.Count() == 0) {
+    return true;
+  }
+
+  // The variance of the log errors is pooled over all the parameters evaluated more than once
+  double m2 = noise_m2 + best_stats.Variance() * (best_stats.Count() - 1) +
+              candidate_stats.Variance() * (candidate_stats.Count() - 1);
+  unsigned int dof = noise_dof + best_stats.Count() - 1 + candidate_stats.Count() - 1;
+  double difference = best_stats.Mean() - candidate_stats.Mean();
+  double deviation = dof > 0 ? sqrt(m2 / dof * (1.0 / best_stats.Count() + 1.0 / candidate_stats.Count())) : 0.0;
+
+  TunerEvent &comparison = NewEvent(TunerEventType::COMPARISON);
+  comparison.log_ratio = -difference;
+  comparison.candidate_cycles = candidate_stats.Count();
+  comparison.best_cycles = best_stats.Count();
+
+  if (difference <= 0.0 || (dof > 0 && difference > student_quantile(repeat_z, dof) * deviation)) {
+    comparison.outcome = difference > 0.0 ? ComparisonOutcome::SIGNIFICANT : ComparisonOutcome::NONE;
+    Emit();
+    // Relative to the reported best error, so that an accepted candidate is always reported below it and a rejected
+    // one never is
+    err_avg = BestError() * exp(-difference);
+    return true;
+  }
+
+  if (repeats == max_repeats) {
+    comparison.outcome = ComparisonOutcome::MEANS;
+    Emit();
+    err_avg = BestError() * exp(-difference);
+    return true;
+  }
+
+  // The side with the fewer cycles contributes the most to the deviation
+  repeat_best = best_stats.Count() < candidate_stats.Count();
+  ++repeats;
+  ++repeated_cycles;
+
+  comparison.outcome = repeat_best ? ComparisonOutcome::REPEAT_BEST : ComparisonOutcome::REPEAT_CANDIDATE;
+  Emit();
+
+  return false;
+}
+
+void Tuner::UpdateCycleSteps() {
+  unsigned int steps = FidelitySteps(max_steps, candidate.fidelity);
+  if (steps != cycle_steps) {
+    cycle_steps = steps;
+    UpdateStoreContext();
+  }
+}
+
+void Tuner::SkipEvaluatedCycles() {
+  EvalResult result;
+
+  while (store != nullptr && Enabled() && !IsTuned() && store->Lookup(candidate.params, store_context, result)) {
+    // An aborted cycle only tells that the candidate cannot beat an error at least as high as the current best
+    if ((result.flags & EVAL_ABORTED) && result.avg_err < BestError()) {
+      break;
+    }
+
+    NewEvent(TunerEventType::CACHED).err = result.avg_err;
+    Emit();
+
+    ++cached_cycles;
+    NextCandidate(result.avg_err);
+    ++cycle;
+  }
 }
 
 void Tuner::ResetCycle() {
   step = 0;
+  warmup_steps = warmup.max_steps;
+  cte_window.Clear();
+  steer_window.Clear();
+  speed_window.Clear();
   total_err = 0.0;
+  max_cte = 0.0;
+  distance = 0.0;
+  segment = -1;
+  segment_err = 0.0;
+  segment_steps = 0;
+  settle_remaining = 0;
+  window_segments = 0;
+  scored_segments.clear();
+  scored_errors.clear();
 }
 
-void Tuner::PrintParams() {
-  cout << setw(PRINT_INDENT) << "Params: ";
-  for_each(params.begin(), params.end(), [](double param) { cout << param << " "; });
-  cout << endl;
+vector<double> Tuner::TuneContinuous(double cte, double speed, double steer_value, double dt) {
+  double cte_abs = fabs(cte);
+  max_cte = fmax(max_cte, cte_abs);
+
+  if (cte_abs > cte_tolerance) {
+    // Off track, the only case in which the simulator is reset
+    TunerEvent &end = NewEvent(TunerEventType::CYCLE_END);
+    end.flags = EVENT_OFF_TRACK | EVENT_RESET;
+    end.err = cte_abs;
+    end.steps = step;
+    optimizer->GetState(end.state);
+    Emit();
+    NextCandidate(cte_abs);
+    ResetCycle();
+    ++cycle;
+    return candidate.params;
+  }
+
+  if (!std::isnan(speed) && !std::isnan(dt)) {
+    distance += speed * MPH_TO_MPS * dt;
+  }
+
+  if (segment < 0) {
+    // Warmup after a reset
+    if (warmup.adaptive && step < warmup_steps) {
+      cte_window.Add(cte);
+      steer_window.Add(steer_value);
+      if (!std::isnan(speed)) {
+        speed_window.Add(speed);
+      }
+      if (IsSteady()) {
+        warmup_steps = step;
+      }
+    }
+    if (step >= warmup_steps) {
+      NewEvent(TunerEventType::WARMUP).steps = step;
+      Emit();
+      total_warmup += step;
+      ++warmup_cycles;
+      segment = SegmentAt(distance);
+      StartEvaluation();
+      // The current segment is only partly driven
+      ++settle_remaining;
+    }
+  } else {
+    long current = SegmentAt(distance);
+    if (current != segment) {
+      // The gains are only swapped at the segment boundaries
+      EndSegment();
+      segment = current;
+    }
+    segment_err += cte * cte;
+    ++segment_steps;
+  }
+
+  ++step;
+
+  return candidate.params;
 }
 
-void Tuner::PrintBestParams() {
-  cout << setw(PRINT_INDENT) << "Best params: ";
-  for_each(best_params.begin(), best_params.end(), [](double param) { cout << param << " "; });
-  cout << endl;
+void Tuner::EndSegment() {
+  if (segment_steps > 0) {
+    if (settle_remaining > 0) {
+      --settle_remaining;
+    } else {
+      scored_segments.push_back(segment % SegmentCount());
+      scored_errors.push_back(segment_err / segment_steps);
+    }
+  }
+
+  segment_err = 0.0;
+  segment_steps = 0;
+
+  if (scored_segments.size() >= window_segments) {
+    EndEvaluation();
+  }
 }
 
-void Tuner::PrintParamsDelta() {
-  cout << setw(PRINT_INDENT) << "Params delta: ";
-  for_each(params_delta.begin(), params_delta.end(), [](ParamDelta delta) { cout << delta.value << " "; });
-  cout << endl;
-}
\ No newline at end of file
+void Tuner::EndEvaluation() {
+  bool first_lap = reference.empty();
+  size_t count = scored_segments.size();
+
+  if (first_lap) {
+    reference.assign(SegmentCount(), 0.0);
+    reference_err = 0.0;
+    for (unsigned int i = 0; i < count; ++i) {
+      reference[scored_segments[i]] = scored_errors[i];
+      reference_err += scored_errors[i] / count;
+    }
+  }
+
+  double candidate_sum = 0.0;
+  double reference_sum = 0.0;
+  for (unsigned int i = 0; i < count; ++i) {
+    candidate_sum += scored_errors[i];
+    reference_sum += reference[scored_segments[i]];
+  }
+  double ratio = candidate_sum / fmax(reference_sum, numeric_limits<double>::min());
+
+  // Only the fixed reference lap is the scale of the error, a score derived from the previous scores (e.g. the best
+  // error) would compound their noise, which only ever lowers the best error. The candidates of a lower fidelity drive
+  // fewer segments on the same scale (the best error of a multi-fidelity optimizer is unset until a full evaluation)
+  double err_avg = reference_err * ratio;
+
+  TunerEvent &end = NewEvent(TunerEventType::CYCLE_END);
+  end.flags = first_lap ? EVENT_REFERENCE : 0;
+  end.err = err_avg;
+  end.steps = step;
+  end.segments = count;
+  end.position = segment * continuous.segment_length;
+  end.ratio = ratio;
+  optimizer->GetState(end.state);
+  Emit();
+
+  NextCandidate(err_avg);
+
+  ++cycle;
+  StartEvaluation();
+}
+
+void Tuner::StartEvaluation() {
+  scored_segments.clear();
+  scored_errors.clear();
+  max_cte = 0.0;
+
+  if (reference.empty()) {
+    // The reference lap, after a lap for the errors to reach their steady state (the accumulated error of the PID
+    // takes about a lap to build up)
+    settle_remaining = SegmentCount();
+    window_segments = SegmentCount();
+  } else {
+    settle_remaining = continuous.settle_segments;
+    window_segments = FidelitySteps(continuous.scored_segments, candidate.fidelity);
+  }
+}
+
+unsigned int Tuner::SegmentCount() {
+  return max(1u, static_cast<unsigned int>(ceil(continuous.lap_length / continuous.segment_length)));
+}
+
+long Tuner::SegmentAt(double distance) {
+  long count = SegmentCount();
+  double lap = floor(distance / continuous.lap_length);
+  long index = static_cast<long>((distance - lap * continuous.lap_length) / continuous.segment_length);
+  return static_cast<long>(lap) * count + min(index, count - 1);
+}
+
+bool Tuner::IsSteady() {
+  if (!cte_window.Full() || !steer_window.Full()) {
+    return false;
+  }
+  if (sqrt(cte_window.Variance()) > warmup.cte_std || sqrt(steer_window.Variance()) > warmup.steer_std) {
+    return false;
+  }
+  // The speed is ignored if not known, otherwise the vehicle must be moving at a stable speed
+  if (speed_window.Full()) {
+    double mean = speed_window.Mean();
+    return mean > 0.0 && sqrt(speed_window.Variance()) <= warmup.speed_std * mean;
+  }
+  return true;
+}
+
+bool Tuner::CannotImprove() {
+  double best_err = optimizer->BestError();
+
+  // The errors of the shorter cycles are not comparable with the best error, the repeated cycles are compared on
+  // their mean
+  // The error of an aborted cycle is only a lower bound (e.g. after resuming with another optimizer)
+  if (early_abort == EarlyAbort::OFF || !AcceptsLowerBounds(optimizer_type) ||
+      best_err == numeric_limits<double>::max() || candidate.fidelity < 1.0 || repeats > 0) {
+    return false;
+  }
+
+  // Number of errors collected in a whole cycle
+  double samples = cycle_steps + 1;
+
+  // The remaining errors can only increase the total
+  if (total_err >= best_err * samples) {
+    abort_err = total_err / samples;
+    return true;
+  }
+
+  return false;
+}
+
+void Tuner::SetEventSink(TunerEventSink *sink) { events = sink; }
+
+void Tuner::Announce() {
+  optimizer->GetState(NewEvent(TunerEventType::START).state);
+  Emit();
+}
+
+TunerEvent &Tuner::NewEvent(TunerEventType type) {
+  event.type = type;
+  event.timestamp = EvalStore::Now();
+  event.cycle = cycle;
+  event.flags = 0;
+  event.params = candidate.params;
+  event.best_params = optimizer->BestParams();
+  event.best_err = optimizer->BestError();
+  event.err = 0.0;
+  event.steps = 0;
+  event.cycle_steps = cycle_steps;
+  event.fidelity = candidate.fidelity;
+  event.steps_saved = 0;
+  event.aborted_cycles = 0;
+  event.repeats = 0;
+  event.max_repeats = 0;
+  event.outcome = ComparisonOutcome::NONE;
+  event.log_ratio = 0.0;
+  event.candidate_cycles = 0;
+  event.best_cycles = 0;
+  event.segments = 0;
+  event.position = 0.0;
+  event.ratio = 0.0;
+  event.avg_warmup = 0.0;
+  event.cached_cycles = 0;
+  event.state.clear();
+  return event;
+}
+
+void Tuner::Emit() {
+  if (events != nullptr) {
+    events->Emit(event);
+  } else {
+    console.Emit(event);
+  }
+}
@@ -1,55 +1,351 @@
 #ifndef TUNER_H
 #define TUNER_H
 
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
+#include "EvalStore.h"
+#include "Optimizer.h"
+#include "RunningStats.h"
+#include "SlidingWindow.h"
+#include "TunerEvents.h"
 
-struct ParamDelta {
-  double value;
-  bool increment;
+// Default max number of warmup steps of a cycle
+#define TUNER_WARMUP_STEPS 600
+// Absolute cross track error that ends a cycle, the vehicle left the track
+#define TUNER_CTE_TOLERANCE 4.0
+
+/*
+ * The error of a complete cycle: the average squared cross track error over the steps after the warmup, a cycle of
+ * cycle_steps steps collects the errors of cycle_steps + 1 steps (the step that ends it included).
+ *
+ * @param total_err The sum of the squared cross track errors after the warmup
+ * @param cycle_steps The steps of the cycle after the warmup
+ */
+double CycleError(double total_err, unsigned int cycle_steps);
+
+/*
+ * Early termination of the tuning cycles that cannot beat the best error.
+ */
+enum class EarlyAbort {
+  OFF,
+  // Ends the cycle as soon as the accumulated error alone exceeds the best error, the cycle result is the same as
+  // running the cycle to completion (the squared errors are never negative)
+  BOUND
+};
+
+/*
+ * Detection of the end of the transient at the start of each cycle: the error collection starts as soon as the
+ * standard deviations of the CTE, steering value and speed over the last window steps are below the thresholds, or
+ * after max_steps in any case.
+ */
+struct WarmupSettings {
+  // When false (default) the warmup always lasts max_steps
+  bool adaptive;
+  unsigned int max_steps;
+  unsigned int window;
+  double cte_std;
+  double steer_std;
+  // Relative to the average speed
+  double speed_std;
+
+  WarmupSettings()
+      : adaptive(false), max_steps(TUNER_WARMUP_STEPS), window(50), cte_std(0.3), steer_std(0.05), speed_std(0.02) {}
 };
 
+/*
+ * Reset-free tuning: the simulator is only reset when the vehicle leaves the track. The lap is split into segments
+ * by the distance travelled (integrated from the speed), the gains are swapped at the segment boundaries and each
+ * candidate drives a few segments. The initial parameters drive a whole lap, its segment errors are the reference
+ * (how hard each segment is). A candidate is scored by the ratio of its errors to the reference errors of the
+ * segments it drove: the cycle error is the average error of the reference lap scaled by that ratio, so that every
+ * score is measured against the same fixed reference.
+ */
+struct ContinuousSettings {
+  bool enabled;
+  // Length of a lap (m), the segments start at the start of the lap
+  double lap_length;
+  // Length of a segment (m), the last segment of the lap may be shorter
+  double segment_length;
+  // Segments driven by a candidate before its errors are collected, while the vehicle settles after the swap
+  unsigned int settle_segments;
+  // Segments on which a candidate is scored (scaled by the fidelity of the candidate)
+  unsigned int scored_segments;
+  // The tuning finishes after max_cycles cycles if the optimizer did not converge (the scores of a few segments are
+  // noisy), 0 for no limit
+  unsigned int max_cycles;
+
+  ContinuousSettings()
+      : enabled(false),
+        lap_length(0.0),
+        segment_length(50.0),
+        settle_segments(1),
+        scored_segments(3),
+        max_cycles(1000) {}
+};
+
+/*
+ * Tuner state at the end of a cycle, enough to resume the tuning from the next cycle (see Checkpoint.h).
+ */
+struct TunerCheckpoint {
+  OptimizerType optimizer;
+  // See Optimizer::Save
+  std::vector<double> state;
+  std::vector<double> best_params;
+  double best_err;
+  unsigned int cycle;
+  unsigned int max_steps;
+  unsigned long steps_saved;
+  unsigned int aborted_cycles;
+  unsigned long total_warmup;
+  unsigned int warmup_cycles;
+};
+
+/*
+ * Runs the tuning cycles on the simulator: each cycle evaluates the candidate coefficients proposed by the optimizer
+ * on max_steps steps (after the warmup, scaled by the fidelity of the candidate), the cycle error (average squared
+ * CTE) is reported to the optimizer and the simulator is reset for the next candidate.
+ */
 class Tuner {
  public:
   Tuner(std::vector<double> params, unsigned int max_steps);
 
   virtual ~Tuner();
 
-  std::vector<double> Tune(double cte);
+  /*
+   * Restarts the tuning from the given parameters, reusing the allocated storage.
+   */
+  void Reset(const std::vector<double> &params, unsigned int max_steps);
+
+  /*
+   * Processes the telemetry of a step.
+   *
+   * @param cte Cross track error value
+   * @param speed The current speed, NaN if not known (ignored by the warmup detection)
+   * @param steer_value The steering value of the previous step
+   * @param dt Time since the previous step (s), NaN if not known (only needed by the reset-free tuning)
+   *
+   * @return The coefficients to use
+   */
+  std::vector<double> Tune(double cte, double speed, double steer_value, double dt);
+
+  /*
+   * Reports the error of the cycle that ended on the last step (IsResetCycle) to the optimizer and proposes the next
+   * candidate. Deferred by Tune so that the reset can be sent to the simulator first, the optimizer may take
+   * milliseconds (e.g. BayesOpt). Does nothing if no report is pending, called by the next Tune otherwise.
+   */
+  void CompleteCycle();
+
+  /*
+   * Sets the optimizer proposing the candidates, kept across Reset. The tuning restarts from the initial parameters.
+   */
+  void SetOptimizer(OptimizerType type);
 
   std::vector<double> BestParams();
 
+  /*
+   * The average error of the best cycle, max double if no cycle was completed.
+   */
+  double BestError();
+
   bool IsResetCycle();
 
   bool IsTuned();
 
   bool Enabled();
 
-  void PrintParams();
-  void PrintBestParams();
-  void PrintParamsDelta();
+  unsigned int Cycle();
+
+  /*
+   * Sets the early termination of the cycles, kept across Reset. Only used with the optimizers that accept a lower
+   * bound of the error of an aborted cycle (see AcceptsLowerBounds).
+   *
+   * @param mode The early termination mode
+   */
+  void SetEarlyAbort(EarlyAbort mode);
+
+  /*
+   * Number of simulator steps saved by the early termination since the tuning started.
+   */
+  unsigned long StepsSaved();
+
+  unsigned int AbortedCycles();
+
+  /*
+   * Sets the warmup detection, kept across Reset.
+   */
+  void SetWarmup(const WarmupSettings &settings);
+
+  /*
+   * Average number of warmup steps of the cycles that completed the warmup.
+   */
+  double AverageWarmup();
+
+  /*
+   * Sets the significance test of the improvements, kept across Reset. The logs of the errors of the full cycles are
+   * averaged over the evaluations of the same parameters, and a candidate only replaces the best parameters when its
+   * mean is lower with the given significance level (one sided t test, with the variance pooled over all the
+   * parameters evaluated more than once). While a lower error is not significant, the candidate or the
+   * best parameters (whichever has the fewer cycles) are evaluated again, up to max_repeats more cycles, after which
+   * the means are compared as they are. The cycles of a candidate are reported to the optimizer as a single one.
+   *
+   * @param max_repeats Max number of repeated cycles of a comparison, 0 to accept any lower error (default)
+   * @param alpha Significance level of the test
+   */
+  void SetRepeats(unsigned int max_repeats, double alpha);
+
+  /*
+   * Number of cycles that repeated the evaluation of a candidate or of the best parameters.
+   */
+  unsigned long RepeatedCycles();
+
+  /*
+   * Sets the reset-free tuning, kept across Reset. The early termination, the repeated evaluations and the evaluation
+   * store are not used by the reset-free tuning.
+   */
+  void SetContinuous(const ContinuousSettings &settings);
+
+  /*
+   * Sets the store of the evaluated coefficients, kept across Reset. Before running a cycle the store is queried and
+   * the cycles already evaluated (with the same plant and settings) are not run again, every cycle that is run is
+   * added to the store.
+   *
+   * @param store The store, nullptr to disable
+   * @param plant Description of the plant (e.g. simulator and track) the cycles are run on
+   */
+  void SetEvalStore(EvalStore *store, const std::string &plant);
+
+  /*
+   * Number of cycles served from the evaluation store since the tuning started.
+   */
+  unsigned int CachedCycles();
+
+  /*
+   * Copies the tuner state into the given checkpoint, reusing its storage. Meant to be called at the end of a cycle,
+   * the progress of the current cycle is not included and its candidate is evaluated again after a restore.
+   */
+  void GetCheckpoint(TunerCheckpoint &checkpoint);
+
+  /*
+   * Resumes the tuning from the given checkpoint (with the optimizer of the checkpoint), the current cycle restarts.
+   * The number of steps of a cycle and the early termination and warmup settings are kept.
+   *
+   * @return False if the checkpoint does not match the parameters of the tuner
+   */
+  bool Restore(const TunerCheckpoint &checkpoint);
+
+  /*
+   * Sets the receiver of the progress of the tuning, kept across Reset. The events are printed to the console by
+   * default.
+   *
+   * @param sink The receiver, nullptr for the console
+   */
+  void SetEventSink(TunerEventSink *sink);
+
+  /*
+   * Emits a START event with the current candidate and the state of the optimizer.
+   */
+  void Announce();
 
  private:
-  std::vector<double> params;
-  std::vector<double> best_params;
-  std::vector<ParamDelta> params_delta;
+  std::vector<double> initial_params;
+  OptimizerType optimizer_type;
+  std::unique_ptr<Optimizer> optimizer;
+  // Candidate of the current cycle
+  Candidate candidate;
 
   unsigned int cycle;
   unsigned int step;
   unsigned int max_steps;
+  // Steps of the current cycle after the warmup, max_steps scaled by the fidelity of the candidate
+  unsigned int cycle_steps;
+  // Warmup steps of the current cycle, the max until the steady state is detected
   unsigned int warmup_steps;
-  unsigned int param_idx;
+  // Error of the cycle that ended on the last step, not reported yet (see CompleteCycle)
+  bool report_pending;
+  double report_err;
 
-  double best_err;
   double total_err;
   double cte_tolerance;
-  double delta_tolerance;
 
-  void NextParam();
-  void TuneUp();
-  void TuneDown();
-  void Increase();
-  void Decrease();
+  EarlyAbort early_abort;
+  // Lower bound of the error of the last aborted cycle
+  double abort_err;
+  unsigned long steps_saved;
+  unsigned int aborted_cycles;
+
+  unsigned int max_repeats;
+  double repeat_alpha;
+  // Normal quantile of the significance level
+  double repeat_z;
+  // Log errors of the full cycles of the best parameters and of the candidate (no cycles when the best error does not
+  // come from a full cycle), and the sum of squared deviations of the parameters no longer compared
+  RunningStats best_stats;
+  RunningStats candidate_stats;
+  double noise_m2;
+  unsigned int noise_dof;
+  // Repeated cycles of the current comparison, and whether the current cycle evaluates the best parameters again
+  unsigned int repeats;
+  bool repeat_best;
+  unsigned long repeated_cycles;
+
+  // Warmup detection of the current cycle (see IsSteady), and the warmup steps of the cycles that completed it
+  WarmupSettings warmup;
+  SlidingWindow cte_window;
+  SlidingWindow steer_window;
+  SlidingWindow speed_window;
+  unsigned long total_warmup;
+  unsigned int warmup_cycles;
+
+  EvalStore *store;
+  std::string store_plant;
+  uint64_t store_context;
+  unsigned int cached_cycles;
+  // Max absolute cross track error of the current cycle
+  double max_cte;
+
+  ContinuousSettings continuous;
+  // Distance travelled since the last reset (m)
+  double distance;
+  // Segment being driven (counting the laps), -1 during the warmup
+  long segment;
+  // Errors of the segment being driven
+  double segment_err;
+  unsigned int segment_steps;
+  // Segments still to settle and to score of the current candidate
+  unsigned int settle_remaining;
+  unsigned int window_segments;
+  // Segments (index in the lap) scored for the current candidate and their average squared CTE
+  std::vector<unsigned int> scored_segments;
+  std::vector<double> scored_errors;
+  // Average squared CTE of the reference on each segment of the lap, empty until the first lap is driven, and over
+  // the whole lap
+  std::vector<double> reference;
+  double reference_err;
+
+  // Receiver of the events, the console when nullptr
+  TunerEventSink *events;
+  ConsoleEventSink console;
+  // Reused for every event
+  TunerEvent event;
+
   void ResetCycle();
+  TunerEvent &NewEvent(TunerEventType type);
+  void Emit();
+  std::vector<double> TuneContinuous(double cte, double speed, double steer_value, double dt);
+  void EndSegment();
+  void EndEvaluation();
+  void StartEvaluation();
+  unsigned int SegmentCount();
+  long SegmentAt(double distance);
+  void NextCandidate(double err_avg);
+  bool CompareCandidate(double &err_avg);
+  void UpdateCycleSteps();
+  void UpdateStoreContext();
+  void SkipEvaluatedCycles();
+  bool IsSteady();
+  bool CannotImprove();
 };
 
 #endif /* TUNER_H */
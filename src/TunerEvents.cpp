@@ -0,0 +1,293 @@
+#include "TunerEvents.h"
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "Format.h"
+
+using namespace std;
+
+#define PRINT_INDENT 19
+#define SEPARATOR "----------------------------------------------"
+
+void ConsoleEventSink::Emit(const TunerEvent &event) {
+  text.clear();
+  FormatEventText(event, text);
+  cout << text << flush;
+}
+
+const char *EventTypeName(TunerEventType type) {
+  switch (type) {
+    case TunerEventType::START:
+      return "start";
+    case TunerEventType::WARMUP:
+      return "warmup";
+    case TunerEventType::CYCLE_END:
+      return "cycle_end";
+    case TunerEventType::COMPARISON:
+      return "comparison";
+    case TunerEventType::REPORT:
+      return "report";
+    case TunerEventType::CACHED:
+      return "cached";
+    default:
+      return "finished";
+  }
+}
+
+static const char *OutcomeName(ComparisonOutcome outcome) {
+  switch (outcome) {
+    case ComparisonOutcome::SIGNIFICANT:
+      return "significant";
+    case ComparisonOutcome::MEANS:
+      return "means";
+    case ComparisonOutcome::REPEAT_CANDIDATE:
+      return "repeat_candidate";
+    case ComparisonOutcome::REPEAT_BEST:
+      return "repeat_best";
+    default:
+      return "none";
+  }
+}
+
+static void PrintValues(ostream &out, const char *name, const vector<double> &values) {
+  out << setw(PRINT_INDENT) << name;
+  for (double value : values) {
+    out << value << " ";
+  }
+  out << endl;
+}
+
+void FormatEventText(const TunerEvent &event, string &text) {
+  ostringstream out;
+
+  switch (event.type) {
+    case TunerEventType::START:
+      out << "Tuning ENABLED" << endl;
+      PrintValues(out, "Params: ", event.params);
+      out << FormatOptimizerState(event.state);
+      break;
+    case TunerEventType::WARMUP:
+      out << "Cycle " << event.cycle << " Warmup Completed (" << event.steps << " steps)" << endl;
+      break;
+    case TunerEventType::CYCLE_END:
+      out << endl << "End of Cycle " << event.cycle << (event.flags & EVENT_OFF_TRACK ? " (off track)" : "") << endl;
+      if (event.flags & EVENT_RESET) {
+        out << "Resetting simulator" << endl;
+      }
+      out << SEPARATOR << endl;
+      if (event.flags & EVENT_REPEAT_BEST) {
+        out << setw(PRINT_INDENT) << "Repeated: " << "best params, for the candidate" << endl;
+        PrintValues(out, "Best params: ", event.best_params);
+      } else if (event.flags & EVENT_REPEAT) {
+        out << setw(PRINT_INDENT) << "Repeated: " << "candidate (" << event.repeats << " of " << event.max_repeats
+            << ")" << endl;
+      }
+      if (event.flags & EVENT_ABORTED) {
+        out << setw(PRINT_INDENT) << "Aborted at step: " << event.steps << " (" << event.steps_saved
+            << " steps saved in " << event.aborted_cycles << " cycles)" << endl;
+      }
+      PrintValues(out, "Params: ", event.params);
+      out << FormatOptimizerState(event.state);
+      if (event.fidelity < 1.0) {
+        out << setw(PRINT_INDENT) << "Cycle Steps: " << event.cycle_steps << " (fidelity " << event.fidelity << ")"
+            << endl;
+      }
+      if (event.segments > 0) {
+        out << setw(PRINT_INDENT) << "Segments: " << event.segments << " at " << event.position << " m";
+        if (event.flags & EVENT_REFERENCE) {
+          out << " (reference lap)" << endl;
+        } else {
+          out << " (ratio to the reference " << event.ratio << ")" << endl;
+        }
+      }
+      out << setw(PRINT_INDENT) << "Cycle Error: " << event.err << endl;
+      out << setw(PRINT_INDENT) << "Previous Best: " << event.best_err << endl;
+      out << setw(PRINT_INDENT) << "Error delta: " << (event.err - event.best_err) << endl;
+      break;
+    case TunerEventType::COMPARISON:
+      out << setw(PRINT_INDENT) << "Log error ratio: " << event.log_ratio << " (" << event.candidate_cycles << " vs "
+          << event.best_cycles << " cycles)" << endl;
+      out << setw(PRINT_INDENT) << "Improvement: ";
+      switch (event.outcome) {
+        case ComparisonOutcome::SIGNIFICANT:
+          out << "significant" << endl;
+          break;
+        case ComparisonOutcome::MEANS:
+          out << "not significant, compared on the means" << endl;
+          break;
+        case ComparisonOutcome::REPEAT_CANDIDATE:
+        case ComparisonOutcome::REPEAT_BEST:
+          out << "not significant, evaluating the "
+              << (event.outcome == ComparisonOutcome::REPEAT_BEST ? "best params" : "candidate") << " again" << endl;
+          // The comparison needs another cycle
+          out << SEPARATOR << endl << endl;
+          break;
+        default:
+          out << "none" << endl;
+      }
+      break;
+    case TunerEventType::REPORT:
+      out << setw(PRINT_INDENT) << "Current Best: " << event.best_err << endl;
+      PrintValues(out, "Best params: ", event.best_params);
+      out << SEPARATOR << endl << endl;
+      break;
+    case TunerEventType::CACHED:
+      out << "Cycle " << event.cycle << " already evaluated, error: " << event.err << endl;
+      PrintValues(out, "Params: ", event.params);
+      break;
+    case TunerEventType::FINISHED:
+      out << "Tuning finished, best error: " << event.best_err << endl;
+      PrintValues(out, "Best params: ", event.best_params);
+      out << setw(PRINT_INDENT) << "Average warmup: " << event.avg_warmup << " steps" << endl;
+      if (event.aborted_cycles > 0) {
+        out << setw(PRINT_INDENT) << "Steps saved: " << event.steps_saved << " (" << event.aborted_cycles << " of "
+            << event.cycle - 1 << " cycles aborted)" << endl;
+      }
+      if (event.cached_cycles > 0) {
+        out << setw(PRINT_INDENT) << "Cached cycles: " << event.cached_cycles << " of " << event.cycle - 1 << endl;
+      }
+      break;
+  }
+
+  text += out.str();
+}
+
+static void AppendString(const string &value, string &out) {
+  out += '"';
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+    }
+    out += c;
+  }
+  out += '"';
+}
+
+static void AppendNumber(double value, string &out) {
+  char buffer[DOUBLE_BUFFER_SIZE];
+  out.append(buffer, FormatDouble(value, buffer));
+}
+
+static void AppendArray(const vector<double> &values, string &out) {
+  out += '[';
+  for (unsigned int i = 0; i < values.size(); ++i) {
+    if (i > 0) {
+      out += ',';
+    }
+    AppendNumber(values[i], out);
+  }
+  out += ']';
+}
+
+static void AppendKey(const char *key, string &out) {
+  out += ",\"";
+  out += key;
+  out += "\":";
+}
+
+static void AppendField(const char *key, double value, string &out) {
+  AppendKey(key, out);
+  AppendNumber(value, out);
+}
+
+static void AppendField(const char *key, unsigned long value, string &out) {
+  AppendKey(key, out);
+  out += to_string(value);
+}
+
+static void AppendField(const char *key, bool value, string &out) {
+  AppendKey(key, out);
+  out += value ? "true" : "false";
+}
+
+static void AppendField(const char *key, const vector<double> &values, string &out) {
+  AppendKey(key, out);
+  AppendArray(values, out);
+}
+
+static void AppendState(const vector<OptimizerValue> &state, string &out) {
+  AppendKey("state", out);
+  out += '{';
+  for (unsigned int i = 0; i < state.size(); ++i) {
+    if (i > 0) {
+      out += ',';
+    }
+    AppendString(state[i].name, out);
+    out += ':';
+    if (state[i].text.empty()) {
+      AppendArray(state[i].values, out);
+    } else {
+      AppendString(state[i].text, out);
+    }
+  }
+  out += '}';
+}
+
+void FormatEventJson(const TunerEvent &event, string &out) {
+  out += "{\"type\":\"";
+  out += EventTypeName(event.type);
+  out += '"';
+  AppendKey("timestamp", out);
+  out += to_string(event.timestamp);
+  AppendField("cycle", static_cast<unsigned long>(event.cycle), out);
+  AppendField("params", event.params, out);
+
+  switch (event.type) {
+    case TunerEventType::START:
+      AppendField("best_params", event.best_params, out);
+      AppendField("best_err", event.best_err, out);
+      AppendState(event.state, out);
+      break;
+    case TunerEventType::WARMUP:
+      AppendField("steps", static_cast<unsigned long>(event.steps), out);
+      break;
+    case TunerEventType::CYCLE_END:
+      AppendField("err", event.err, out);
+      AppendField("best_err", event.best_err, out);
+      AppendField("steps", static_cast<unsigned long>(event.steps), out);
+      AppendField("cycle_steps", static_cast<unsigned long>(event.cycle_steps), out);
+      AppendField("fidelity", event.fidelity, out);
+      AppendField("aborted", (event.flags & EVENT_ABORTED) != 0, out);
+      AppendField("off_track", (event.flags & EVENT_OFF_TRACK) != 0, out);
+      AppendField("repeat", (event.flags & EVENT_REPEAT) != 0, out);
+      AppendField("repeat_best", (event.flags & EVENT_REPEAT_BEST) != 0, out);
+      AppendField("reset", (event.flags & EVENT_RESET) != 0, out);
+      AppendField("repeats", static_cast<unsigned long>(event.repeats), out);
+      AppendField("steps_saved", event.steps_saved, out);
+      AppendField("aborted_cycles", static_cast<unsigned long>(event.aborted_cycles), out);
+      if (event.segments > 0) {
+        AppendField("segments", static_cast<unsigned long>(event.segments), out);
+        AppendField("position", event.position, out);
+        AppendField("reference", (event.flags & EVENT_REFERENCE) != 0, out);
+        AppendField("ratio", event.ratio, out);
+      }
+      AppendState(event.state, out);
+      break;
+    case TunerEventType::COMPARISON:
+      AppendKey("outcome", out);
+      AppendString(OutcomeName(event.outcome), out);
+      AppendField("log_ratio", event.log_ratio, out);
+      AppendField("candidate_cycles", static_cast<unsigned long>(event.candidate_cycles), out);
+      AppendField("best_cycles", static_cast<unsigned long>(event.best_cycles), out);
+      break;
+    case TunerEventType::REPORT:
+      AppendField("err", event.err, out);
+      AppendField("accepted", (event.flags & EVENT_ACCEPTED) != 0, out);
+      AppendField("best_params", event.best_params, out);
+      AppendField("best_err", event.best_err, out);
+      break;
+    case TunerEventType::CACHED:
+      AppendField("err", event.err, out);
+      break;
+    case TunerEventType::FINISHED:
+      AppendField("best_params", event.best_params, out);
+      AppendField("best_err", event.best_err, out);
+      AppendField("avg_warmup", event.avg_warmup, out);
+      AppendField("steps_saved", event.steps_saved, out);
+      AppendField("aborted_cycles", static_cast<unsigned long>(event.aborted_cycles), out);
+      AppendField("cached_cycles", static_cast<unsigned long>(event.cached_cycles), out);
+      break;
+  }
+
+  out += "}\n";
+}
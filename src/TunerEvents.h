@@ -0,0 +1,144 @@
+#ifndef TUNER_EVENTS_H
+#define TUNER_EVENTS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Optimizer.h"
+
+enum class TunerEventType {
+  // The tuning started or resumed (e.g. a simulator connected)
+  START,
+  // The warmup of a cycle completed
+  WARMUP,
+  // A candidate was evaluated (a cycle, or the segments of the reset-free tuning), before its error is reported
+  CYCLE_END,
+  // Outcome of the significance test of a candidate (see Tuner::SetRepeats)
+  COMPARISON,
+  // The error of the candidate was reported to the optimizer
+  REPORT,
+  // The error of the candidate was taken from the evaluation store
+  CACHED,
+  // The tuning completed
+  FINISHED
+};
+
+/*
+ * Flags of an event.
+ */
+enum TunerEventFlags {
+  // The cycle was ended early (see EarlyAbort)
+  EVENT_ABORTED = 1,
+  // The vehicle left the track, the error is the cross track error at that point
+  EVENT_OFF_TRACK = 2,
+  // The cycle evaluated the candidate again (significance test)
+  EVENT_REPEAT = 4,
+  // The cycle evaluated the best parameters again (significance test)
+  EVENT_REPEAT_BEST = 8,
+  // The segments of the reference lap (reset-free tuning)
+  EVENT_REFERENCE = 16,
+  // The candidate replaced the best parameters (REPORT)
+  EVENT_ACCEPTED = 32,
+  // The simulator is reset for the next cycle (CYCLE_END)
+  EVENT_RESET = 64
+};
+
+/*
+ * Outcome of the significance test of a candidate.
+ */
+enum class ComparisonOutcome {
+  // The candidate is not better than the best parameters
+  NONE,
+  // The improvement is significant
+  SIGNIFICANT,
+  // The repeated cycles are exhausted, the means are compared as they are
+  MEANS,
+  // Another cycle of the candidate or of the best parameters is needed
+  REPEAT_CANDIDATE,
+  REPEAT_BEST
+};
+
+/*
+ * Progress of the tuning. The fields that do not apply to the type of the event are left unset.
+ */
+struct TunerEvent {
+  TunerEventType type;
+  // Wall clock time in nanoseconds since the epoch
+  int64_t timestamp;
+  unsigned int cycle;
+  unsigned int flags;
+  // Candidate of the cycle
+  std::vector<double> params;
+  // Best parameters and error, after the report for REPORT
+  std::vector<double> best_params;
+  double best_err;
+  // Error of the cycle (CYCLE_END and CACHED)
+  double err;
+  // Steps of the cycle including the warmup (CYCLE_END), or of the warmup (WARMUP)
+  unsigned int steps;
+  // Steps of the cycle after the warmup and fidelity of the candidate (CYCLE_END)
+  unsigned int cycle_steps;
+  double fidelity;
+  // Totals of the early termination (CYCLE_END and FINISHED)
+  unsigned long steps_saved;
+  unsigned int aborted_cycles;
+  // Repeated cycles of the current comparison and their max (CYCLE_END)
+  unsigned int repeats;
+  unsigned int max_repeats;
+  // Outcome of the comparison, log of the ratio of the mean errors of the candidate and of the best parameters, and
+  // the cycles of each (COMPARISON)
+  ComparisonOutcome outcome;
+  double log_ratio;
+  unsigned int candidate_cycles;
+  unsigned int best_cycles;
+  // Scored segments, position of the last one (m) and ratio of their errors to those of the reference lap
+  // (CYCLE_END of the reset-free tuning)
+  unsigned int segments;
+  double position;
+  double ratio;
+  // Average warmup steps and cycles taken from the evaluation store (FINISHED)
+  double avg_warmup;
+  unsigned int cached_cycles;
+  // State of the optimizer (START and CYCLE_END)
+  std::vector<OptimizerValue> state;
+};
+
+/*
+ * Receiver of the tuner events.
+ */
+class TunerEventSink {
+ public:
+  virtual ~TunerEventSink() {}
+
+  /*
+   * Handles an event, called by the thread running the tuner. The event is only valid during the call.
+   */
+  virtual void Emit(const TunerEvent &event) = 0;
+};
+
+/*
+ * Prints the events to the console as they are emitted, for the offline tools.
+ */
+class ConsoleEventSink : public TunerEventSink {
+ public:
+  void Emit(const TunerEvent &event);
+
+ private:
+  // Reused for every event
+  std::string text;
+};
+
+const char *EventTypeName(TunerEventType type);
+
+/*
+ * Appends the human readable summary of an event (the console output of the tuner) to the given string.
+ */
+void FormatEventText(const TunerEvent &event, std::string &text);
+
+/*
+ * Appends an event to the given string as a JSON object on a single line (JSON lines), with the fields that apply
+ * to its type.
+ */
+void FormatEventJson(const TunerEvent &event, std::string &out);
+
+#endif /* TUNER_EVENTS_H */
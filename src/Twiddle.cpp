@@ -0,0 +1,144 @@
+#include "Twiddle.h"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+using namespace std;
+
+Twiddle::Twiddle(const vector<double> &params, double delta_tolerance) {
+  this->params = params;
+  this->best_params = params;
+  this->params_delta.resize(params.size());
+  for (unsigned int i = 0; i < params.size(); ++i) {
+    this->params_delta[i] = {params[i] * 0.1, true};
+  }
+  this->param_idx = 0;
+  this->pending = false;
+  this->next_id = 0;
+  this->best_err = numeric_limits<double>::max();
+  this->delta_tolerance = delta_tolerance;
+}
+
+Twiddle::~Twiddle() {}
+
+bool Twiddle::Propose(Candidate &candidate) {
+  if (pending) {
+    return false;
+  }
+  pending = true;
+  candidate.id = next_id++;
+  candidate.params = params;
+  candidate.fidelity = 1.0;
+  return true;
+}
+
+void Twiddle::Report(const Candidate &candidate, double error) {
+  if (!pending || candidate.id + 1 != next_id) {
+    return;
+  }
+
+  pending = false;
+
+  if (error < best_err) {
+    // Error improved
+    best_err = error;
+    best_params = params;
+    TuneUp();                                  // Tune up this parameter
+    params_delta[param_idx].increment = true;  // Reset increment status
+    NextParam();                               // Tune next param
+  } else if (params_delta[param_idx].increment) {
+    params_delta[param_idx].increment = false;  // Try decrementing
+  } else {
+    Increase();                                // Puts back to original value
+    TuneDown();                                // Tune down this parameter
+    params_delta[param_idx].increment = true;  // Try incrementing
+    NextParam();                               // Tune next param
+  }
+
+  if (params_delta[param_idx].increment) {
+    Increase();
+  } else {
+    Decrease();
+  }
+}
+
+bool Twiddle::Converged() {
+  double sum = accumulate(params_delta.begin(), params_delta.end(), 0.0,
+                          [](double sum, const ParamDelta &param) { return sum + param.value; });
+  return sum <= delta_tolerance;
+}
+
+vector<double> Twiddle::BestParams() { return best_params; }
+
+double Twiddle::BestError() { return best_err; }
+
+void Twiddle::Save(vector<double> &state) {
+  state.clear();
+  state.push_back(param_idx);
+  state.push_back(best_err);
+  state.insert(state.end(), params.begin(), params.end());
+  state.insert(state.end(), best_params.begin(), best_params.end());
+  for (const ParamDelta &delta : params_delta) {
+    state.push_back(delta.value);
+  }
+  for (const ParamDelta &delta : params_delta) {
+    state.push_back(delta.increment ? 1.0 : 0.0);
+  }
+}
+
+bool Twiddle::Restore(const vector<double> &state) {
+  size_t count = params.size();
+
+  if (state.size() != 2 + 4 * count || state[0] < 0 || state[0] >= count) {
+    return false;
+  }
+
+  const double *p = state.data();
+
+  param_idx = static_cast<unsigned int>(*p++);
+  best_err = *p++;
+  for (unsigned int i = 0; i < count; ++i) {
+    params[i] = *p++;
+  }
+  for (unsigned int i = 0; i < count; ++i) {
+    best_params[i] = *p++;
+  }
+  for (unsigned int i = 0; i < count; ++i) {
+    params_delta[i].value = *p++;
+  }
+  for (unsigned int i = 0; i < count; ++i) {
+    params_delta[i].increment = *p++ != 0.0;
+  }
+  pending = false;
+
+  return true;
+}
+
+void Twiddle::GetState(vector<OptimizerValue> &state) {
+  state.resize(2);
+  state[0].name = "Params delta";
+  state[0].values.clear();
+  for (const ParamDelta &delta : params_delta) {
+    state[0].values.push_back(delta.value);
+  }
+  state[0].text.clear();
+  state[1].name = "Current index";
+  state[1].values.assign(1, param_idx);
+  state[1].text.clear();
+}
+
+void Twiddle::NextParam() {
+  ++param_idx %= params.size();
+  while (params_delta[param_idx].value == 0) {
+    // Skip parameters that have a delta of zero
+    NextParam();
+  }
+}
+
+void Twiddle::TuneUp() { params_delta[param_idx].value *= 1.1; }
+
+void Twiddle::TuneDown() { params_delta[param_idx].value *= 0.9; }
+
+void Twiddle::Increase() { params[param_idx] += params_delta[param_idx].value; }
+
+void Twiddle::Decrease() { params[param_idx] -= 2 * params_delta[param_idx].value; }
@@ -0,0 +1,62 @@
+#ifndef TWIDDLE_H
+#define TWIDDLE_H
+
+#include <vector>
+#include "Optimizer.h"
+
+struct ParamDelta {
+  double value;
+  bool increment;
+};
+
+/*
+ * Twiddle (coordinate descent): each parameter in turn is increased and then decreased by its delta, the delta grows
+ * (x1.1) when the error improves and shrinks (x0.9) when it improves in neither direction. Converges when the sum
+ * of the deltas is below the tolerance. A single candidate is evaluated at a time.
+ */
+class Twiddle : public Optimizer {
+ public:
+  /*
+   * @param params The initial parameters, the initial deltas are 10% of the parameters
+   * @param delta_tolerance The sum of the deltas at convergence
+   */
+  Twiddle(const std::vector<double> &params, double delta_tolerance);
+
+  virtual ~Twiddle();
+
+  bool Propose(Candidate &candidate);
+
+  void Report(const Candidate &candidate, double error);
+
+  bool Converged();
+
+  std::vector<double> BestParams();
+
+  double BestError();
+
+  void Save(std::vector<double> &state);
+
+  bool Restore(const std::vector<double> &state);
+
+  void GetState(std::vector<OptimizerValue> &state);
+
+ private:
+  std::vector<double> params;
+  std::vector<double> best_params;
+  std::vector<ParamDelta> params_delta;
+
+  unsigned int param_idx;
+  bool pending;
+  unsigned int next_id;
+
+  double best_err;
+  double delta_tolerance;
+
+  void NextParam();
+  void TuneUp();
+  void TuneDown();
+  void Increase();
+  void Decrease();
+};
+
+#endif /* TWIDDLE_H */
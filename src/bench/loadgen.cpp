@@ -0,0 +1,358 @@
+#include <math.h>
+#include <uWS/uWS.h>
+#include <uv.h>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Format.h"
+#include "../Histogram.h"
+#include "../LogReader.h"
+#include "../Options.h"
+
+/*
+ * Load generator impersonating the Udacity simulator: opens the given number of websocket connections to a running
+ * pid server, sends telemetry frames (synthetic or replayed from a log) and measures the round trip latency until
+ * the reply (steer, reset or manual) is received.
+ *
+ * Usage: pid_loadgen [options]
+ *
+ * With a rate each connection sends frames on a fixed schedule (open loop) regardless of the replies, the latency is
+ * measured from the scheduled send time so that a stalled server is not hidden by the generator slowing down
+ * (coordinated omission). Without a rate each connection sends the next frame as soon as the reply is received
+ * (closed loop, as the simulator does).
+ *
+ * Options:
+ *   --url=<url>            Server url (default ws://127.0.0.1:4567)
+ *   --connections=<n>      Number of connections (default 8)
+ *   --threads=<n>          Number of client threads, each one with its own event loop (default 1)
+ *   --rate=<n>             Frames/s sent by each connection, 0 for closed loop (default 0)
+ *   --duration=<s>         Duration of the measurement in seconds (default 10)
+ *   --warmup=<s>           Time before the measurement starts, latencies are not recorded (default 1)
+ *   --replay=<log>         Sends the telemetry recorded in the given log (TSV or binary) instead of synthetic frames
+ *   --replay-limit=<n>     Max number of records loaded from the log (default 100000)
+ */
+
+// Number of synthetic frames, cycled by each connection
+#define SYNTHETIC_FRAMES 1000
+// Resolution of the send schedule in open loop mode
+#define TICK_MS 1
+// Time allowed for the replies to the frames in flight at the end of the measurement
+#define DRAIN_MS 1000
+
+struct LoadSettings {
+  std::string url;
+  unsigned int connections;
+  double rate;
+  double duration;
+  double warmup;
+};
+
+struct Connection {
+  uWS::WebSocket<uWS::CLIENT> ws;
+  // Scheduled send times of the frames waiting for a reply, the server replies in order
+  std::deque<int64_t> in_flight;
+  int64_t next_send;
+  size_t frame;
+};
+
+struct LoadStats {
+  unsigned long sent;
+  unsigned long received;
+  unsigned long measured;
+  unsigned long lost;
+  unsigned int errors;
+};
+
+// Per thread state of the generator
+struct Client {
+  LoadSettings settings;
+  const std::vector<std::string> *frames;
+  std::vector<std::unique_ptr<Connection>> connections;
+  Histogram latency;
+  LoadStats stats;
+  int64_t measure_start;
+  int64_t measure_end;
+  int64_t drain_end;
+  bool stopping;
+  uv_timer_t timer;
+};
+
+static int64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Formats a numeric value as a quoted string, as sent by the simulator
+static std::string quoted(double value) {
+  char buffer[DOUBLE_BUFFER_SIZE];
+  size_t length = FormatDouble(value, buffer);
+  return "\"" + std::string(buffer, length) + "\"";
+}
+
+static std::string telemetry_frame(double cte, double speed, double angle) {
+  return "42[\"telemetry\",{\"cte\":" + quoted(cte) + ",\"speed\":" + quoted(speed) +
+         ",\"steering_angle\":" + quoted(angle) + ",\"throttle\":\"0.3\",\"image\":\"\"}]";
+}
+
+static std::vector<std::string> synthetic_frames() {
+  std::vector<std::string> frames;
+  for (unsigned int i = 0; i < SYNTHETIC_FRAMES; ++i) {
+    double phase = 2.0 * M_PI * i / SYNTHETIC_FRAMES;
+    frames.push_back(telemetry_frame(1.5 * sin(phase * 3), 30.0 + 2.0 * cos(phase), 10.0 * cos(phase * 3)));
+  }
+  return frames;
+}
+
+static bool replay_frames(const std::string &file_name, unsigned long limit, std::vector<std::string> &frames) {
+  // Binary logs are recognized by their header, anything else is read as TSV
+  std::unique_ptr<LogStream> stream(new BinaryLogStream());
+  if (!stream->Open(file_name)) {
+    stream.reset(new TsvLogStream());
+    if (!stream->Open(file_name)) {
+      return false;
+    }
+  }
+  LogRecord record;
+  while (frames.size() < limit && stream->Next(record)) {
+    frames.push_back(telemetry_frame(record.cte, record.speed, record.angle));
+  }
+  return !stream->Failed() && !frames.empty();
+}
+
+static void send_frame(Client &client, Connection &connection, int64_t scheduled) {
+  const std::string &frame = (*client.frames)[connection.frame++ % client.frames->size()];
+  connection.in_flight.push_back(scheduled);
+  connection.ws.send(frame.data(), frame.size(), uWS::OpCode::TEXT);
+  ++client.stats.sent;
+}
+
+static void close_connections(Client &client) {
+  for (std::unique_ptr<Connection> &connection : client.connections) {
+    if (connection) {
+      connection->ws.close();
+    }
+  }
+}
+
+// Sends the frames that are due according to the schedule, and stops the generator at the end of the measurement
+static void on_tick(uv_timer_t *timer) {
+  Client &client = *static_cast<Client *>(timer->data);
+  int64_t time = now();
+
+  if (time >= client.measure_end) {
+    // Stops sending and waits for the replies to the frames in flight
+    client.stopping = true;
+    bool drained = true;
+    for (std::unique_ptr<Connection> &connection : client.connections) {
+      drained = drained && (!connection || connection->in_flight.empty());
+    }
+    if (drained || time >= client.drain_end) {
+      uv_timer_stop(timer);
+      uv_close(reinterpret_cast<uv_handle_t *>(timer), nullptr);
+      close_connections(client);
+    }
+    return;
+  }
+
+  if (client.settings.rate <= 0) {
+    return;
+  }
+
+  int64_t interval = static_cast<int64_t>(1e9 / client.settings.rate);
+
+  for (std::unique_ptr<Connection> &connection : client.connections) {
+    if (!connection) {
+      continue;
+    }
+    while (connection->next_send <= time) {
+      send_frame(client, *connection, connection->next_send);
+      connection->next_send += interval;
+    }
+  }
+}
+
+// Runs the given number of connections on an event loop, until the measurement is completed
+static void run_client(Client &client) {
+  uWS::Hub h;
+  const LoadSettings &settings = client.settings;
+
+  int64_t start = now();
+  client.measure_start = start + static_cast<int64_t>(settings.warmup * 1e9);
+  client.measure_end = client.measure_start + static_cast<int64_t>(settings.duration * 1e9);
+  client.drain_end = client.measure_end + static_cast<int64_t>(DRAIN_MS) * 1000000;
+  client.stopping = false;
+  client.stats = {0, 0, 0, 0, 0};
+
+  h.onConnection([&client](uWS::WebSocket<uWS::CLIENT> ws, uWS::HttpRequest req) {
+    Connection *connection = new Connection();
+    connection->ws = ws;
+    connection->next_send = now();
+    // Each connection starts from a different frame
+    connection->frame = client.connections.size() * 97;
+    client.connections.push_back(std::unique_ptr<Connection>(connection));
+    ws.setData(connection);
+    if (client.settings.rate <= 0) {
+      send_frame(client, *connection, now());
+    }
+  });
+
+  h.onMessage([&client](uWS::WebSocket<uWS::CLIENT> ws, char *data, size_t length, uWS::OpCode opCode) {
+    Connection *connection = static_cast<Connection *>(ws.getData());
+    if (connection == nullptr || connection->in_flight.empty()) {
+      return;
+    }
+    int64_t time = now();
+    int64_t scheduled = connection->in_flight.front();
+    connection->in_flight.pop_front();
+    ++client.stats.received;
+    if (scheduled >= client.measure_start && scheduled < client.measure_end) {
+      client.latency.Record(time - scheduled);
+      ++client.stats.measured;
+    }
+    if (client.settings.rate <= 0 && !client.stopping) {
+      send_frame(client, *connection, time);
+    }
+  });
+
+  h.onDisconnection([&client](uWS::WebSocket<uWS::CLIENT> ws, int code, char *message, size_t length) {
+    Connection *connection = static_cast<Connection *>(ws.getData());
+    if (connection == nullptr) {
+      return;
+    }
+    ws.setData(nullptr);
+    client.stats.lost += connection->in_flight.size();
+    for (std::unique_ptr<Connection> &owned : client.connections) {
+      if (owned.get() == connection) {
+        owned.reset();
+      }
+    }
+  });
+
+  h.onError([&client](void *user) { ++client.stats.errors; });
+
+  uv_timer_init(h.getLoop(), &client.timer);
+  client.timer.data = &client;
+  uv_timer_start(&client.timer, on_tick, TICK_MS, TICK_MS);
+
+  for (unsigned int i = 0; i < settings.connections; ++i) {
+    h.connect(settings.url, nullptr);
+  }
+
+  h.run();
+}
+
+static void print_latency(const char *label, uint64_t ns) {
+  std::cout << std::setw(16) << label << std::fixed << std::setprecision(1) << ns / 1000.0 << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  LoadSettings settings = {"ws://127.0.0.1:4567", 8, 0.0, 10.0, 1.0};
+  unsigned int threads = 1;
+  std::string replay_file;
+  unsigned long replay_limit = 100000;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    std::string value;
+    bool valid = true;
+    if (ReadOption(arg, "url", value)) {
+      settings.url = value;
+    } else if (ReadOption(arg, "connections", value)) {
+      valid = ParseValue(value, settings.connections) && settings.connections > 0;
+    } else if (ReadOption(arg, "threads", value)) {
+      valid = ParseValue(value, threads) && threads > 0;
+    } else if (ReadOption(arg, "rate", value)) {
+      valid = ParseValue(value, settings.rate) && settings.rate >= 0;
+    } else if (ReadOption(arg, "duration", value)) {
+      valid = ParseValue(value, settings.duration) && settings.duration > 0;
+    } else if (ReadOption(arg, "warmup", value)) {
+      valid = ParseValue(value, settings.warmup) && settings.warmup >= 0;
+    } else if (ReadOption(arg, "replay", value)) {
+      replay_file = value;
+    } else if (ReadOption(arg, "replay-limit", value)) {
+      valid = ParseValue(value, replay_limit) && replay_limit > 0;
+    } else {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (!valid) {
+      std::cerr << "Invalid value for option: " << arg << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::vector<std::string> frames;
+
+  if (replay_file.empty()) {
+    frames = synthetic_frames();
+  } else if (!replay_frames(replay_file, replay_limit, frames)) {
+    std::cerr << "Could not read log " << replay_file << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::unique_ptr<Client>> clients;
+  std::vector<std::thread> client_threads;
+
+  for (unsigned int i = 0; i < threads; ++i) {
+    std::unique_ptr<Client> client(new Client());
+    client->settings = settings;
+    client->frames = &frames;
+    // Distributes the connections among the threads
+    client->settings.connections = settings.connections / threads + (i < settings.connections % threads ? 1 : 0);
+    if (client->settings.connections == 0) {
+      continue;
+    }
+    clients.push_back(std::move(client));
+  }
+
+  for (std::unique_ptr<Client> &client : clients) {
+    Client *c = client.get();
+    client_threads.push_back(std::thread([c]() { run_client(*c); }));
+  }
+
+  for (std::thread &client_thread : client_threads) {
+    client_thread.join();
+  }
+
+  Histogram latency;
+  LoadStats stats = {0, 0, 0, 0, 0};
+
+  for (std::unique_ptr<Client> &client : clients) {
+    latency.Merge(client->latency);
+    stats.sent += client->stats.sent;
+    stats.received += client->stats.received;
+    stats.measured += client->stats.measured;
+    stats.lost += client->stats.lost;
+    stats.errors += client->stats.errors;
+  }
+
+  if (stats.errors > 0) {
+    std::cerr << stats.errors << " connections failed" << std::endl;
+  }
+
+  std::cout << std::setw(16) << "Connections: " << settings.connections << std::endl;
+  std::cout << std::setw(16) << "Mode: "
+            << (settings.rate > 0 ? "open loop, " + std::to_string(settings.rate) + " frames/s per connection"
+                                  : std::string("closed loop"))
+            << std::endl;
+  std::cout << std::setw(16) << "Frames sent: " << stats.sent << std::endl;
+  std::cout << std::setw(16) << "Replies: " << stats.received << std::endl;
+  std::cout << std::setw(16) << "Lost: " << stats.lost << std::endl;
+  std::cout << std::setw(16) << "Frames/s: " << std::fixed << std::setprecision(0)
+            << stats.measured / settings.duration << std::endl;
+  std::cout << "Latency (us):" << std::endl;
+  print_latency("min: ", latency.Min());
+  print_latency("mean: ", static_cast<uint64_t>(latency.Mean()));
+  print_latency("p50: ", latency.Percentile(50.0));
+  print_latency("p99: ", latency.Percentile(99.0));
+  print_latency("p99.9: ", latency.Percentile(99.9));
+  print_latency("max: ", latency.Max());
+
+  return stats.errors > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,194 @@
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../Evaluation.h"
+#include "../Optimizer.h"
+#include "../Options.h"
+#include "../Tuner.h"
+
+/*
+ * Compares the optimizers of the Tuner on the headless simulator by the number of evaluations (tuning cycles, each
+ * one a simulator lap with the Udacity simulator) and of simulator steps (warmup included, the cycles of the
+ * multi-fidelity optimizers are shorter) needed to reach a target error. Each optimizer is run from the same set of
+ * starting coefficients: the initial coefficients and random variations of them (each coefficient scaled by a factor
+ * between 1/2 and 2).
+ *
+ * Usage: pid_optimizer_bench [Kp Ki Kd] [options]
+ *
+ * Options:
+ *   --target=<x>           Target cycle error (default 0.002)
+ *   --starts=<n>           Number of starting points (default 8)
+ *   --max-evaluations=<n>  Max evaluations of each run (default 300)
+ *   --max-steps=<n>        Steps of a cycle after the warmup (default 1500)
+ *   --optimizers=<list>    Comma separated optimizers to compare (default all)
+ *   --seed=<n>             Seed of the starting points (default 1)
+ */
+
+struct RunResult {
+  // Evaluations and steps needed to reach the target, 0 if not reached
+  unsigned int to_target;
+  unsigned long steps_to_target;
+  unsigned int evaluations;
+  unsigned long steps;
+  double best_err;
+};
+
+static RunResult run(OptimizerType type, const std::vector<double> &start, const Track &track,
+                     const SimulatorSettings &settings, unsigned int max_steps, unsigned int max_evaluations,
+                     double target) {
+  std::unique_ptr<Optimizer> optimizer = CreateOptimizer(type, start);
+  RunResult result = {0, 0, 0, 0, 0.0};
+  Candidate candidate;
+
+  while (result.evaluations < max_evaluations && !optimizer->Converged() && optimizer->Propose(candidate)) {
+    unsigned int steps = 0;
+    double error = EvaluateCycle(track, settings, candidate.params, FidelitySteps(max_steps, candidate.fidelity),
+                                 TUNER_WARMUP_STEPS, &steps);
+    optimizer->Report(candidate, error);
+    ++result.evaluations;
+    result.steps += steps;
+    if (result.to_target == 0 && optimizer->BestError() <= target) {
+      result.to_target = result.evaluations;
+      result.steps_to_target = result.steps;
+    }
+  }
+
+  result.best_err = optimizer->BestError();
+
+  return result;
+}
+
+int main(int argc, char *argv[]) {
+  std::vector<double> params = {0.2, 0.0001, 3.0};
+  double target = 0.002;
+  unsigned int starts = 8;
+  unsigned int max_evaluations = 300;
+  unsigned int max_steps = 1500;
+  unsigned int seed = 1;
+  std::vector<OptimizerType> types = {OptimizerType::TWIDDLE, OptimizerType::NELDER_MEAD,
+                                      OptimizerType::CMA_ES, OptimizerType::BAYES_OPT,
+                                      OptimizerType::HALVING};
+  std::vector<std::string> args;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    std::string value;
+    bool valid = true;
+    if (arg.compare(0, 2, "--") != 0) {
+      args.push_back(arg);
+    } else if (ReadOption(arg, "target", value)) {
+      valid = ParseValue(value, target) && target > 0;
+    } else if (ReadOption(arg, "starts", value)) {
+      valid = ParseValue(value, starts) && starts > 0;
+    } else if (ReadOption(arg, "max-evaluations", value)) {
+      valid = ParseValue(value, max_evaluations);
+    } else if (ReadOption(arg, "max-steps", value)) {
+      valid = ParseValue(value, max_steps) && max_steps > 0;
+    } else if (ReadOption(arg, "seed", value)) {
+      valid = ParseValue(value, seed);
+    } else if (ReadOption(arg, "optimizers", value)) {
+      types.clear();
+      size_t pos = 0;
+      while (valid && pos <= value.size()) {
+        size_t next = std::min(value.find(',', pos), value.size());
+        OptimizerType type;
+        valid = ParseOptimizerType(value.substr(pos, next - pos), type);
+        types.push_back(type);
+        pos = next + 1;
+      }
+    } else {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (!valid) {
+      std::cerr << "Invalid value for option: " << arg << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (args.size() > 0 && (args.size() != 3 || !ParseValue(args[0], params[0]) || !ParseValue(args[1], params[1]) ||
+                          !ParseValue(args[2], params[2]))) {
+    std::cerr << "Usage: " << argv[0] << " [Kp Ki Kd] [options]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  Track track = Track::Default();
+  SimulatorSettings settings;
+
+  std::mt19937 random(seed);
+  std::uniform_real_distribution<double> scale(-log(2.0), log(2.0));
+  std::vector<std::vector<double>> start_points = {params};
+
+  while (start_points.size() < starts) {
+    std::vector<double> start = params;
+    for (double &param : start) {
+      param *= exp(scale(random));
+    }
+    start_points.push_back(start);
+  }
+
+  std::cout << "Target error " << target << ", " << starts << " starting points, " << max_steps
+            << " steps per cycle, max " << max_evaluations << " evaluations" << std::endl
+            << std::endl;
+
+  std::cout << std::setw(14) << std::left << "Optimizer" << std::right << std::setw(10) << "Reached" << std::setw(14)
+            << "Median evals" << std::setw(12) << "Mean evals" << std::setw(14) << "Median steps" << std::setw(12)
+            << "Total evals" << std::setw(14) << "Total steps" << std::setw(14) << "Median best" << std::setw(12)
+            << "Time (s)" << std::endl;
+
+  for (OptimizerType type : types) {
+    std::vector<unsigned int> to_target;
+    std::vector<unsigned long> steps_to_target;
+    std::vector<double> best_errors;
+    unsigned long evaluations = 0;
+    unsigned long steps = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (const std::vector<double> &start_point : start_points) {
+      RunResult result = run(type, start_point, track, settings, max_steps, max_evaluations, target);
+      if (result.to_target > 0) {
+        to_target.push_back(result.to_target);
+        steps_to_target.push_back(result.steps_to_target);
+      }
+      best_errors.push_back(result.best_err);
+      evaluations += result.evaluations;
+      steps += result.steps;
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::sort(to_target.begin(), to_target.end());
+    std::sort(steps_to_target.begin(), steps_to_target.end());
+    std::sort(best_errors.begin(), best_errors.end());
+
+    double mean = 0.0;
+    for (unsigned int count : to_target) {
+      mean += static_cast<double>(count) / to_target.size();
+    }
+
+    std::ostringstream reached;
+    reached << to_target.size() << "/" << start_points.size();
+
+    std::cout << std::setw(14) << std::left << OptimizerName(type) << std::right << std::setw(10) << reached.str();
+    if (to_target.empty()) {
+      std::cout << std::setw(14) << "-" << std::setw(12) << "-" << std::setw(14) << "-";
+    } else {
+      std::cout << std::setw(14) << to_target[to_target.size() / 2] << std::setw(12) << std::fixed
+                << std::setprecision(1) << mean << std::setw(14) << steps_to_target[steps_to_target.size() / 2];
+    }
+    std::cout << std::setw(12) << evaluations << std::setw(14) << steps << std::setw(14) << std::defaultfloat << std::setprecision(4)
+              << best_errors[best_errors.size() / 2] << std::setw(12) << std::fixed << std::setprecision(2) << elapsed
+              << std::defaultfloat << std::endl;
+  }
+
+  return EXIT_SUCCESS;
+}
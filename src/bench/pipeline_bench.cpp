@@ -0,0 +1,192 @@
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../ControlPipeline.h"
+#include "../Histogram.h"
+#include "../Options.h"
+#include "../Protocol.h"
+#include "../Session.h"
+
+/*
+ * Measures the round trip of a telemetry frame through the frame handling of the pid server, inline (the I/O thread
+ * runs the controller, the default) or pipelined (the controller runs on the control thread, see --pipeline), without
+ * the websocket layer: a client thread writes a timestamp to a pipe, the I/O thread decodes a telemetry frame, runs
+ * the controller of a session (directly or through a ControlPipeline), encodes the reply and writes it back to a
+ * second pipe. In the pipelined mode the control thread wakes up the I/O thread through an eventfd, standing in for
+ * the uv async handle of the server. The frames are sent one at a time (closed loop) with a pause between them.
+ *
+ * Usage: pid_pipeline_bench [options]
+ *
+ * Options:
+ *   --pipeline             Runs the controller on a control thread
+ *   --frames=<n>           Number of frames (default 20000), the first 5% are not recorded
+ *   --pace=<us>            Pause between two frames (default 1000, i.e. 1000 frames/s)
+ *   --max-steps=<n>        Steps of a tuning cycle, 0 disables the tuner (default 0)
+ */
+
+static const char TELEMETRY_FRAME[] =
+    "42[\"telemetry\",{\"cte\":\"0.7598\",\"speed\":\"30.1250\",\"steering_angle\":\"0.0000\",\"throttle\":\"0.3000\","
+    "\"image\":\"\"}]";
+
+static int64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Writes exactly one value to a pipe or eventfd, aborts on failure (the benchmark has no recovery)
+template <typename T>
+static void writeValue(int fd, T value) {
+  if (write(fd, &value, sizeof(T)) != sizeof(T)) {
+    abort();
+  }
+}
+
+template <typename T>
+static T readValue(int fd) {
+  T value;
+  if (read(fd, &value, sizeof(T)) != sizeof(T)) {
+    abort();
+  }
+  return value;
+}
+
+int main(int argc, char *argv[]) {
+  bool pipelined = false;
+  unsigned int frames = 20000;
+  unsigned int pace = 1000;
+  unsigned int max_steps = 0;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    std::string value;
+    bool valid = true;
+    if (arg == "--pipeline") {
+      pipelined = true;
+    } else if (ReadOption(arg, "frames", value)) {
+      valid = ParseValue(value, frames) && frames > 0;
+    } else if (ReadOption(arg, "pace", value)) {
+      valid = ParseValue(value, pace);
+    } else if (ReadOption(arg, "max-steps", value)) {
+      valid = ParseValue(value, max_steps);
+    } else {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (!valid) {
+      std::cerr << "Invalid value for option: " << arg << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  SessionSettings settings;
+  settings.params = {0.2, 0.0001, 3.0};
+  settings.max_steps = max_steps;
+  settings.profile_period = 8;
+  settings.early_abort = EarlyAbort::OFF;
+  settings.max_repeats = 0;
+  settings.repeat_alpha = 0.05;
+  settings.resume = false;
+  settings.optimizer = OptimizerType::TWIDDLE;
+  settings.events = false;
+  settings.status_interval = 0;
+
+  SessionPool pool(0, 1, settings);
+  Session *session = pool.Acquire();
+
+  int requests[2];
+  int replies[2];
+  int wakeup = eventfd(0, EFD_NONBLOCK);
+
+  if (pipe(requests) != 0 || pipe(replies) != 0 || wakeup < 0) {
+    std::cerr << "Could not create the pipes: " << strerror(errno) << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  ControlPipeline control(256);
+
+  if (pipelined) {
+    control.Start([wakeup] { writeValue<uint64_t>(wakeup, 1); });
+  }
+
+  std::thread io([&] {
+    SteerEncoder steer_encoder;
+    pollfd fds[2] = {{requests[0], POLLIN, 0}, {wakeup, POLLIN, 0}};
+    char reply[256];
+    unsigned int handled = 0;
+
+    while (handled < frames) {
+      poll(fds, 2, -1);
+      if (fds[0].revents & POLLIN) {
+        int64_t sent = readValue<int64_t>(requests[0]);
+        Telemetry telemetry;
+        DecodeFrame(TELEMETRY_FRAME, sizeof(TELEMETRY_FRAME) - 1, telemetry);
+        telemetry.cte = sin(handled * 0.01);
+        if (pipelined) {
+          control.Submit({session, session->Id(), telemetry, std::chrono::steady_clock::now()});
+        } else {
+          Actuation actuation;
+          double dt = session->FrameInterval(std::chrono::steady_clock::now());
+          bool running = session->Control(telemetry, dt, actuation);
+          Frame msg = running ? steer_encoder.Encode(actuation.steer_value, actuation.throttle) : RESET_FRAME;
+          memcpy(reply, msg.data, msg.length);
+          writeValue(replies[1], sent);
+          if (!running) {
+            session->CompleteCycle();
+          }
+          ++handled;
+        }
+      }
+      if (fds[1].revents & POLLIN) {
+        readValue<uint64_t>(wakeup);
+        ControlReply control_reply;
+        while (control.Poll(control_reply)) {
+          Frame msg = control_reply.reset ? RESET_FRAME
+                                          : steer_encoder.Encode(control_reply.actuation.steer_value,
+                                                                 control_reply.actuation.throttle);
+          memcpy(reply, msg.data, msg.length);
+          // One frame in flight, the client keeps its own send time
+          writeValue<int64_t>(replies[1], 0);
+          ++handled;
+        }
+      }
+    }
+  });
+
+  Histogram latency;
+
+  for (unsigned int i = 0; i < frames; ++i) {
+    int64_t sent = now();
+    writeValue(requests[1], sent);
+    readValue<int64_t>(replies[0]);
+    if (i >= frames / 20) {
+      latency.Record(now() - sent);
+    }
+    if (pace > 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(pace));
+    }
+  }
+
+  io.join();
+  control.Stop();
+  pool.Release(session);
+
+  std::cout << (pipelined ? "Pipelined" : "Inline") << ": " << latency.Count() << " frames, p50 "
+            << latency.Percentile(50) / 1000.0 << " us, p99 " << latency.Percentile(99) / 1000.0 << " us, p99.9 "
+            << latency.Percentile(99.9) / 1000.0 << " us, max " << latency.Max() / 1000.0 << " us, mean "
+            << latency.Mean() / 1000.0 << " us";
+  if (pipelined) {
+    std::cout << " (" << control.Wakeups() << " control thread wakeups)";
+  }
+  std::cout << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,156 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include "../Protocol.h"
+#include "../json.hpp"
+
+/*
+ * Micro benchmark for the websocket protocol hot path: compares the allocation-free decoder and encoder with the
+ * generic JSON path, reporting the average time (ns) and the number of heap allocations per frame.
+ */
+
+using json = nlohmann::json;
+
+static unsigned long allocations = 0;
+
+void *operator new(size_t size) {
+  ++allocations;
+  void *p = malloc(size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+struct BenchResult {
+  double ns_per_frame;
+  double allocations_per_frame;
+  double checksum;
+};
+
+template <typename Fn>
+BenchResult run(const std::vector<std::string> &frames, unsigned int iterations, Fn fn) {
+  double checksum = 0.0;
+  unsigned long start_allocations = allocations;
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int i = 0; i < iterations; ++i) {
+    const std::string &frame = frames[i % frames.size()];
+    checksum += fn(frame.data(), frame.length());
+  }
+  auto end = std::chrono::steady_clock::now();
+  double elapsed = std::chrono::duration<double, std::nano>(end - start).count();
+  return {elapsed / iterations, static_cast<double>(allocations - start_allocations) / iterations, checksum};
+}
+
+static void print_result(const std::string &name, const BenchResult &result) {
+  std::cout << std::setw(24) << std::left << name << std::right << std::setw(12) << std::fixed << std::setprecision(1)
+            << result.ns_per_frame << " ns/frame" << std::setw(10) << std::setprecision(2)
+            << result.allocations_per_frame << " allocs/frame" << std::endl;
+}
+
+static std::vector<std::string> telemetry_frames() {
+  std::vector<std::string> frames;
+  const char *ctes[] = {"0.7598", "-0.3512", "1.2045", "0.0000", "-2.1188", "0.0452"};
+  const char *speeds[] = {"0.4380", "12.1250", "30.5501", "31.0021"};
+  const char *angles[] = {"0.0000", "-3.5213", "5.0012", "-0.1254", "2.4581"};
+  for (unsigned int i = 0; i < 60; ++i) {
+    frames.push_back(std::string("42[\"telemetry\",{\"cte\":\"") + ctes[i % 6] + "\",\"speed\":\"" + speeds[i % 4] +
+                     "\",\"steering_angle\":\"" + angles[i % 5] + "\",\"throttle\":\"0.3000\",\"image\":\"\"}]");
+  }
+  return frames;
+}
+
+// Steering values stored as raw bytes, so that the same driver can be used for the encoding benchmark
+static std::vector<std::string> steer_values() {
+  std::vector<std::string> values;
+  double steer_value = -1.0;
+  for (unsigned int i = 0; i < 64; ++i) {
+    steer_value += 0.0312417 * (i % 7);
+    if (steer_value > 1.0) {
+      steer_value -= 2.0;
+    }
+    values.push_back(std::string(reinterpret_cast<const char *>(&steer_value), sizeof(steer_value)));
+  }
+  return values;
+}
+
+int main(int argc, char *argv[]) {
+  unsigned int iterations = 1000000;
+
+  if (argc > 1) {
+    iterations = static_cast<unsigned int>(std::strtoul(argv[1], nullptr, 10));
+  }
+
+  if (iterations == 0) {
+    std::cerr << "Invalid number of iterations" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::string> frames = telemetry_frames();
+
+  std::cout << "Telemetry decoding (" << iterations << " frames)" << std::endl;
+
+  BenchResult json_result = run(frames, iterations, [](const char *data, size_t length) {
+    Telemetry telemetry;
+    DecodeFrameJson(data, length, telemetry);
+    return telemetry.cte;
+  });
+
+  BenchResult fast_result = run(frames, iterations, [](const char *data, size_t length) {
+    Telemetry telemetry;
+    DecodeFrame(data, length, telemetry);
+    return telemetry.cte;
+  });
+
+  print_result("json::parse", json_result);
+  print_result("DecodeFrame", fast_result);
+
+  if (json_result.checksum != fast_result.checksum) {
+    std::cerr << "Decoded values mismatch: " << json_result.checksum << " != " << fast_result.checksum << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Speedup: " << std::setprecision(1) << json_result.ns_per_frame / fast_result.ns_per_frame << "x"
+            << std::endl;
+
+  std::vector<std::string> values = steer_values();
+
+  std::cout << std::endl << "Steer encoding (" << iterations << " frames)" << std::endl;
+
+  BenchResult dump_result = run(values, iterations, [](const char *data, size_t length) {
+    double steer_value;
+    memcpy(&steer_value, data, sizeof(steer_value));
+    json msgJson;
+    msgJson["steering_angle"] = steer_value;
+    msgJson["throttle"] = (1 - fabs(steer_value)) * 0.4 + 0.1;
+    auto msg = "42[\"steer\"," + msgJson.dump() + "]";
+    return static_cast<double>(msg.length());
+  });
+
+  SteerEncoder encoder;
+
+  BenchResult encoder_result = run(values, iterations, [&encoder](const char *data, size_t length) {
+    double steer_value;
+    memcpy(&steer_value, data, sizeof(steer_value));
+    Frame msg = encoder.Encode(steer_value, (1 - fabs(steer_value)) * 0.4 + 0.1);
+    return static_cast<double>(msg.length);
+  });
+
+  print_result("json::dump", dump_result);
+  print_result("SteerEncoder", encoder_result);
+
+  std::cout << "Speedup: " << std::setprecision(1) << dump_result.ns_per_frame / encoder_result.ns_per_frame << "x"
+            << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,29 @@
+#!/bin/bash
+# Measures the frames/s processed by the pid server for an increasing number of event loop threads.
+#
+# Usage: ./throughput.sh [max_threads] [connections] [duration]
+#
+# To be run from the build directory (requires the pid and pid_throughput executables), the server runs in a
+# temporary directory so that the telemetry logs of the benchmark are discarded.
+
+MAX_THREADS=${1:-$(nproc)}
+CONNECTIONS=${2:-64}
+DURATION=${3:-10}
+
+BUILD_DIR=$(pwd)
+WORK_DIR=$(mktemp -d)
+
+THREADS=1
+
+while [ $THREADS -le $MAX_THREADS ]; do
+  (cd $WORK_DIR && exec $BUILD_DIR/pid --threads=$THREADS --pin-cpus --max-sessions=$CONNECTIONS > /dev/null) &
+  SERVER=$!
+  sleep 1
+  RESULT=$(./pid_throughput --connections=$CONNECTIONS --threads=$THREADS --duration=$DURATION | grep "Frames/s")
+  echo "Server threads: $THREADS $RESULT"
+  kill $SERVER
+  wait $SERVER 2> /dev/null
+  THREADS=$((THREADS * 2))
+done
+
+rm -rf $WORK_DIR
@@ -0,0 +1,144 @@
+#include <uWS/uWS.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Options.h"
+
+/*
+ * Throughput benchmark for a running pid server: opens the given number of websocket connections, each one sends a
+ * telemetry frame as soon as the reply to the previous one is received (closed loop), and reports the number of
+ * frames per second processed by the server.
+ *
+ * Usage: pid_throughput [options]
+ *
+ * Options:
+ *   --url=<url>            Server url (default ws://127.0.0.1:4567)
+ *   --connections=<n>      Number of connections (default 8)
+ *   --threads=<n>          Number of client threads, each one with its own event loop (default 1)
+ *   --duration=<s>         Duration of the benchmark in seconds (default 10)
+ */
+
+static const char *TELEMETRY_FRAMES[] = {
+    "42[\"telemetry\",{\"cte\":\"0.7598\",\"speed\":\"30.1250\",\"steering_angle\":\"0.0000\",\"throttle\":\"0.3000\","
+    "\"image\":\"\"}]",
+    "42[\"telemetry\",{\"cte\":\"-0.3512\",\"speed\":\"30.5501\",\"steering_angle\":\"-3.5213\",\"throttle\":\"0.3000\","
+    "\"image\":\"\"}]",
+    "42[\"telemetry\",{\"cte\":\"1.2045\",\"speed\":\"31.0021\",\"steering_angle\":\"5.0012\",\"throttle\":\"0.3000\","
+    "\"image\":\"\"}]"};
+
+struct ClientSettings {
+  std::string url;
+  unsigned int connections;
+  double duration;
+};
+
+static void send_frame(uWS::WebSocket<uWS::CLIENT> &ws, unsigned long frame) {
+  const char *data = TELEMETRY_FRAMES[frame % 3];
+  ws.send(data, strlen(data), uWS::OpCode::TEXT);
+}
+
+// Runs the given number of connections on an event loop, until the duration elapses
+static void run_client(const ClientSettings &settings, std::atomic<unsigned long> &frames,
+                       std::atomic<unsigned int> &errors) {
+  uWS::Hub h;
+
+  unsigned long count = 0;
+  unsigned int open = 0;
+  auto start = std::chrono::steady_clock::now();
+  auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                         std::chrono::duration<double>(settings.duration));
+
+  h.onConnection([&open, &count](uWS::WebSocket<uWS::CLIENT> ws, uWS::HttpRequest req) {
+    ++open;
+    send_frame(ws, count);
+  });
+
+  h.onMessage([&count, &end](uWS::WebSocket<uWS::CLIENT> ws, char *data, size_t length, uWS::OpCode opCode) {
+    ++count;
+    if (std::chrono::steady_clock::now() >= end) {
+      ws.close();
+      return;
+    }
+    send_frame(ws, count);
+  });
+
+  h.onDisconnection([&open](uWS::WebSocket<uWS::CLIENT> ws, int code, char *message, size_t length) { --open; });
+
+  h.onError([&errors](void *user) { ++errors; });
+
+  for (unsigned int i = 0; i < settings.connections; ++i) {
+    h.connect(settings.url, nullptr);
+  }
+
+  h.run();
+
+  frames += count;
+}
+
+int main(int argc, char *argv[]) {
+  ClientSettings settings = {"ws://127.0.0.1:4567", 8, 10.0};
+  unsigned int threads = 1;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    std::string value;
+    bool valid = true;
+    if (ReadOption(arg, "url", value)) {
+      settings.url = value;
+    } else if (ReadOption(arg, "connections", value)) {
+      valid = ParseValue(value, settings.connections) && settings.connections > 0;
+    } else if (ReadOption(arg, "threads", value)) {
+      valid = ParseValue(value, threads) && threads > 0;
+    } else if (ReadOption(arg, "duration", value)) {
+      valid = ParseValue(value, settings.duration) && settings.duration > 0;
+    } else {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (!valid) {
+      std::cerr << "Invalid value for option: " << arg << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::atomic<unsigned long> frames(0);
+  std::atomic<unsigned int> errors(0);
+  std::vector<std::thread> clients;
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (unsigned int i = 0; i < threads; ++i) {
+    ClientSettings client_settings = settings;
+    // Distributes the connections among the threads
+    client_settings.connections = settings.connections / threads + (i < settings.connections % threads ? 1 : 0);
+    if (client_settings.connections == 0) {
+      continue;
+    }
+    clients.push_back(std::thread([client_settings, &frames, &errors]() {
+      run_client(client_settings, frames, errors);
+    }));
+  }
+
+  for (std::thread &client : clients) {
+    client.join();
+  }
+
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  if (errors > 0) {
+    std::cerr << errors << " connections failed" << std::endl;
+  }
+
+  std::cout << std::setw(16) << "Connections: " << settings.connections << std::endl;
+  std::cout << std::setw(16) << "Frames: " << frames << std::endl;
+  std::cout << std::setw(16) << "Elapsed (s): " << elapsed << std::endl;
+  std::cout << std::setw(16) << "Frames/s: " << std::fixed << std::setprecision(0) << frames / elapsed << std::endl;
+
+  return errors > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -1,149 +1,224 @@
 #include <math.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
 #include <uWS/uWS.h>
-#include <fstream>
+#include <uv.h>
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
 #include <vector>
-#include "PID.h"
-#include "Tuner.h"
-#include "json.hpp"
-
-// for convenience
-using json = nlohmann::json;
+#include "Checkpoint.h"
+#include "ControlPipeline.h"
+#include "Metrics.h"
+#include "Options.h"
+#include "Protocol.h"
+#include "Session.h"
+#include "StatusReporter.h"
 
 // For converting back and forth between radians and degrees.
 constexpr double pi() { return M_PI; }
 double deg2rad(double x) { return x * pi() / 180; }
 double rad2deg(double x) { return x * 180 / pi(); }
-double clamp_steering(double n) { return n < -1 ? -1 : (n > 1 ? 1 : n); }
-
-// Checks if the SocketIO event has JSON data.
-// If there is data the JSON object in string format will be returned,
-// else the empty string "" will be returned.
-std::string hasData(std::string s) {
-  auto found_null = s.find("null");
-  auto b1 = s.find_first_of("[");
-  auto b2 = s.find_last_of("]");
-  if (found_null != std::string::npos) {
-    return "";
-  } else if (b1 != std::string::npos && b2 != std::string::npos) {
-    return s.substr(b1, b2 - b1 + 1);
+
+struct LoopSettings {
+  // Number of event loops, each one on its own thread
+  unsigned int threads;
+  // Max number of sessions of each loop
+  unsigned int max_sessions;
+  // Pins each loop thread to a CPU
+  bool pin_cpus;
+  // Runs the controllers on a control thread of each loop rather than on the loop thread
+  bool pipeline;
+};
+
+// Frames that can be queued for the control thread of a loop (and replies back) in the pipelined mode
+#define PIPELINE_CAPACITY 256
+
+// Pipelined mode of a loop, owned by the loop thread and freed when its async handle is closed (see closePipeline)
+struct Pipeline {
+  ControlPipeline control;
+  // Connections of the active sessions of the loop, to send the replies of the control thread
+  std::vector<std::pair<Session *, uWS::WebSocket<uWS::SERVER>>> connections;
+  SteerEncoder *steer_encoder;
+  // Wakes up the loop when replies are queued
+  uv_async_t async;
+
+  Pipeline() : control(PIPELINE_CAPACITY), steer_encoder(nullptr) {}
+};
+
+// The reset is reported by the tuner events (written off the event loop)
+void reset_simulator(uWS::WebSocket<uWS::SERVER> &ws) {
+  ws.send(RESET_FRAME.data, RESET_FRAME.length, uWS::OpCode::TEXT);
+}
+
+// Pins the calling thread to the given CPU, returns false if not supported or failed
+bool pin_thread(unsigned int cpu) {
+#ifdef __linux__
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu, &cpu_set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+  return false;
+#endif
+}
+
+// Sends the replies queued by the control thread (loop thread)
+void sendReplies(uv_async_t *async) {
+  Pipeline *pipeline = static_cast<Pipeline *>(async->data);
+  ControlReply reply;
+
+  while (pipeline->control.Poll(reply)) {
+    auto connection = std::find_if(
+        pipeline->connections.begin(), pipeline->connections.end(),
+        [&reply](const std::pair<Session *, uWS::WebSocket<uWS::SERVER>> &c) { return c.first == reply.session; });
+    if (connection == pipeline->connections.end() || reply.session->Id() != reply.id) {
+      // The connection was closed since
+      continue;
+    }
+    if (reply.reset) {
+      reset_simulator(connection->second);
+    } else {
+      Frame msg = pipeline->steer_encoder->Encode(reply.actuation.steer_value, reply.actuation.throttle);
+      connection->second.send(msg.data, msg.length, uWS::OpCode::TEXT);
+    }
   }
-  return "";
 }
 
-void reset_simulator(uWS::WebSocket<uWS::SERVER> &ws) {
-  std::cout << "Resetting simulator" << std::endl;
-  std::string msg = "42[\"reset\",{}]";
-  ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
+void freePipeline(uv_handle_t *handle) { delete static_cast<Pipeline *>(handle->data); }
+
+// Stops the control thread and closes the async handle, the pipeline is freed by the loop once the handle is closed
+// (loop thread, once the sessions of the loop are released)
+void closePipeline(Pipeline *pipeline) {
+  pipeline->control.Stop();
+  uv_close(reinterpret_cast<uv_handle_t *>(&pipeline->async), freePipeline);
+}
+
+void onShutdownSignal(uv_signal_t *handle, int signum) { (*static_cast<std::function<void()> *>(handle->data))(); }
+
+// Merges the profilers of all the active sessions
+std::string profileSummary() {
+#ifdef PID_PROFILE
+  std::unique_ptr<StageProfiler> total(new StageProfiler());
+  SessionPool::ForEachSession([&total](Session &session) { total->Merge(*session.GetProfiler()); });
+  return total->Summary();
+#else
+  return "Profiling disabled, build with -DPID_PROFILE=ON\n";
+#endif
 }
 
-void runSimulation(double Kp, double Ki, double Kd, unsigned int max_steps) {
+// Runs an event loop (uWS hub) with its own sessions on the calling thread. With multiple loops every loop listens on
+// the same port (SO_REUSEPORT) and the kernel distributes the incoming connections.
+void runLoop(unsigned int loop_id, const SessionSettings &settings, const LoopSettings &loop_settings,
+             Metrics &metrics) {
   uWS::Hub h;
 
-  PID steering_pid;
+  SessionPool sessions(loop_id, loop_settings.max_sessions, settings);
 
-  std::vector<double> params = {Kp, Ki, Kd};
+  if (loop_settings.pin_cpus) {
+    unsigned int cpu = loop_id % std::max(1u, std::thread::hardware_concurrency());
+    if (!pin_thread(cpu)) {
+      std::cout << "[Warning]: Could not pin loop " << loop_id << " to CPU " << cpu << std::endl;
+    }
+  }
 
-  Tuner tuner = {params, max_steps};
+  SteerEncoder steer_encoder;
 
-  if (tuner.Enabled()) {
-    std::cout << "Tuning ENABLED" << std::endl;
-    tuner.PrintParams();
-    tuner.PrintParamsDelta();
+  Pipeline *pipeline = nullptr;
+
+  if (loop_settings.pipeline) {
+    pipeline = new Pipeline();
+    pipeline->steer_encoder = &steer_encoder;
+    pipeline->connections.reserve(loop_settings.max_sessions);
+    uv_async_init(h.getLoop(), &pipeline->async, sendReplies);
+    pipeline->async.data = pipeline;
+    uv_async_t *async = &pipeline->async;
+    pipeline->control.Start([async] { uv_async_send(async); });
   }
 
-  // Initializes the controller coefficients
-  steering_pid.Init(Kp, Ki, Kd);
+  bool stopping = false;
+
+  h.onMessage([&steer_encoder, &pipeline](uWS::WebSocket<uWS::SERVER> ws, char *data, size_t length,
+                                          uWS::OpCode opCode) {
+    Session *session = static_cast<Session *>(ws.getData());
 
-  std::ostringstream oss;
+    if (session == nullptr) {
+      return;
+    }
+
+#ifdef PID_PROFILE
+    // In the pipelined mode the frames are profiled by the control thread, a profiler has a single writer
+    StageProfiler *profiler = pipeline ? nullptr : session->GetProfiler();
+#endif
+
+    PROFILE_START(profiler);
+
+    SessionStats &stats = session->Stats();
+    Telemetry telemetry;
+    FrameType frame = DecodeFrame(data, length, telemetry);
+
+    if (frame == FrameType::UNKNOWN) {
+      // Event shape not handled by the fast decoder, fallback to the generic JSON parser
+      ++stats.fallback_frames;
+      try {
+        frame = DecodeFrameJson(data, length, telemetry);
+      } catch (const std::exception &e) {
+        ++stats.parse_errors;
+        frame = FrameType::INVALID;
+      }
+    }
 
-  oss << "cte_out_" << Kp << "_" << Ki << "_" << Kd << ".txt";
+    PROFILE_MARK(profiler, STAGE_DECODE);
+
+    if (frame == FrameType::MANUAL) {
+      // Manual driving
+      ++stats.manual_frames;
+      ws.send(MANUAL_FRAME.data, MANUAL_FRAME.length, uWS::OpCode::TEXT);
+      PROFILE_MARK(profiler, STAGE_SEND);
+    } else if (frame == FrameType::TELEMETRY && pipeline) {
+      // The reply is sent by sendReplies
+      pipeline->control.Submit({session, session->Id(), telemetry, std::chrono::steady_clock::now()});
+    } else if (frame == FrameType::TELEMETRY) {
+      Actuation actuation;
+
+      if (!session->Control(telemetry, session->FrameInterval(std::chrono::steady_clock::now()), actuation)) {
+        // End of a tuning cycle
+        reset_simulator(ws);
+        PROFILE_MARK(profiler, STAGE_SEND);
+        PROFILE_END(profiler);
+        session->CompleteCycle();
+        return;
+      }
 
-  std::string file_name = oss.str();
+      Frame msg = steer_encoder.Encode(actuation.steer_value, actuation.throttle);
 
-  std::ofstream file_out(file_name);
+      PROFILE_MARK(profiler, STAGE_ENCODE);
 
-  if (!file_out.is_open()) {
-    std::cout << "Could not open file" << file_name << " for writing" << std::endl;
-    exit(EXIT_FAILURE);
-  }
+      ws.send(msg.data, msg.length, uWS::OpCode::TEXT);
 
-  h.onMessage([&steering_pid, &file_out, &tuner, &max_steps](uWS::WebSocket<uWS::SERVER> ws, char *data, size_t length,
-                                                             uWS::OpCode opCode) {
-    // "42" at the start of the message means there's a websocket message event.
-    // The 4 signifies a websocket message
-    // The 2 signifies a websocket event
-    if (length && length > 2 && data[0] == '4' && data[1] == '2') {
-      auto s = hasData(std::string(data).substr(0, length));
-      if (s != "") {
-        auto j = json::parse(s);
-        std::string event = j[0].get<std::string>();
-        if (event == "telemetry") {
-          // j[1] is the data JSON object
-          double cte = std::stod(j[1]["cte"].get<std::string>());
-          double speed = std::stod(j[1]["speed"].get<std::string>());
-          double angle = std::stod(j[1]["steering_angle"].get<std::string>());
-
-          if (tuner.Enabled()) {
-            // Tune the parameters
-            std::vector<double> tuned_params = tuner.Tune(cte);
-
-            // Updates the parameters
-            steering_pid.Init(tuned_params[0], tuned_params[1], tuned_params[2]);
-
-            if (tuner.IsResetCycle()) {
-              reset_simulator(ws);
-              return;
-            }
-          }
-
-          // Updates the controller errors
-          steering_pid.UpdateError(cte);
-
-          // Gets the total error and uses it as the steering angle
-          double steer_value = steering_pid.TotalError();
-          // Clamp the value between 1 and -1
-          steer_value = clamp_steering(steer_value);
-
-          // Set throttle value according to steering value, the more the angle the less the throttle.
-          // Min throttle 0.1, max throttle 0.5
-          double throttle = (1 - fabs(steer_value)) * 0.4 + 0.1;
-
-          // DEBUG
-          if (!tuner.Enabled()) {
-            std::cout << "Current Speed: " << speed << ", Current Steering Angle: " << angle << std::endl;
-            std::cout << "CTE: " << cte << ", Steering Value: " << steer_value << " Throttle: " << throttle
-                      << std::endl;
-          }
-
-          json msgJson;
-          msgJson["steering_angle"] = steer_value;
-          msgJson["throttle"] = throttle;
-
-          // Writes output to file
-          file_out << speed << "\t";
-          file_out << angle << "\t";
-          file_out << cte << "\t";
-          file_out << steer_value << "\t";
-          file_out << throttle << std::endl;
-          file_out.flush();
-
-          auto msg = "42[\"steer\"," + msgJson.dump() + "]";
-          ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
-        }
-      } else {
-        // Manual driving
-        std::string msg = "42[\"manual\",{}]";
-        ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
-      }
+      PROFILE_MARK(profiler, STAGE_SEND);
     }
+
+    PROFILE_END(profiler);
   });
 
-  // We don't need this since we're not using HTTP but if it's removed the
-  // program doesn't compile :-(
-  h.onHttpRequest([](uWS::HttpResponse *res, uWS::HttpRequest req, char *data, size_t, size_t) {
+  // Serves the metrics (/metrics) and the stage profile (/profile)
+  h.onHttpRequest([&metrics](uWS::HttpResponse *res, uWS::HttpRequest req, char *data, size_t, size_t) {
     const std::string s = "<h1>Hello world!</h1>";
-    if (req.getUrl().valueLength == 1) {
+    const std::string url = req.getUrl().toString();
+    if (url == "/metrics") {
+      // Prometheus scrape
+      const std::string text = metrics.Render();
+      res->end(text.data(), text.length());
+    } else if (url == "/profile") {
+      // Per stage latency of the active sessions
+      const std::string profile = profileSummary();
+      res->end(profile.data(), profile.length());
+    } else if (req.getUrl().valueLength == 1) {
       res->end(s.data(), s.length());
     } else {
       // i guess this should be done more gracefully?
@@ -151,71 +226,347 @@ void runSimulation(double Kp, double Ki, double Kd, unsigned int max_steps) {
     }
   });
 
-  h.onConnection(
-      [&h](uWS::WebSocket<uWS::SERVER> ws, uWS::HttpRequest req) { std::cout << "Connected!!!" << std::endl; });
+  h.onConnection([&sessions, &pipeline](uWS::WebSocket<uWS::SERVER> ws, uWS::HttpRequest req) {
+    Session *session = sessions.Acquire();
 
-  h.onDisconnection([&h, &file_out](uWS::WebSocket<uWS::SERVER> ws, int code, char *message, size_t length) {
+    if (session == nullptr) {
+      std::cout << "Connection rejected, no session available (" << sessions.Active() << " active)" << std::endl;
+      ws.setData(nullptr);
+      ws.close();
+      return;
+    }
+
+    ws.setData(session);
+
+    if (pipeline) {
+      pipeline->connections.push_back(std::make_pair(session, ws));
+    }
+
+    std::cout << "Connected!!! (session " << session->Id() << ")" << std::endl;
+
+    Tuner &tuner = session->GetController().GetTuner();
+
+    if (tuner.Enabled()) {
+      tuner.Announce();
+    }
+  });
+
+  h.onDisconnection([&sessions, &pipeline, &stopping](uWS::WebSocket<uWS::SERVER> ws, int code, char *message,
+                                                      size_t length) {
+    Session *session = static_cast<Session *>(ws.getData());
+    ws.setData(nullptr);
     ws.close();
     std::cout << "Disconnected" << std::endl;
-    if (file_out.is_open()) {
-      file_out.close();
+    if (session != nullptr && pipeline) {
+      // The control thread must be done with the session before it is released, its pending replies are dropped
+      pipeline->control.Drain();
+      auto &connections = pipeline->connections;
+      connections.erase(std::remove_if(connections.begin(), connections.end(),
+                                       [session](const std::pair<Session *, uWS::WebSocket<uWS::SERVER>> &c) {
+                                         return c.first == session;
+                                       }),
+                        connections.end());
+    }
+    if (session != nullptr) {
+      session->PrintStats();
+      sessions.Release(session);
+    }
+    if (stopping && pipeline && sessions.Active() == 0) {
+      closePipeline(pipeline);
+      pipeline = nullptr;
     }
   });
 
+  // Graceful shutdown on SIGINT or SIGTERM (every loop is notified): the connections are closed and, once their
+  // sessions are released, the pipeline, so that the loop returns and the sessions flush their logs and checkpoints
+  uv_signal_t signals[2];
+  const int SIGNALS[] = {SIGINT, SIGTERM};
+
+  std::function<void()> shutdown = [&h, &sessions, &pipeline, &stopping, &signals]() {
+    stopping = true;
+    for (uv_signal_t &signal : signals) {
+      uv_close(reinterpret_cast<uv_handle_t *>(&signal), nullptr);
+    }
+    h.getDefaultGroup<uWS::SERVER>().close();
+    if (pipeline && sessions.Active() == 0) {
+      closePipeline(pipeline);
+      pipeline = nullptr;
+    }
+  };
+
+  for (unsigned int i = 0; i < 2; ++i) {
+    uv_signal_init(h.getLoop(), &signals[i]);
+    signals[i].data = &shutdown;
+    uv_signal_start(&signals[i], onShutdownSignal, SIGNALS[i]);
+  }
+
   int port = 4567;
-  if (h.listen(port)) {
-    std::cout << "Listening to port " << port << std::endl;
+  if (h.listen(port, nullptr, loop_settings.threads > 1 ? uS::REUSE_PORT : 0)) {
+    std::cout << "Listening to port " << port << " (loop " << loop_id << ")" << std::endl;
   } else {
     std::cerr << "Failed to listen to port" << std::endl;
-    if (file_out.is_open()) {
-      file_out.close();
-    }
     exit(EXIT_FAILURE);
   }
 
   h.run();
 }
 
+void runSimulation(const SessionSettings &settings, const LoopSettings &loop_settings) {
+  std::vector<std::thread> loops;
+  Metrics metrics;
+  StatusReporter status;
+
+  if (settings.status_interval > 0) {
+    status.Start(settings.status_interval);
+  }
+
+  for (unsigned int i = 1; i < loop_settings.threads; ++i) {
+    loops.push_back(std::thread(runLoop, i, std::cref(settings), std::cref(loop_settings), std::ref(metrics)));
+  }
+
+  runLoop(0, settings, loop_settings, metrics);
+
+  for (std::thread &loop : loops) {
+    loop.join();
+  }
+}
+
 int main(int argc, char *argv[]) {
   double Kp = 0.226576;
   double Ki = 0.00011891;
   double Kd = 4.455;
 
-  unsigned int max_steps = 0; // 4500 for entire lap
+  unsigned int max_steps = 0;  // 4500 for entire lap
 
-  if (argc > 1) {
-    if (argc < 4) {
-      std::cerr << "Number of required arguments does not match: requires 3, got: " << argc << std::endl;
+  LoggerSettings log_settings;
+
+  LoopSettings loop_settings = {1, 8, false, false};
+
+  // Profiling every frame costs about 8 clock reads per frame, sampling keeps the overhead negligible
+  unsigned int profile_period = 8;
+
+  EarlyAbort early_abort = EarlyAbort::OFF;
+
+  unsigned int max_repeats = 0;
+  double repeat_alpha = 0.05;
+
+  WarmupSettings warmup;
+
+  std::string resume_file;
+  std::string eval_db;
+
+  OptimizerType optimizer = OptimizerType::TWIDDLE;
+
+  ContinuousSettings continuous;
+
+  bool events = false;
+
+  // Redraw interval of the console status (ms)
+  unsigned int status_interval = 500;
+
+  std::vector<std::string> args;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    std::string value;
+    if (arg.compare(0, 2, "--") != 0) {
+      args.push_back(arg);
+    } else if (arg == "--log-sync") {
+      log_settings.durability = LogDurability::SYNC;
+    } else if (ReadOption(arg, "log-flush", value)) {
+      if (!ParseValue(value, log_settings.flush_interval)) {
+        std::cerr << "Could not read log flush interval: " << value << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (ReadOption(arg, "log-format", value)) {
+      if (value == "tsv") {
+        log_settings.format = LogFormat::TSV;
+      } else if (value == "binary") {
+        log_settings.format = LogFormat::BINARY;
+      } else {
+        std::cerr << "Unknown log format: " << value << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (arg == "--events") {
+      events = true;
+    } else if (arg == "--pin-cpus") {
+      loop_settings.pin_cpus = true;
+    } else if (arg == "--pipeline") {
+      loop_settings.pipeline = true;
+    } else if (ReadOption(arg, "threads", value)) {
+      if (!ParseValue(value, loop_settings.threads) || loop_settings.threads == 0) {
+        std::cerr << "Could not read number of threads: " << value << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (ReadOption(arg, "max-sessions", value)) {
+      if (!ParseValue(value, loop_settings.max_sessions) || loop_settings.max_sessions == 0) {
+        std::cerr << "Could not read max sessions: " << value << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (ReadOption(arg, "early-abort", value)) {
+      if (value == "off") {
+        early_abort = EarlyAbort::OFF;
+      } else if (value == "bound") {
+        early_abort = EarlyAbort::BOUND;
+      } else {
+        std::cerr << "Unknown early abort mode: " << value << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (ReadOption(arg, "repeats", value)) {
+      if (!ParseValue(value, max_repeats)) {
+        std::cerr << "Could not read max repeats: " << value << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (ReadOption(arg, "repeat-alpha", value)) {
+      if (!ParseValue(value, repeat_alpha) || repeat_alpha <= 0 || repeat_alpha >= 1) {
+        std::cerr << "Could not read repeat significance level: " << value << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (ReadOption(arg, "warmup", value)) {
+      if (value == "fixed" || value == "adaptive") {
+        warmup.adaptive = value == "adaptive";
+      } else {
+        std::cerr << "Unknown warmup mode: " << value << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (ReadOption(arg, "max-warmup", value)) {
+      if (!ParseValue(value, warmup.max_steps)) {
+        std::cerr << "Could not read max warmup steps: " << value << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (ReadOption(arg, "resume", value)) {
+      resume_file = value;
+    } else if (ReadOption(arg, "eval-db", value)) {
+      eval_db = value;
+    } else if (ReadOption(arg, "optimizer", value)) {
+      if (!ParseOptimizerType(value, optimizer)) {
+        std::cerr << "Unknown optimizer: " << value << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (ReadOption(arg, "continuous", value)) {
+      continuous.enabled = true;
+      if (!ParseValue(value, continuous.lap_length) || continuous.lap_length <= 0) {
+        std::cerr << "Could not read lap length: " << value << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (ReadOption(arg, "segment-length", value)) {
+      if (!ParseValue(value, continuous.segment_length) || continuous.segment_length <= 0) {
+        std::cerr << "Could not read segment length: " << value << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (ReadOption(arg, "settle-segments", value)) {
+      if (!ParseValue(value, continuous.settle_segments)) {
+        std::cerr << "Could not read settle segments: " << value << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (ReadOption(arg, "segments", value)) {
+      if (!ParseValue(value, continuous.scored_segments) || continuous.scored_segments == 0) {
+        std::cerr << "Could not read scored segments: " << value << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (ReadOption(arg, "max-cycles", value)) {
+      if (!ParseValue(value, continuous.max_cycles)) {
+        std::cerr << "Could not read max cycles: " << value << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (ReadOption(arg, "profile-period", value)) {
+      if (!ParseValue(value, profile_period) || profile_period == 0) {
+        std::cerr << "Could not read profile period: " << value << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (ReadOption(arg, "status", value)) {
+      if (!ParseValue(value, status_interval)) {
+        std::cerr << "Could not read status interval: " << value << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (ReadOption(arg, "log-capacity", value)) {
+      if (!ParseValue(value, log_settings.capacity) || log_settings.capacity == 0) {
+        std::cerr << "Could not read log capacity: " << value << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (args.size() > 0) {
+    if (args.size() < 3) {
+      std::cerr << "Number of required arguments does not match: requires 3, got: " << args.size() << std::endl;
       exit(EXIT_FAILURE);
     }
 
     std::istringstream iss;
 
-    iss.str(argv[1]);
+    iss.str(args[0]);
     if (!(iss >> Kp)) {
       std::cout << "Could not read Kp coefficient, using 0" << std::endl;
     }
     iss.clear();
-    iss.str(argv[2]);
+    iss.str(args[1]);
     if (!(iss >> Ki)) {
       std::cout << "Could not read Ki coefficient, using 0" << std::endl;
     }
     iss.clear();
-    iss.str(argv[3]);
+    iss.str(args[2]);
     if (!(iss >> Kd)) {
       std::cout << "Could not read Kd coefficient, using 0" << std::endl;
     }
 
-    if (argc > 4) {
+    if (args.size() > 3) {
       iss.clear();
-      iss.str(argv[4]);
+      iss.str(args[3]);
       if (!(iss >> max_steps)) {
         std::cout << "Could not read max_steps, Tuning DISABLED" << std::endl;
       }
     }
   }
 
+  TunerCheckpoint resume_state;
+
+  if (!resume_file.empty()) {
+    if (!ReadCheckpoint(resume_file, resume_state) || resume_state.best_params.size() != 3) {
+      std::cerr << "Could not read checkpoint: " << resume_file << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    // The cycles keep the same length unless given explicitly
+    if (max_steps == 0) {
+      max_steps = resume_state.max_steps;
+    }
+    std::cout << "Resuming tuning from " << resume_file << " at cycle " << resume_state.cycle
+              << ", best error: " << resume_state.best_err << std::endl;
+  }
+
+  if (continuous.enabled && max_steps == 0) {
+    std::cerr << "Continuous tuning requires max_steps" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (early_abort != EarlyAbort::OFF && !AcceptsLowerBounds(resume_file.empty() ? optimizer : resume_state.optimizer)) {
+    std::cerr << "--early-abort requires the twiddle optimizer" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
   std::cout << "Using PID cofficients: " << Kp << " " << Ki << " " << Kd << std::endl;
 
-  runSimulation(Kp, Ki, Kd, max_steps);
+  SessionSettings settings = {{Kp, Ki, Kd}, max_steps, log_settings, profile_period, early_abort,
+                              max_repeats, repeat_alpha, warmup, !resume_file.empty(), resume_state, eval_db,
+                              optimizer, continuous, events, status_interval};
+
+  // A new tuning would replace the checkpoint of the previous one
+  for (unsigned int i = 0; max_steps > 0 && resume_file.empty() && i < loop_settings.threads; ++i) {
+    std::string checkpoint_file = SessionPool::CheckpointFileName(settings.params, i);
+    if (access(checkpoint_file.c_str(), F_OK) == 0) {
+      std::cerr << "Checkpoint " << checkpoint_file << " exists, resume it with --resume=" << checkpoint_file
+                << " or remove it" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
+#ifdef PID_PROFILE
+  // Not on the event loop, the profile of the first scrape would wait for the calibration
+  CalibrateTicks();
+#endif
+
+  runSimulation(settings, loop_settings);
 }
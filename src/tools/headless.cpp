@@ -0,0 +1,416 @@
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../BatchTuner.h"
+#include "../Checkpoint.h"
+#include "../Controller.h"
+#include "../Evaluation.h"
+#include "../EventWriter.h"
+#include "../Options.h"
+#include "../Simulator.h"
+
+/*
+ * Runs the controller closed loop against the headless simulator, as fast as the CPU allows.
+ *
+ * Usage: pid_headless [Kp Ki Kd [max_steps]] [options]
+ *
+ * With max_steps > 0 the tuner is enabled and the simulation runs until the tuning is completed, otherwise a single
+ * lap is simulated (or the given number of steps).
+ *
+ * Options:
+ *   --track=<file>         Track centerline file ("x y" per line), the built-in track is used by default
+ *   --steps=<n>            Number of steps to simulate when tuning is disabled (default one lap)
+ *   --max-total-steps=<n>  Limit on the total number of simulated steps (default 100000000)
+ *   --dt=<s>               Simulation time step (default 0.02)
+ *   --delay=<n>            Actuation delay in steps (default 2)
+ *   --cte-noise=<m>        Standard deviation of the noise of the reported CTE (default 0)
+ *   --steer-noise=<rad>    Standard deviation of a random disturbance of the steering angle at each step (default 0)
+ *   --seed=<n>             Seed of the CTE and steering noise (default 1)
+ *   --threads=<n>          Tunes offline evaluating the candidates on n threads (0 uses all the cores) with the
+ *                          BatchTuner driving the optimizer. By default the Tuner is driven step by step as with
+ *                          the Udacity simulator. The cycles have a fixed warmup of --max-warmup steps, the options
+ *                          of the Tuner (early abort, repeats, adaptive warmup, checkpoint, events, resume,
+ *                          evaluation store and reset-free tuning) are rejected
+ *   --max-rounds=<n>       Max number of batches of the BatchTuner (default 1000)
+ *   --early-abort=<mode>   Early termination of the Tuner cycles that cannot improve: off (default) or bound
+ *   --repeats=<n>          Max repeated cycles to make an improvement of the Tuner significant (default 0)
+ *   --repeat-alpha=<a>     Significance level of the improvements (default 0.05)
+ *   --warmup=<mode>        Warmup of the Tuner cycles: fixed (default) or adaptive
+ *   --max-warmup=<n>       Max (or fixed) number of warmup steps (default 600)
+ *   --checkpoint=<file>    Writes a checkpoint of the Tuner at the end of every cycle
+ *   --events=<file>        Writes the events of the Tuner (cycles, comparisons, reports) to a JSON lines file
+ *   --resume=<file>        Resumes the Tuner from a checkpoint
+ *   --eval-db=<file>       Store of the evaluated coefficients, the Tuner cycles already evaluated are not run again
+ *   --optimizer=<name>     Optimizer of the tuning: twiddle (default), nelder-mead, cma-es,
+ *                          bayes-opt or halving
+ *   --population=<n>       Candidates of a CMA-ES generation of the BatchTuner (default 8)
+ *   --continuous           Reset-free tuning: the candidates are swapped at the segment boundaries of the lap and
+ *                          the simulator is only reset when the vehicle leaves the track
+ *   --segment-length=<m>   Length of the segments of the reset-free tuning (default 50)
+ *   --settle-segments=<n>  Segments driven by a candidate before it is scored (default 1)
+ *   --segments=<n>         Segments on which a candidate is scored (default 3)
+ *   --max-cycles=<n>       Max cycles of the reset-free tuning, 0 for no limit (default 1000)
+ */
+
+struct RunStats {
+  unsigned long steps;
+  double total_err;
+  double max_cte;
+  double total_speed;
+};
+
+int main(int argc, char *argv[]) {
+  double Kp = 0.226576;
+  double Ki = 0.00011891;
+  double Kd = 4.455;
+
+  unsigned int max_steps = 0;
+  unsigned long steps = 0;
+  unsigned long max_total_steps = 100000000;
+
+  int threads = -1;
+  unsigned int max_rounds = 1000;
+
+  EarlyAbort early_abort = EarlyAbort::OFF;
+  unsigned int max_repeats = 0;
+  double repeat_alpha = 0.05;
+  WarmupSettings warmup;
+
+  std::string checkpoint_file;
+  std::string events_file;
+  std::string resume_file;
+  std::string eval_db;
+  OptimizerType optimizer = OptimizerType::TWIDDLE;
+  unsigned int population = 0;
+  ContinuousSettings continuous;
+
+  std::string track_file;
+  SimulatorSettings settings;
+  std::vector<std::string> args;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    std::string value;
+    bool valid = true;
+    if (arg.compare(0, 2, "--") != 0) {
+      args.push_back(arg);
+    } else if (ReadOption(arg, "track", value)) {
+      track_file = value;
+    } else if (ReadOption(arg, "steps", value)) {
+      valid = ParseValue(value, steps);
+    } else if (ReadOption(arg, "max-total-steps", value)) {
+      valid = ParseValue(value, max_total_steps);
+    } else if (ReadOption(arg, "dt", value)) {
+      valid = ParseValue(value, settings.dt) && settings.dt > 0;
+    } else if (ReadOption(arg, "delay", value)) {
+      valid = ParseValue(value, settings.delay);
+    } else if (ReadOption(arg, "cte-noise", value)) {
+      valid = ParseValue(value, settings.cte_noise) && settings.cte_noise >= 0;
+    } else if (ReadOption(arg, "steer-noise", value)) {
+      valid = ParseValue(value, settings.steer_noise) && settings.steer_noise >= 0;
+    } else if (ReadOption(arg, "seed", value)) {
+      valid = ParseValue(value, settings.seed);
+    } else if (ReadOption(arg, "threads", value)) {
+      valid = ParseValue(value, threads) && threads >= 0;
+    } else if (ReadOption(arg, "max-rounds", value)) {
+      valid = ParseValue(value, max_rounds);
+    } else if (ReadOption(arg, "early-abort", value)) {
+      if (value == "off") {
+        early_abort = EarlyAbort::OFF;
+      } else if (value == "bound") {
+        early_abort = EarlyAbort::BOUND;
+      } else {
+        valid = false;
+      }
+    } else if (ReadOption(arg, "repeats", value)) {
+      valid = ParseValue(value, max_repeats);
+    } else if (ReadOption(arg, "repeat-alpha", value)) {
+      valid = ParseValue(value, repeat_alpha) && repeat_alpha > 0 && repeat_alpha < 1;
+    } else if (ReadOption(arg, "warmup", value)) {
+      valid = value == "fixed" || value == "adaptive";
+      warmup.adaptive = value == "adaptive";
+    } else if (ReadOption(arg, "max-warmup", value)) {
+      valid = ParseValue(value, warmup.max_steps);
+    } else if (ReadOption(arg, "checkpoint", value)) {
+      checkpoint_file = value;
+    } else if (ReadOption(arg, "events", value)) {
+      events_file = value;
+    } else if (ReadOption(arg, "resume", value)) {
+      resume_file = value;
+    } else if (ReadOption(arg, "eval-db", value)) {
+      eval_db = value;
+    } else if (ReadOption(arg, "optimizer", value)) {
+      valid = ParseOptimizerType(value, optimizer);
+    } else if (ReadOption(arg, "population", value)) {
+      valid = ParseValue(value, population) && population >= 2;
+    } else if (arg == "--continuous") {
+      continuous.enabled = true;
+    } else if (ReadOption(arg, "segment-length", value)) {
+      valid = ParseValue(value, continuous.segment_length) && continuous.segment_length > 0;
+    } else if (ReadOption(arg, "settle-segments", value)) {
+      valid = ParseValue(value, continuous.settle_segments);
+    } else if (ReadOption(arg, "segments", value)) {
+      valid = ParseValue(value, continuous.scored_segments) && continuous.scored_segments > 0;
+    } else if (ReadOption(arg, "max-cycles", value)) {
+      valid = ParseValue(value, continuous.max_cycles);
+    } else {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (!valid) {
+      std::cerr << "Invalid value for option: " << arg << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (args.size() > 0) {
+    if (args.size() < 3 || !ParseValue(args[0], Kp) || !ParseValue(args[1], Ki) || !ParseValue(args[2], Kd) ||
+        (args.size() > 3 && !ParseValue(args[3], max_steps))) {
+      std::cerr << "Usage: " << argv[0] << " [Kp Ki Kd [max_steps]] [options]" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (threads >= 0) {
+    // The BatchTuner evaluates full cycles on its own simulators, without the Tuner
+    std::string unsupported;
+    if (early_abort != EarlyAbort::OFF) {
+      unsupported = "--early-abort";
+    } else if (max_repeats > 0) {
+      unsupported = "--repeats";
+    } else if (warmup.adaptive) {
+      unsupported = "--warmup=adaptive";
+    } else if (!checkpoint_file.empty()) {
+      unsupported = "--checkpoint";
+    } else if (!events_file.empty()) {
+      unsupported = "--events";
+    } else if (!resume_file.empty()) {
+      unsupported = "--resume";
+    } else if (!eval_db.empty()) {
+      unsupported = "--eval-db";
+    } else if (continuous.enabled) {
+      unsupported = "--continuous";
+    }
+    if (!unsupported.empty()) {
+      std::cerr << unsupported << " is not supported with --threads" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  Track track = Track::Default();
+
+  if (!track_file.empty() && !track.Load(track_file)) {
+    std::cerr << "Could not load track " << track_file << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  TunerCheckpoint checkpoint;
+
+  if (!resume_file.empty()) {
+    if (!ReadCheckpoint(resume_file, checkpoint)) {
+      std::cerr << "Could not read checkpoint " << resume_file << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (max_steps == 0) {
+      max_steps = checkpoint.max_steps;
+    }
+  }
+
+  std::cout << "Track length: " << track.Length() << " m (" << track.Size() << " points)" << std::endl;
+  std::cout << "Using PID cofficients: " << Kp << " " << Ki << " " << Kd << std::endl;
+
+  std::vector<double> params = {Kp, Ki, Kd};
+
+  if (max_steps > 0 && threads >= 0) {
+    if (threads == 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    unsigned int warmup_steps = warmup.max_steps;
+
+    Evaluator evaluator = [&track, &settings, max_steps, warmup_steps](const std::vector<double> &candidate,
+                                                                       double fidelity) {
+      return EvaluateCycle(track, settings, candidate, FidelitySteps(max_steps, fidelity), warmup_steps);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::cout << "Batch tuning (" << OptimizerName(optimizer) << ") on " << threads << " threads" << std::endl;
+
+    BatchTuner batch_tuner(CreateOptimizer(optimizer, params, population), evaluator, threads);
+
+    std::vector<double> best_params = batch_tuner.Tune(max_rounds);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::endl;
+    std::cout << std::setw(20) << "Batches: " << batch_tuner.Batches() << std::endl;
+    std::cout << std::setw(20) << "Evaluations: " << batch_tuner.Evaluations() << std::endl;
+    std::cout << std::setw(20) << "Converged: " << (batch_tuner.IsTuned() ? "yes" : "no") << std::endl;
+    std::cout << std::setw(20) << "Best error: " << batch_tuner.BestError() << std::endl;
+    std::cout << std::setw(20) << "Best params: " << best_params[0] << " " << best_params[1] << " "
+              << best_params[2] << std::endl;
+    std::cout << std::setw(20) << "Elapsed (s): " << elapsed << std::endl;
+    std::cout << std::setw(20) << "Evaluations/s: " << batch_tuner.Evaluations() / elapsed << std::endl;
+    std::cout << std::setw(20) << "Batch size: " << batch_tuner.MaxBatchSize() << std::endl;
+    std::cout << std::setw(20) << "Batch time (s): " << elapsed / batch_tuner.Batches() << std::endl;
+
+    return EXIT_SUCCESS;
+  }
+
+  if (early_abort != EarlyAbort::OFF && !AcceptsLowerBounds(resume_file.empty() ? optimizer : checkpoint.optimizer)) {
+    std::cerr << "--early-abort requires the twiddle optimizer" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  Controller controller(params, max_steps);
+  Tuner &tuner = controller.GetTuner();
+  Simulator simulator(track, settings);
+
+  tuner.SetOptimizer(optimizer);
+  tuner.SetEarlyAbort(early_abort);
+  tuner.SetRepeats(max_repeats, repeat_alpha);
+  tuner.SetWarmup(warmup);
+
+  if (continuous.enabled) {
+    continuous.lap_length = track.Length();
+    tuner.SetContinuous(continuous);
+  }
+
+  if (!resume_file.empty()) {
+    if (!tuner.Restore(checkpoint)) {
+      std::cerr << "The checkpoint does not match the tuner" << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::cout << "Resuming from cycle " << tuner.Cycle() << ", best error: " << tuner.BestError() << std::endl;
+  }
+
+  EvalStore store;
+
+  if (!eval_db.empty()) {
+    if (!store.Open(eval_db)) {
+      std::cerr << "Could not open evaluation store " << eval_db << std::endl;
+      return EXIT_FAILURE;
+    }
+    // Everything that changes the outcome of a cycle on the headless simulator
+    std::ostringstream plant;
+    plant << std::setprecision(17) << "headless;track=" << (track_file.empty() ? "default" : track_file) << ","
+          << track.Length() << "," << track.Size() << ";dt=" << settings.dt << ";wheel_base=" << settings.wheel_base
+          << ";max_steer=" << settings.max_steer << ";steer_rate=" << settings.steer_rate
+          << ";max_accel=" << settings.max_accel << ";drag=" << settings.drag << ";rolling=" << settings.rolling
+          << ";delay=" << settings.delay << ";off_track=" << settings.off_track << ";cte_noise=" << settings.cte_noise
+          << ";steer_noise=" << settings.steer_noise << ";seed=" << settings.seed;
+    tuner.SetEvalStore(&store, plant.str());
+    std::cout << "Evaluation store: " << store.Size() << " evaluations" << std::endl;
+  }
+
+  CheckpointWriter checkpoint_writer;
+
+  if (!checkpoint_file.empty()) {
+    checkpoint_writer.Open(checkpoint_file);
+  }
+
+  EventWriter event_writer;
+
+  if (!events_file.empty()) {
+    if (!event_writer.Open(events_file, true)) {
+      std::cerr << "Could not open events file " << events_file << std::endl;
+      return EXIT_FAILURE;
+    }
+    tuner.SetEventSink(&event_writer);
+  }
+
+  RunStats stats = {0, 0.0, 0.0, 0.0};
+  unsigned long cycles = 0;
+  unsigned long resets = 0;
+  bool tuning = tuner.Enabled();
+
+  auto start = std::chrono::steady_clock::now();
+
+  while (stats.steps < max_total_steps) {
+    Telemetry telemetry = simulator.GetTelemetry();
+    Actuation actuation;
+    unsigned int cycle = tuner.Cycle();
+
+    bool updated = controller.Update(telemetry.cte, telemetry.speed, settings.dt, actuation);
+
+    if (tuner.Cycle() != cycle || !updated) {
+      // End of a tuning cycle, the reset of the headless simulator does not take any time
+      tuner.CompleteCycle();
+      if (checkpoint_writer.IsOpen()) {
+        tuner.GetCheckpoint(checkpoint);
+        checkpoint_writer.Write(checkpoint);
+      }
+      ++cycles;
+    }
+
+    if (!updated) {
+      simulator.Reset();
+      ++resets;
+      continue;
+    }
+
+    if (tuning) {
+      if (!tuner.Enabled()) {
+        break;
+      }
+    } else {
+      if (simulator.OffTrack()) {
+        std::cout << "Vehicle off track at step " << stats.steps << std::endl;
+        break;
+      }
+      if (steps > 0 ? stats.steps >= steps : simulator.Distance() >= track.Length()) {
+        break;
+      }
+    }
+
+    simulator.Step(actuation.steer_value, actuation.throttle);
+
+    ++stats.steps;
+    stats.total_err += telemetry.cte * telemetry.cte;
+    stats.max_cte = fmax(stats.max_cte, fabs(telemetry.cte));
+    stats.total_speed += telemetry.speed;
+  }
+
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  // Prints the pending events before the summary
+  event_writer.Close();
+  event_writer.Wait();
+
+  std::cout << std::endl;
+  std::cout << std::setw(20) << "Steps: " << stats.steps << std::endl;
+
+  if (tuning) {
+    std::vector<double> best_params = tuner.BestParams();
+    std::cout << std::setw(20) << "Cycles: " << cycles << std::endl;
+    std::cout << std::setw(20) << "Resets: " << resets << std::endl;
+    std::cout << std::setw(20) << "Aborted cycles: " << tuner.AbortedCycles() << std::endl;
+    std::cout << std::setw(20) << "Steps saved: " << tuner.StepsSaved() << std::endl;
+    std::cout << std::setw(20) << "Cached cycles: " << tuner.CachedCycles() << std::endl;
+    std::cout << std::setw(20) << "Repeated cycles: " << tuner.RepeatedCycles() << std::endl;
+    std::cout << std::setw(20) << "Best error: " << tuner.BestError() << std::endl;
+    std::cout << std::setw(20) << "Best params: " << best_params[0] << " " << best_params[1] << " "
+              << best_params[2] << std::endl;
+    std::cout << std::setw(20) << "Average warmup: " << tuner.AverageWarmup() << std::endl;
+    std::cout << std::setw(20) << "Cycles/s: " << cycles / elapsed << std::endl;
+    // Cycles per hour with a simulator running in real time
+    std::cout << std::setw(20) << "Cycles/hour (sim): " << cycles / (stats.steps * settings.dt / 3600.0) << std::endl;
+  } else {
+    std::cout << std::setw(20) << "Distance (m): " << simulator.Distance() << std::endl;
+    std::cout << std::setw(20) << "Avg squared CTE: " << stats.total_err / fmax(1, stats.steps) << std::endl;
+    std::cout << std::setw(20) << "Max CTE: " << stats.max_cte << std::endl;
+    std::cout << std::setw(20) << "Avg speed (mph): " << stats.total_speed / fmax(1, stats.steps) << std::endl;
+  }
+
+  std::cout << std::setw(20) << "Elapsed (s): " << elapsed << std::endl;
+  std::cout << std::setw(20) << "Steps/s: " << stats.steps / elapsed << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "../LogFormat.h"
+#include "../LogReader.h"
+
+/*
+ * Converts a binary log into the tab separated layout (speed, angle, cte, steering value and throttle), so that it
+ * can be loaded by the visualization notebook.
+ *
+ * Usage: pid_log2tsv <input.bin> [output.txt]
+ *
+ * When the output is omitted the TSV is written to the standard output. The log header and cycle boundaries are
+ * printed to the standard error.
+ */
+
+#define BATCH_SIZE 65536
+
+static bool write_all(int fd, const std::vector<char> &data) {
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t result = write(fd, data.data() + written, data.size() - written);
+    if (result < 0) {
+      return false;
+    }
+    written += result;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <input.bin> [output.txt]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  BinaryLogReader reader;
+
+  if (!reader.Open(argv[1])) {
+    std::cerr << "Could not read binary log " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  int fd = STDOUT_FILENO;
+
+  if (argc > 2) {
+    fd = open(argv[2], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      std::cerr << "Could not open file " << argv[2] << " for writing" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::vector<double> gains = reader.Gains();
+
+  std::cerr << "Gains: " << gains[0] << " " << gains[1] << " " << gains[2] << std::endl;
+  std::cerr << "Records: " << reader.Records() << std::endl;
+
+  for (const LogCycle &cycle : reader.Cycles()) {
+    std::cerr << "Cycle " << cycle.cycle << ": records " << cycle.offset << " - " << (cycle.offset + cycle.count)
+              << std::endl;
+  }
+
+  TsvLogEncoder encoder;
+  std::vector<char> batch;
+  batch.reserve(BATCH_SIZE);
+
+  bool success = true;
+
+  for (size_t block = 0; block < reader.Blocks().size() && success; ++block) {
+    for (size_t i = 0; i < reader.Blocks()[block].count; ++i) {
+      encoder.Append(reader.Record(block, i), batch);
+      if (batch.size() >= BATCH_SIZE) {
+        success = write_all(fd, batch);
+        batch.clear();
+      }
+    }
+  }
+
+  success = success && write_all(fd, batch);
+
+  if (fd != STDOUT_FILENO) {
+    close(fd);
+  }
+
+  if (!success) {
+    std::cerr << "Could not write the output" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,223 @@
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../Controller.h"
+#include "../LogReader.h"
+#include "../Options.h"
+
+/*
+ * Replays a recorded telemetry log (TSV or binary) through the controller, feeding the recorded cross track errors
+ * to the PID and comparing the computed steering value and throttle with the recorded ones. The log is streamed
+ * with constant memory usage so that arbitrarily long logs can be replayed.
+ *
+ * Usage: pid_replay <log> [Kp Ki Kd] [options]
+ *
+ * The coefficients default to the ones stored in the binary log header, or to the ones in the log file name
+ * (cte_out_<Kp>_<Ki>_<Kd>.txt). Note that only logs recorded with tuning disabled can be replayed exactly, since the
+ * coefficients change during tuning.
+ *
+ * Options:
+ *   --tolerance=<x>  Exits with a failure status if the steering or throttle divergence exceeds the given value
+ *   --limit=<n>      Replays at most n records
+ *   --verbose        Prints each record that diverges more than the tolerance
+ */
+
+// Extracts the coefficients from a log file name (e.g. cte_out_0.2_0.0001_4.5.txt)
+static bool gains_from_name(const std::string &file_name, std::vector<double> &gains) {
+  const std::string prefix = "cte_out_";
+  size_t start = file_name.rfind(prefix);
+  if (start == std::string::npos) {
+    return false;
+  }
+  start += prefix.size();
+  size_t stop = file_name.rfind('.');
+  if (stop == std::string::npos || stop < start) {
+    return false;
+  }
+  std::vector<double> values;
+  std::string name = file_name.substr(start, stop - start);
+  size_t pos = 0;
+  while (values.size() < 3) {
+    size_t next = name.find('_', pos);
+    double value;
+    if (!ParseValue(name.substr(pos, next == std::string::npos ? std::string::npos : next - pos), value)) {
+      return false;
+    }
+    values.push_back(value);
+    if (next == std::string::npos) {
+      break;
+    }
+    pos = next + 1;
+  }
+  if (values.size() != 3) {
+    return false;
+  }
+  gains = values;
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  std::string file_name;
+  std::vector<double> gains;
+  std::vector<std::string> positional;
+
+  double tolerance = -1.0;
+  unsigned long limit = 0;
+  bool verbose = false;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string value;
+    if (ReadOption(argv[i], "tolerance", value)) {
+      if (!ParseValue(value, tolerance) || tolerance < 0) {
+        std::cerr << "Invalid tolerance: " << value << std::endl;
+        return EXIT_FAILURE;
+      }
+    } else if (ReadOption(argv[i], "limit", value)) {
+      if (!ParseValue(value, limit)) {
+        std::cerr << "Invalid limit: " << value << std::endl;
+        return EXIT_FAILURE;
+      }
+    } else if (std::string(argv[i]) == "--verbose") {
+      verbose = true;
+    } else if (std::string(argv[i]).compare(0, 2, "--") == 0) {
+      std::cerr << "Unknown option: " << argv[i] << std::endl;
+      return EXIT_FAILURE;
+    } else {
+      positional.push_back(argv[i]);
+    }
+  }
+
+  if (positional.size() != 1 && positional.size() != 4) {
+    std::cerr << "Usage: " << argv[0] << " <log> [Kp Ki Kd] [--tolerance=<x>] [--limit=<n>] [--verbose]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  file_name = positional[0];
+
+  for (size_t i = 1; i < positional.size(); ++i) {
+    double value;
+    if (!ParseValue(positional[i], value)) {
+      std::cerr << "Invalid coefficient: " << positional[i] << std::endl;
+      return EXIT_FAILURE;
+    }
+    gains.push_back(value);
+  }
+
+  // Binary logs are recognized by their header, anything else is read as TSV
+  std::unique_ptr<LogStream> stream(new BinaryLogStream());
+
+  if (!stream->Open(file_name)) {
+    stream.reset(new TsvLogStream());
+    if (!stream->Open(file_name)) {
+      std::cerr << "Could not read log " << file_name << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (gains.empty()) {
+    gains = stream->Gains();
+  }
+
+  if (gains.empty() && !gains_from_name(file_name, gains)) {
+    std::cerr << "The coefficients are not stored in the log, Kp Ki Kd are required" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << std::setprecision(10);
+  std::cout << "Replaying " << file_name << " with Kp: " << gains[0] << ", Ki: " << gains[1] << ", Kd: " << gains[2]
+            << std::endl;
+
+  Controller controller(gains, 0);
+
+  unsigned long records = 0;
+  unsigned long diverging = 0;
+  double max_steer_diff = 0.0;
+  double max_throttle_diff = 0.0;
+  double total_steer_diff = 0.0;
+  unsigned long max_steer_record = 0;
+  long long update_ns = 0;
+  long long max_update_ns = 0;
+
+  auto start = std::chrono::steady_clock::now();
+
+  LogRecord record;
+  int64_t last_timestamp = 0;
+
+  while ((limit == 0 || records < limit) && stream->Next(record)) {
+    Actuation actuation;
+    // The TSV logs have no timestamps
+    double dt = NAN;
+    if (last_timestamp > 0 && record.timestamp > last_timestamp) {
+      dt = (record.timestamp - last_timestamp) * 1e-9;
+    }
+    last_timestamp = record.timestamp;
+
+    auto update_start = std::chrono::steady_clock::now();
+    controller.Update(record.cte, record.speed, dt, actuation);
+    auto update_end = std::chrono::steady_clock::now();
+
+    long long elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(update_end - update_start).count();
+    update_ns += elapsed;
+    max_update_ns = std::max(max_update_ns, elapsed);
+
+    double steer_diff = fabs(actuation.steer_value - record.steer_value);
+    double throttle_diff = fabs(actuation.throttle - record.throttle);
+
+    total_steer_diff += steer_diff;
+
+    if (steer_diff > max_steer_diff) {
+      max_steer_diff = steer_diff;
+      max_steer_record = records;
+    }
+
+    max_throttle_diff = std::max(max_throttle_diff, throttle_diff);
+
+    if (tolerance >= 0 && (steer_diff > tolerance || throttle_diff > tolerance)) {
+      ++diverging;
+      if (verbose) {
+        std::cout << "Record " << records << ": CTE " << record.cte << ", steering " << actuation.steer_value
+                  << " (recorded " << record.steer_value << "), throttle " << actuation.throttle << " (recorded "
+                  << record.throttle << ")" << std::endl;
+      }
+    }
+
+    ++records;
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(end - start).count();
+
+  if (stream->Failed()) {
+    std::cerr << "Malformed log " << file_name << " after " << records << " records" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (records == 0) {
+    std::cerr << "No records found in " << file_name << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Records:              " << records << std::endl;
+  std::cout << "Max steer divergence: " << max_steer_diff << " (record " << max_steer_record << ")" << std::endl;
+  std::cout << "Avg steer divergence: " << total_steer_diff / records << std::endl;
+  std::cout << "Max throttle div.:    " << max_throttle_diff << std::endl;
+  std::cout << std::setprecision(4);
+  std::cout << "Update time:          " << static_cast<double>(update_ns) / records << " ns/frame (max "
+            << max_update_ns << " ns)" << std::endl;
+  std::cout << "Replay rate:          " << records / seconds << " frames/s" << std::endl;
+
+  if (tolerance >= 0) {
+    std::cout << "Diverging records:    " << diverging << " (tolerance " << tolerance << ")" << std::endl;
+    if (diverging > 0) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}